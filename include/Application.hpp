@@ -1,7 +1,10 @@
 #ifndef APPLICATION_HPP
 #define APPLICATION_HPP
+#include <cstdint>
 #include <string>
 
+#include "MappedFile.hpp"
+
 
 class Application
 {
@@ -10,25 +13,43 @@ private:
     {
         enum class Mode
         {
-            NONE, MINIFY, RENDER, HELP
+            NONE, MINIFY, BATCH, RENDER, BENCH, VARIANTS, HELP
         };
 
         Mode mode{Mode::NONE};
-        std::string inputPath;
-        std::string outputPath;
+        std::string inputPath; // minify-batch, a directory, a pattern or a manifest
+        std::string outputPath; // minify-batch, the root the outputs are mirrored under
+        std::string definesPath; // variants mode, one define set per line
         bool verify{false};
         bool showDeadCode{false};
+        bool removeDeadCode{false};
+        bool foldConstants{false};
+        bool stream{false};
+        bool rename{true};
+        bool watch{false};
+        bool minified{false}; // render mode, show the minified shader
+        int iterations{10};
+        unsigned threads{1}; // minify-batch, the files minified at once, 0 is one per core
+        int maxErrors{100};
+        int searchMs{0}; // minify, 0 is no search
+        int searchSteps{0};
+        uint32_t seed{0};
     };
 
     Config m_Config;
 
     void runMinifier();
+    bool runBatch(); // false if a file failed
+    void runStreamMinifier();
+    void runWatch();
     void runRenderer();
+    void runBenchmark();
+    void runVariants();
     void showHelp() const;
 
     bool parseCommandLine(int argc, char* argv[]);
 
-    static std::string readFile(const std::string& path);
+    static MappedFile readFile(const std::string& path);
     static void writeFile(const std::string& path, const std::string& content);
 
 public:
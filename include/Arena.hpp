@@ -0,0 +1,48 @@
+#ifndef ARENA_HPP
+#define ARENA_HPP
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+
+// bump allocator for state that lives as long as one shader, for std::pmr containers
+// freeing only gives memory back if it was the last allocation, everything else waits for reset()
+// reset() keeps the memory, merged into one block as big as everything before it, so a pipeline that is reset
+// between shaders stops allocating once it has seen its biggest one
+class Arena : public std::pmr::memory_resource
+{
+private:
+    struct Block
+    {
+        std::unique_ptr<std::byte[]> data;
+        std::size_t size;
+    };
+
+    std::vector<Block> m_Blocks; // the last one is being filled
+    std::size_t m_Used{0}; // of the last block
+    std::size_t m_Allocated{0}; // since the last reset
+
+    void addBlock(std::size_t size);
+
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+    void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+public:
+    static constexpr std::size_t MIN_BLOCK_SIZE{64 * 1024};
+
+    Arena() = default;
+
+    // everything allocated from it is gone, containers using it have to be dropped first
+    void reset();
+
+    inline std::size_t getAllocated() const { return m_Allocated; }
+    std::size_t getCapacity() const;
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+};
+
+
+#endif //ARENA_HPP
@@ -0,0 +1,132 @@
+#ifndef AST_HPP
+#define AST_HPP
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+#include "Arena.hpp"
+
+
+// what a node is, and what its token, type and children are
+enum class NodeKind : uint8_t
+{
+    // top level, and declarations inside functions
+    TRANSLATION_UNIT, // children are the top level items
+    // token is the name, type the return type, children the ARRAY_SIZEs of the return type, the PARAMETERs and the
+    // BLOCK body if it is not a prototype
+    FUNCTION,
+    PARAMETER, // token is the name (NO_TOKEN if unnamed), type its type, children its ARRAY_SIZEs
+    // type is the type (NO_TOKEN for layout(..) in; or invariant x;), children a STRUCT if it defines one, the
+    // ARRAY_SIZEs of the type and the DECLARATORs
+    DECLARATION,
+    DECLARATOR, // token is the name, children its ARRAY_SIZEs and then the initializer, if any
+    // a struct or an interface block, token is the name (NO_TOKEN if anonymous), children the member DECLARATIONs
+    STRUCT,
+    ARRAY_SIZE, // [N] or [], child is the size if there is one
+    INITIALIZER_LIST, // { a, b }, children are the elements
+    PRECISION, // precision highp float; with the type as type
+    PREPROCESSOR, // a # line between items or statements, # lines anywhere else are only in the token ranges
+
+    // statements
+    BLOCK, EXPRESSION_STATEMENT,
+    IF, // condition, then, else if there is one
+    FOR, // init statement, condition, step and body, missing parts are EMPTY
+    WHILE, // condition, body
+    DO, // body, condition
+    SWITCH, // the expression, then the BLOCK with CASE and DEFAULT labels among its statements
+    CASE, DEFAULT,
+    RETURN, BREAK, CONTINUE, DISCARD, EMPTY,
+
+    // expressions, the token is the operator unless said otherwise
+    NAME, // token is the identifier
+    LITERAL, // token is the number or true/false
+    GROUP, // ( expression )
+    UNARY, POSTFIX,
+    BINARY, // ^^ is a CARET token followed by another one
+    ASSIGNMENT, // %= &= |= ^= <<= >>= are the operator token followed by EQUAL
+    TERNARY, // condition, then, else, token is the '?'
+    SEQUENCE, // a, b with the comma as token
+    CALL, // token is the function, struct or builtin type called, children the arguments
+    // (an ARRAY_SIZE first for float[2](..)), for x.length() the first child is x
+    MEMBER, // token is the field or swizzle name, child is the object
+    INDEX, // object, index
+
+    ERROR // tokens the parser could not make sense of, no children
+};
+
+// qualifiers of a FUNCTION, PARAMETER or DECLARATION
+enum NodeFlag : uint16_t
+{
+    FLAG_CONST = 1 << 0,
+    FLAG_UNIFORM = 1 << 1,
+    FLAG_IN = 1 << 2,
+    FLAG_OUT = 1 << 3, // inout sets both
+    FLAG_ATTRIBUTE = 1 << 4,
+    FLAG_VARYING = 1 << 5,
+    FLAG_BUFFER = 1 << 6,
+    FLAG_SHARED = 1 << 7,
+    FLAG_LAYOUT = 1 << 8,
+    FLAG_PRECISION = 1 << 9, // highp, mediump or lowp
+    FLAG_OTHER_QUALIFIER = 1 << 10, // interpolation, invariant, memory qualifiers..
+    FLAG_METHOD = 1 << 11 // a CALL like x.length()
+};
+
+// syntax tree with its nodes stored as parallel arrays in one arena, children are linked by index
+// every node covers the token range [begin, end), and ranges of siblings do not overlap
+class Ast
+{
+private:
+    Arena m_Arena;
+    std::pmr::vector<NodeKind> m_Kinds{&m_Arena};
+    std::pmr::vector<uint16_t> m_Flags{&m_Arena};
+    std::pmr::vector<uint32_t> m_Tokens{&m_Arena};
+    std::pmr::vector<uint32_t> m_Types{&m_Arena};
+    std::pmr::vector<uint32_t> m_Begins{&m_Arena};
+    std::pmr::vector<uint32_t> m_Ends{&m_Arena};
+    std::pmr::vector<uint32_t> m_FirstChildren{&m_Arena};
+    std::pmr::vector<uint32_t> m_LastChildren{&m_Arena};
+    std::pmr::vector<uint32_t> m_NextSiblings{&m_Arena};
+
+public:
+    static constexpr uint32_t NO_NODE{UINT32_MAX};
+    static constexpr uint32_t NO_TOKEN{UINT32_MAX};
+
+    Ast() = default;
+
+    void reserve(std::size_t nodes);
+    void clear(); // keeps the memory for the next shader
+
+    uint32_t add(NodeKind kind, uint32_t token, uint32_t begin);
+    void addChild(uint32_t parent, uint32_t child);
+    void dropChildren(uint32_t node);
+
+    inline void setKind(uint32_t node, NodeKind kind) { m_Kinds[node] = kind; }
+    inline void setToken(uint32_t node, uint32_t token) { m_Tokens[node] = token; }
+    inline void setFlags(uint32_t node, uint16_t flags) { m_Flags[node] = flags; }
+    inline void setType(uint32_t node, uint32_t type) { m_Types[node] = type; }
+    inline void setBegin(uint32_t node, uint32_t begin) { m_Begins[node] = begin; }
+    inline void setEnd(uint32_t node, uint32_t end) { m_Ends[node] = end; }
+
+    inline std::size_t size() const { return m_Kinds.size(); }
+    inline NodeKind kind(uint32_t node) const { return m_Kinds[node]; }
+    inline uint16_t flags(uint32_t node) const { return m_Flags[node]; }
+    inline uint32_t token(uint32_t node) const { return m_Tokens[node]; }
+    inline uint32_t type(uint32_t node) const { return m_Types[node]; }
+    inline uint32_t begin(uint32_t node) const { return m_Begins[node]; }
+    inline uint32_t end(uint32_t node) const { return m_Ends[node]; }
+    inline uint32_t firstChild(uint32_t node) const { return m_FirstChildren[node]; }
+    inline uint32_t nextSibling(uint32_t node) const { return m_NextSiblings[node]; }
+
+    std::size_t childCount(uint32_t node) const;
+    uint32_t child(uint32_t node, std::size_t index) const; // NO_NODE past the last one
+
+    // bytes per node, all arrays together
+    static constexpr std::size_t NODE_SIZE{sizeof(NodeKind) + sizeof(uint16_t) + 7 * sizeof(uint32_t)};
+
+    Ast(const Ast&) = delete;
+    Ast& operator=(const Ast&) = delete;
+};
+
+
+#endif //AST_HPP
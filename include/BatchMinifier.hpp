@@ -0,0 +1,57 @@
+#ifndef BATCHMINIFIER_HPP
+#define BATCHMINIFIER_HPP
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "MinificationStats.hpp"
+#include "MinifyResult.hpp"
+
+
+// minifies many files on a pool of threads, every thread reuses one scanner and minifier for all of its files
+// the errors of a file are rendered to text while it is minified and only printed by print(), in input order,
+// so what different files report never interleaves
+class BatchMinifier
+{
+public:
+    struct Job
+    {
+        std::string input;
+        std::string output;
+    };
+
+    struct FileResult
+    {
+        bool ok{false}; // read, scanned without fatal errors and written
+        MinificationStats stats;
+        std::string errors; // as ErrorReporter::print puts them, empty if there were none
+    };
+
+private:
+    std::vector<Job> m_Jobs;
+    std::vector<FileResult> m_Results; // by job
+    MinificationStats m_Total; // timed over the whole batch
+    unsigned m_Threads{0}; // that the last run used
+
+public:
+    // every shader file below a directory, the files a pattern with * ? or ** in its file name or directories
+    // matches, or the inputs a manifest lists one per line (blank lines and // comments skipped, relative to the
+    // manifest). outputs are mirrored under outputRoot, or go next to the inputs as name.min.ext if it is empty
+    // errors go to errors, an empty list is returned if the inputs can not be read, two of them share an output or
+    // an output is one of the inputs
+    static std::vector<Job> collectJobs(const std::string& inputs, const std::string& outputRoot, std::string& errors);
+
+    // 0 threads is one per core, options.threads is ignored, every file is scanned on the thread minifying it
+    void run(std::vector<Job> jobs, const MinifyOptions& options, unsigned threads = 0);
+
+    inline const std::vector<Job>& getJobs() const { return m_Jobs; }
+    inline const std::vector<FileResult>& getResults() const { return m_Results; }
+    inline const MinificationStats& getTotal() const { return m_Total; }
+    std::size_t getFailedCount() const;
+
+    // the errors file by file on std::cerr, then the totals
+    void print() const;
+};
+
+
+#endif //BATCHMINIFIER_HPP
@@ -0,0 +1,53 @@
+#ifndef CHARCLASS_HPP
+#define CHARCLASS_HPP
+#include <array>
+#include <cstdint>
+
+
+// ascii character classes, no locale lookups
+enum CharClassFlag : uint8_t
+{
+    CHAR_DIGIT = 1 << 0,
+    CHAR_HEX_DIGIT = 1 << 1,
+    CHAR_IDENT_START = 1 << 2, // letters and '_'
+    CHAR_IDENT = 1 << 3, // letters, digits and '_'
+    CHAR_BLANK = 1 << 4, // ' ', '\t', '\r', '\n'
+    CHAR_OPERATOR = 1 << 5, // punctuation that starts an operator or delimiter token
+};
+
+constexpr std::array<uint8_t, 256> makeCharClassTable()
+{
+    std::array<uint8_t, 256> table{};
+    for (int c{'0'}; c <= '9'; ++c)
+        table[c] |= CHAR_DIGIT | CHAR_HEX_DIGIT | CHAR_IDENT;
+    for (int c{'a'}; c <= 'z'; ++c)
+        table[c] |= CHAR_IDENT_START | CHAR_IDENT;
+    for (int c{'A'}; c <= 'Z'; ++c)
+        table[c] |= CHAR_IDENT_START | CHAR_IDENT;
+    for (int c{'a'}; c <= 'f'; ++c)
+        table[c] |= CHAR_HEX_DIGIT;
+    for (int c{'A'}; c <= 'F'; ++c)
+        table[c] |= CHAR_HEX_DIGIT;
+    table['_'] |= CHAR_IDENT_START | CHAR_IDENT;
+
+    for (char c : {' ', '\t', '\r', '\n'})
+        table[static_cast<unsigned char>(c)] |= CHAR_BLANK;
+    for (char c : {'(', ')', '{', '}', '[', ']', ';', ',', '.', '?', ':', '~', '+', '-', '*', '/', '%', '!', '=', '<',
+                   '>', '&', '|', '^'})
+        table[static_cast<unsigned char>(c)] |= CHAR_OPERATOR;
+    return table;
+}
+
+inline constexpr std::array<uint8_t, 256> CHAR_CLASSES{makeCharClassTable()};
+
+constexpr bool hasCharClass(char c, uint8_t flags)
+{
+    return (CHAR_CLASSES[static_cast<unsigned char>(c)] & flags) != 0;
+}
+
+constexpr bool isDigitChar(char c) { return hasCharClass(c, CHAR_DIGIT); }
+constexpr bool isIdentStartChar(char c) { return hasCharClass(c, CHAR_IDENT_START); }
+constexpr bool isIdentChar(char c) { return hasCharClass(c, CHAR_IDENT); }
+
+
+#endif //CHARCLASS_HPP
@@ -0,0 +1,121 @@
+#ifndef CONSTANTFOLDER_HPP
+#define CONSTANTFOLDER_HPP
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Ast.hpp"
+#include "NumberLiteral.hpp"
+#include "TokenBuffer.hpp"
+
+
+// folds expressions of literals (scalars, vectors and their constructors) the way the compiler evaluates them,
+// floats in float and ints wrapping at 32 bits, and prunes what a constant condition decides: if and ternary
+// branches, while and for loops that never run, do-while(false). x * 1.0, x + 0.0, true && x and the like lose
+// the constant when x has the same type as it, as far as its declaration tells
+// names are never folded, not even consts, and nothing with a # line inside is touched
+// results that need a literal GLSL does not have (inf, nan, denormals, an out of range int) are left alone
+class ConstantFolder
+{
+public:
+    static constexpr uint32_t NO_BINDING{UINT32_MAX};
+
+    // the token stays in place of a folded range and text goes out instead of it
+    struct Replacement
+    {
+        uint32_t token; // a literal or a keyword, never an identifier
+        uint32_t offset; // into getText()
+        uint32_t length;
+        TokenType first; // what the text starts and ends with, for the spacing around it
+        TokenType last;
+    };
+
+private:
+    enum class BaseType : uint8_t
+    {
+        UNKNOWN, FLOAT, INT, UINT, BOOL
+    };
+
+    struct Constant
+    {
+        BaseType type{BaseType::UNKNOWN};
+        int size{0}; // 1 for a scalar
+        float floats[4]{}; // FLOAT
+        uint32_t bits[4]{}; // INT and UINT as their bits, BOOL as 0 or 1
+    };
+
+    struct Binding
+    {
+        uint32_t id;
+        uint32_t type; // the type token of the declaration
+        uint32_t shadowed; // the binding the name had before, NO_BINDING if none
+    };
+
+    const TokenBuffer* m_Tokens{nullptr};
+    const Ast* m_Ast{nullptr};
+    std::vector<char>* m_Keep{nullptr};
+    LiteralRules m_Rules;
+
+    std::vector<uint32_t> m_Directives; // tokens of the # lines
+    std::vector<Binding> m_Names; // declarations in scope, innermost last
+    std::vector<uint32_t> m_Active; // by identifier id, its innermost binding
+    std::vector<uint32_t> m_Stack; // scratch of subtreeSize()
+    std::string m_Printed; // scratch of replace()
+    bool m_DryRun{false}; // evaluate only, nothing is replaced or dropped
+    uint32_t m_LoopName{UINT32_MAX}; // identifier id of the for variable a zero trip check evaluates with
+    Constant m_LoopValue;
+    int m_Depth{0};
+
+    std::vector<Replacement> m_Replacements;
+    std::string m_Text;
+    int m_RemovedNodes{0};
+    std::size_t m_RemovedBytes{0};
+
+    // the base type and size of a type token, size 0 for matrices, false if it is no builtin scalar, vector or matrix
+    static bool describeType(TokenType type, std::string_view name, BaseType& base, int& size);
+    static bool unary(TokenType op, const Constant& operand, Constant& value);
+    static bool binary(TokenType op, bool logicalXor, const Constant& left, const Constant& right, Constant& value);
+    static bool construct(BaseType base, int size, const Constant* args, int count, Constant& value);
+
+    bool hasDirective(uint32_t node) const;
+    int subtreeSize(uint32_t node);
+    BaseType typeOf(uint32_t node, int depth) const; // UNKNOWN unless the declarations tell
+    uint32_t lookup(uint32_t id) const; // the type token, Ast::NO_TOKEN if it is not declared
+    void declare(uint32_t id, uint32_t type);
+    void closeScope(std::size_t size); // back to the first size bindings
+    bool readLiteral(uint32_t token, Constant& value) const;
+
+    bool evaluate(uint32_t node, Constant& value); // nothing changes, for the condition of a for loop
+    bool fold(uint32_t node, Constant& value); // folds what is inside, value if the whole node is constant
+    void foldExpression(uint32_t node); // replaces it if it is constant
+    void foldChildren(uint32_t node);
+    bool foldBinary(uint32_t node, Constant& value);
+    bool foldTernary(uint32_t node, Constant& value);
+    bool foldCall(uint32_t node, Constant& value);
+
+    void foldStatement(uint32_t node, uint32_t parent);
+    void foldDeclaration(uint32_t node);
+    void foldIf(uint32_t node, uint32_t parent);
+    void foldLoop(uint32_t node, uint32_t parent);
+
+    void drop(uint32_t begin, uint32_t end); // # lines stay
+    void dropStatement(uint32_t node, uint32_t parent); // a lone ';' stays where a statement is needed
+    bool replace(uint32_t node, const Constant& value); // false if the text would not be shorter
+    bool print(const Constant& value, bool bareNegative, std::string& out, TokenType& first, TokenType& last) const;
+
+public:
+    // folds the tokens of ast, clearing the keep entries of what goes, keep has an entry for every token
+    // the memory is kept for the next shader
+    void run(const TokenBuffer& tokens, const Ast& ast, uint32_t root, std::vector<char>& keep);
+
+    // by token, the tokens are still those of the buffer that was folded
+    inline const std::vector<Replacement>& getReplacements() const { return m_Replacements; }
+    inline const std::string& getText() const { return m_Text; }
+    inline int getRemovedNodes() const { return m_RemovedNodes; }
+    inline std::size_t getRemovedBytes() const { return m_RemovedBytes; } // of tokens, what replaces them taken off
+};
+
+
+#endif //CONSTANTFOLDER_HPP
@@ -0,0 +1,59 @@
+#ifndef DEADCODEELIMINATOR_HPP
+#define DEADCODEELIMINATOR_HPP
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "Ast.hpp"
+#include "TokenBuffer.hpp"
+
+
+// finds the top level functions, globals, consts and structs that main does not reach
+// main, the shader's interface (in/out/uniform/buffer/shared/layout/invariant declarations) and whatever a # line
+// names are reached, so is every name used in the range of something reached, until nothing new turns up
+// names are not resolved, every function overload and every declaration of a reached name stays, and a declaration
+// stays whole if one of its names is reached. # lines inside what is dropped stay so conditionals keep matching
+class DeadCodeEliminator
+{
+private:
+    struct Entry
+    {
+        uint32_t item;
+        uint32_t next; // the next entry of the same name
+    };
+
+    std::vector<uint32_t> m_Items; // top level nodes
+    std::vector<char> m_Reached; // by item
+    std::vector<uint32_t> m_FirstEntry; // by identifier id, the items declaring it
+    std::vector<Entry> m_Entries;
+    std::vector<char> m_Seen; // by identifier id
+    std::vector<uint32_t> m_Work; // reached items not scanned yet
+
+    int m_RemovedFunctions{0};
+    int m_RemovedDeclarations{0};
+    std::size_t m_RemovedBytes{0};
+
+    void declare(uint32_t id, uint32_t item);
+    void reach(uint32_t id);
+    void reachItem(uint32_t item);
+
+public:
+    static constexpr uint32_t NO_ENTRY{UINT32_MAX};
+
+    // false if nothing can be dropped: no main, or the parse has errors and the items may not be what they seem
+    // otherwise the keep entries of the dropped items are cleared, keep has an entry for every token and what is
+    // already cleared in it is no use. reached names are reached like main, for # lines that are not in tokens.
+    // the memory is kept for the next shader
+    bool run(const TokenBuffer& tokens, const Ast& ast, uint32_t root, std::vector<char>& keep,
+             const std::set<std::string, std::less<>>& reached = {});
+
+    inline int getRemovedFunctions() const { return m_RemovedFunctions; } // prototypes count too
+    inline int getRemovedDeclarations() const { return m_RemovedDeclarations; }
+    inline std::size_t getRemovedBytes() const { return m_RemovedBytes; } // of the source, comments included
+};
+
+
+#endif //DEADCODEELIMINATOR_HPP
@@ -0,0 +1,53 @@
+#ifndef DEFLATEESTIMATOR_HPP
+#define DEFLATEESTIMATOR_HPP
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+
+// size in bytes data would take as a raw deflate stream, no zlib needed
+// lazy LZ77 over a 32 KiB window, then dynamic huffman blocks of 16K symbols like zlib's default level,
+// the result is usually within a few percent of gzip -9 without its 18 byte header and trailer
+// input can come in pieces, only the last window of it is kept, and the pieces do not change the result
+class DeflateEstimator
+{
+private:
+    struct Block
+    {
+        std::vector<uint32_t> literals; // literal/length symbol counts
+        std::vector<uint32_t> distances;
+        std::size_t extraBits{0};
+        std::size_t symbols{0};
+        std::size_t bytes{0};
+    };
+
+    std::vector<unsigned char> m_Data; // the window before m_At and everything after it
+    std::size_t m_Base{0}; // input position of m_Data[0]
+    std::size_t m_At{0}; // next input position to encode
+    std::size_t m_Length{0}; // match at m_At, if m_Ready
+    std::size_t m_Distance{0};
+    bool m_Ready{false};
+    std::vector<std::size_t> m_Head; // input position + 1 by hash, 0 is empty
+    std::vector<std::size_t> m_Chain; // the position before with the same hash
+    Block m_Block;
+    std::size_t m_Bits{0};
+
+    void insert(std::size_t at, std::size_t end);
+    std::size_t longestMatch(std::size_t at, std::size_t end, std::size_t& distance) const;
+    void encode(std::size_t until, std::size_t end);
+    void literal(unsigned char c);
+    void match(std::size_t length, std::size_t distance);
+    void flushBlock();
+
+public:
+    DeflateEstimator();
+
+    void add(std::string_view data);
+    std::size_t finish(); // once, after the last add
+};
+
+std::size_t estimateDeflateSize(std::string_view data);
+
+
+#endif //DEFLATEESTIMATOR_HPP
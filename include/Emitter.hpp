@@ -0,0 +1,41 @@
+#ifndef EMITTER_HPP
+#define EMITTER_HPP
+#include <cstddef>
+#include <memory_resource>
+#include <string_view>
+
+#include "OutputSink.hpp"
+
+
+// collects output in one fixed block and hands every full block to the sink, the output is never held whole
+class Emitter
+{
+private:
+    OutputSink& m_Sink;
+    std::pmr::memory_resource* m_Memory;
+    char* m_Block;
+    std::size_t m_Used{0};
+    std::size_t m_Flushed{0};
+    char m_Last{'\0'};
+
+public:
+    static constexpr std::size_t BLOCK_SIZE{64 * 1024};
+
+    // the block comes from memory, an Arena makes a minifier that is reused not allocate it every time
+    explicit Emitter(OutputSink& sink, std::pmr::memory_resource* memory = std::pmr::new_delete_resource());
+    ~Emitter(); // flushes
+
+    void emit(std::string_view text);
+    void emit(char c);
+    void flush();
+
+    inline bool empty() const { return m_Flushed + m_Used == 0; }
+    inline char last() const { return m_Last; } // '\0' before the first emit
+    inline std::size_t size() const { return m_Flushed + m_Used; }
+
+    Emitter(const Emitter&) = delete;
+    Emitter& operator=(const Emitter&) = delete;
+};
+
+
+#endif //EMITTER_HPP
@@ -2,8 +2,11 @@
 #define ERRORREPORTER_HPP
 
 #include <iostream>
+#include <string_view>
 #include <vector>
 
+#include "LineIndex.hpp"
+
 enum class ErrorSeverity
 {
     WARNING, ERROR, FATAL
@@ -11,29 +14,60 @@ enum class ErrorSeverity
 
 struct CompilerError
 {
+    static constexpr std::size_t NO_OFFSET{static_cast<std::size_t>(-1)};
+
     ErrorSeverity severity;
     std::string message;
     int line;
     int column;
     std::string context;
+    std::size_t offset{NO_OFFSET}; // into the reporter's source, column and context are looked up when printed
 
-    void print() const;
+    // column and context as resolved by the reporter, long context lines are clipped around the column
+    void print(int resolvedColumn, std::string_view resolvedContext, std::ostream& out = std::cerr) const;
 };
 
+// errors are only stored while scanning, printing (and building context lines) happens in print()
 class ErrorReporter
 {
 private:
     std::vector<CompilerError> m_Errors;
     bool m_HasFatalError{false};
 
+    std::string_view m_Source;
+    mutable LineIndex m_LineIndex; // built on the first print that needs it
+    mutable bool m_LineIndexBuilt{false};
+
+    std::size_t m_MaxErrors{DEFAULT_MAX_ERRORS};
+    std::size_t m_Suppressed{0};
+    int m_Counts[3]{}; // per severity, suppressed errors included
+
+    bool keep(ErrorSeverity severity); // counts the error, false once it is over the cap
+
 public:
+    static constexpr std::size_t DEFAULT_MAX_ERRORS{100};
+
     void reportError(ErrorSeverity severity, const std::string& message, int line, int column,
                      const std::string& context = "");
-    inline bool hasErrors() const { return !m_Errors.empty(); }
+    // an error inside the source given to setSource, cheap enough to call on every byte of a garbage file
+    void reportErrorAt(ErrorSeverity severity, std::string message, int line, std::size_t offset);
+
+    // appends other's errors with their lines shifted, keeps the cap and the suppressed count
+    // both reporters have to be on the same source
+    void merge(const ErrorReporter& other, int lineOffset);
+
+    void setSource(std::string_view source);
+    inline void setMaxErrors(std::size_t maxErrors) { m_MaxErrors = maxErrors; } // fatal errors are always kept
+    inline std::size_t getMaxErrors() const { return m_MaxErrors; }
+
+    inline bool hasErrors() const { return !m_Errors.empty() || m_Suppressed > 0; }
     inline bool hasFatalErrors() const { return m_HasFatalError; }
-    inline std::size_t getErrorCount() const { return m_Errors.size(); }
+    inline std::size_t getErrorCount() const { return m_Errors.size() + m_Suppressed; }
+    inline std::size_t getSuppressedCount() const { return m_Suppressed; }
+    inline const std::vector<CompilerError>& getErrors() const { return m_Errors; }
 
-    void print() const;
+    inline void print() const { print(std::cerr, std::cout); }
+    void print(std::ostream& errors, std::ostream& summary) const; // the errors, then the counts
     void clear();
 };
 
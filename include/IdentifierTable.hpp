@@ -0,0 +1,36 @@
+#ifndef IDENTIFIERTABLE_HPP
+#define IDENTIFIERTABLE_HPP
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+
+// interns identifier names to dense ids in order of first appearance
+// a name is kept as (offset, length) into the source the tokens were scanned from, the source is passed in on
+// every call so a moved TokenBuffer that owns its source stays valid
+class IdentifierTable
+{
+private:
+    std::vector<uint32_t> m_Offsets;
+    std::vector<uint32_t> m_Lengths;
+    std::vector<uint32_t> m_Hashes;
+    std::vector<uint32_t> m_Slots; // open addressing, id + 1 or 0 for a free slot, size is a power of two
+
+    void grow(std::size_t slots);
+
+public:
+    static constexpr uint32_t NO_ID{UINT32_MAX};
+
+    uint32_t intern(std::string_view source, uint32_t offset, uint32_t length);
+    uint32_t find(std::string_view source, std::string_view name) const; // NO_ID if not there
+    void clear();
+
+    inline std::size_t size() const { return m_Offsets.size(); }
+    inline std::string_view name(std::string_view source, uint32_t id) const
+    {
+        return source.substr(m_Offsets[id], m_Lengths[id]);
+    }
+};
+
+
+#endif //IDENTIFIERTABLE_HPP
@@ -0,0 +1,86 @@
+#ifndef INCREMENTALMINIFIER_HPP
+#define INCREMENTALMINIFIER_HPP
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "NumberLiteral.hpp"
+#include "TokenBuffer.hpp"
+
+
+// keeps a minified shader up to date across edits, for reload loops
+// the source is kept as top level units (a function, a declaration or a # line between them), an update relexes
+// from the first unit the edit touches until a unit boundary lines up with an old one again, and only the new
+// units are emitted again. renamings are sticky, a name keeps its short name until it turns into a uniform or
+// its short name shows up in the source. names declared after the first update get the next free short name
+// renaming is per name and not per scope like Minifier::minify(), a short name stays with one name so an edit in
+// one function never renames another. a pending uniform does not carry over to the next unit, so every uniform
+// has to be named before the next ';' or '}'
+class IncrementalMinifier
+{
+private:
+    struct Unit
+    {
+        std::string text; // leading whitespace and comments included, the tokens point into it
+        TokenBuffer tokens;
+        std::vector<std::string_view> identifiers; // distinct
+        std::vector<std::string_view> words; // of its # lines
+        std::string output; // without the separator from the unit before
+    };
+
+    std::string m_Source;
+    // units own their text, so they are heap allocated to keep the token views valid when the vector moves
+    std::vector<std::unique_ptr<Unit>> m_Units;
+
+    std::unordered_map<std::string, std::string> m_Renamings;
+    std::unordered_map<std::string, std::string> m_ShortNames; // short name -> original
+    // uniforms, members and # line words, never renamed once seen
+    std::unordered_set<std::string> m_ProtectedNames{"main"};
+    std::unordered_set<std::string> m_PreprocessorWords;
+    std::unordered_map<std::string, int> m_IdentifierUnits; // name -> units using it
+
+    std::string m_Output;
+    LiteralRules m_LiteralRules; // from the #version line of the first unit
+    int m_VarCounter{0};
+    bool m_Rename{true};
+
+    std::size_t m_RelexedUnits{0};
+    std::size_t m_EmittedUnits{0};
+
+    static std::unique_ptr<Unit> lexUnit(std::string_view source, std::size_t& at);
+    bool protect(const std::string& name);
+    bool collectProtected(const Unit& unit);
+    void renameAll(const std::vector<std::unique_ptr<Unit>>& units);
+    bool collectDeclarations(const Unit& unit, const std::unordered_map<std::string_view, int>& freshUnits);
+    bool resolveClashes(const Unit& unit);
+    bool isFreeName(std::string_view name) const;
+    void rename(const std::string& name);
+    void countIdentifiers(const Unit& unit, int delta);
+    void emit(Unit& unit);
+    void join();
+
+public:
+    IncrementalMinifier() = default;
+
+    // minifies source, reusing whatever did not change since the last update
+    const std::string& update(std::string_view source);
+
+    inline const std::string& getOutput() const { return m_Output; }
+    inline const std::unordered_map<std::string, std::string>& getRenamings() const { return m_Renamings; }
+    inline void setRename(bool rename) { m_Rename = rename; } // before the first update
+
+    // work done by the last update
+    inline std::size_t getRelexedUnits() const { return m_RelexedUnits; }
+    inline std::size_t getEmittedUnits() const { return m_EmittedUnits; }
+    inline std::size_t getUnitCount() const { return m_Units.size(); }
+
+    IncrementalMinifier(const IncrementalMinifier&) = delete;
+    IncrementalMinifier& operator=(const IncrementalMinifier&) = delete;
+};
+
+
+#endif //INCREMENTALMINIFIER_HPP
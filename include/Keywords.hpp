@@ -0,0 +1,14 @@
+#ifndef KEYWORDS_HPP
+#define KEYWORDS_HPP
+#include <string_view>
+
+#include "Token.hpp"
+
+// GLSL 4.60 / GLSL ES 3.20 reserved words, IDENTIFIER if the text is not one
+TokenType lookupKeyword(std::string_view text);
+
+// builtin functions, builtin variables are all caught by the gl_ prefix
+bool isBuiltinName(std::string_view name);
+
+
+#endif //KEYWORDS_HPP
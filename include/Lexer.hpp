@@ -0,0 +1,27 @@
+#ifndef LEXER_HPP
+#define LEXER_HPP
+#include <cstdint>
+
+#include "Token.hpp"
+
+
+struct Lexeme
+{
+    TokenType type;
+    uint32_t length;
+};
+
+// the longest token lookahead past the end of a lexeme ("0x" needs the next byte to be a hex digit)
+constexpr uint32_t LEXER_LOOKAHEAD{2};
+
+// end of the whitespace and comments starting at p, adds the newlines passed to lines
+// an unterminated block comment runs to end
+const char* skipTrivia(const char* p, const char* end, int& lines);
+
+// lexes the single token starting at p, p < end and p is not on whitespace or a comment
+// unexpected characters come back as ERROR with length 1
+// PREPROCESSOR lexemes run to the end of the line
+Lexeme lexToken(const char* p, const char* end);
+
+
+#endif //LEXER_HPP
@@ -0,0 +1,30 @@
+#ifndef LINEINDEX_HPP
+#define LINEINDEX_HPP
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+
+// start offset of every line in a source, built once so offset -> line/column lookups are a binary search
+class LineIndex
+{
+private:
+    std::string_view m_Source;
+    std::vector<std::size_t> m_LineStarts;
+
+public:
+    LineIndex() = default;
+    explicit LineIndex(std::string_view source);
+
+    inline std::size_t lineCount() const { return m_LineStarts.size(); }
+
+    // 1-based line and column of offset
+    int lineOf(std::size_t offset) const;
+    int columnOf(std::size_t offset) const;
+
+    // text of a 1-based line without its '\n'
+    std::string_view lineText(int line) const;
+};
+
+
+#endif //LINEINDEX_HPP
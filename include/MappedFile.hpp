@@ -0,0 +1,41 @@
+#ifndef MAPPEDFILE_HPP
+#define MAPPEDFILE_HPP
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+
+// read-only file contents, mapped with mmap for regular files
+// pipes, small files and anything else that can not be mapped are read into a buffer once, which open() reuses
+class MappedFile
+{
+private:
+    const char* m_Data{nullptr};
+    std::size_t m_Size{0};
+    bool m_Mapped{false};
+    std::string m_Buffer; // used when the file is not mapped
+
+    void release();
+
+public:
+    // mapping a few pages costs more than reading them, and every unmap stalls the other threads of the process
+    static constexpr std::size_t MIN_MAPPED_SIZE{64 * 1024};
+
+    MappedFile() = default;
+
+    // false if the file could not be opened or read
+    bool open(const std::string& path);
+
+    inline std::string_view view() const { return {m_Data, m_Size}; }
+    inline std::size_t size() const { return m_Size; }
+    inline bool isMapped() const { return m_Mapped; }
+
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+};
+
+
+#endif //MAPPEDFILE_HPP
@@ -9,10 +9,14 @@ class MinificationStats
 private:
     std::size_t m_OriginalSize{0};
     std::size_t m_MinifiedSize{0};
+    std::size_t m_DeflatedSize{0}; // estimate, 0 if not measured
     int m_VariablesRenamed{0};
     int m_FunctionsFound{0};
     int m_UniformsFound{0};
     int m_DeadCodeRemoved{0};
+    std::size_t m_DeadCodeBytes{0}; // source bytes of what was removed, 0 if nothing was
+    int m_FoldedNodes{0}; // syntax tree nodes constant folding took out
+    std::size_t m_FoldedBytes{0}; // token bytes of those, less what went out in their place
     double m_ProcessingTimeMs{0.0};
     std::chrono::high_resolution_clock::time_point m_StartTime;
 
@@ -21,13 +25,24 @@ public:
     void stopTiming();
     inline void setOriginalSize(std::size_t size) { m_OriginalSize = size; }
     inline void setMinifiedSize(std::size_t size) { m_MinifiedSize = size; }
+    inline void setDeflatedSize(std::size_t size) { m_DeflatedSize = size; }
     inline void setVariablesRenamed(int count) { m_VariablesRenamed = count; }
     inline void setFunctionsFound(int count) { m_FunctionsFound = count; }
     inline void setUniformsFound(int count) { m_UniformsFound = count; }
     inline void setDeadCodeRemoved(int count) { m_DeadCodeRemoved = count; }
+    inline void setDeadCodeBytes(std::size_t size) { m_DeadCodeBytes = size; }
+    inline void setFoldedNodes(int count) { m_FoldedNodes = count; }
+    inline void setFoldedBytes(std::size_t size) { m_FoldedBytes = size; }
 
     inline int getUniformsFound() const { return m_UniformsFound; }
     inline int getFunctionsFound() const { return m_FunctionsFound; }
+    inline std::size_t getDeflatedSize() const { return m_DeflatedSize; }
+    inline int getDeadCodeRemoved() const { return m_DeadCodeRemoved; }
+    inline std::size_t getDeadCodeBytes() const { return m_DeadCodeBytes; }
+    inline int getFoldedNodes() const { return m_FoldedNodes; }
+    inline std::size_t getFoldedBytes() const { return m_FoldedBytes; }
+    inline std::size_t getOriginalSize() const { return m_OriginalSize; }
+    inline double getProcessingTimeMs() const { return m_ProcessingTimeMs; }
 
     inline double getCompressionRatio() const
     {
@@ -38,7 +53,9 @@ public:
 
     inline std::size_t getBytesReduced() const { return m_OriginalSize - m_MinifiedSize; }
 
-    void print();
+    // sums the sizes and counts of other into these, the timing stays this one's
+    void add(const MinificationStats& other);
+    void print() const;
 };
 
 
@@ -1,53 +1,184 @@
 #ifndef MINIFIER_HPP
 #define MINIFIER_HPP
+#include <algorithm>
+#include <cstdint>
+#include <memory_resource>
+#include <ostream>
 #include <set>
 #include <vector>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <unordered_set>
 
+#include "Arena.hpp"
+#include "Ast.hpp"
+#include "CharClass.hpp"
+#include "ConstantFolder.hpp"
+#include "DeadCodeEliminator.hpp"
+#include "Emitter.hpp"
+#include "ErrorReporter.hpp"
 #include "MinificationStats.hpp"
+#include "NumberLiteral.hpp"
+#include "StreamScanner.hpp"
 #include "SymbolTable.hpp"
 #include "Token.hpp"
+#include "TokenBuffer.hpp"
 
 
 class Minifier
 {
 private:
-    std::vector<Token> m_Tokens;
-    std::unordered_map<std::string, std::string> m_Renamings;
-    std::unordered_set<std::string> m_Builtins;
+    // a local from its declaration to the end of its scope, token indices
+    struct Local
+    {
+        uint32_t name; // identifier id
+        uint32_t begin;
+        uint32_t end;
+        uint32_t uses;
+        uint32_t shadowed; // symbol the name stood for before
+    };
 
-    std::unordered_set<std::string> m_ProtectedNames;
-    std::unordered_set<std::string> m_OriginalIdentifiers;
+    struct Function
+    {
+        uint32_t begin; // its name
+        uint32_t end;
+        uint32_t firstLocal;
+        uint32_t lastLocal;
+    };
+
+    TokenBuffer m_Tokens;
+    // indexed by symbol, identifier ids for global names and then the locals, an empty renaming keeps the name
+    std::vector<std::string> m_Renamings;
+    std::vector<uint32_t> m_Symbols; // per token, NO_ID if it is not a renamable identifier
+    std::vector<Local> m_Locals;
+    std::vector<Function> m_Functions;
+    std::vector<char> m_Protected;
+    Arena m_Arena; // what analyze() and the output need for one shader, reset() takes it all back
+    std::pmr::unordered_set<std::string_view> m_PreprocessorWords{&m_Arena};
+    std::set<std::string, std::less<>> m_ReservedNames; // kept like the words of a # line, reset() keeps them
+
+    // naming state kept for the search, the symbols are named in this order
+    std::vector<uint32_t> m_GlobalOrder; // in declaration order until assignRenamings()
+    std::vector<uint32_t> m_LocalOrder; // the locals of each function, in its [firstLocal, lastLocal) range
+    std::vector<char> m_Renamed; // by symbol
+    std::vector<char> m_Kept; // by identifier id, the name stays somewhere in the output
+    std::vector<signed char> m_FreeNames; // by generated name index, -1 not checked yet
+    // whitespace between two words, by the type of the first one
+    std::vector<char> m_Separators{std::vector<char>(TOKEN_TYPE_COUNT, ' ')};
+
+    // scratch of nameSymbols(), kept so the search does not allocate for every candidate
+    std::vector<uint32_t> m_GlobalIndex; // by identifier id, the generated name index of a renamed global
+    std::vector<char> m_Blocked; // by name index, used by a global in the current function
+    std::vector<std::vector<const Local*>> m_Taken; // by name index, the locals of the current function holding it
+    std::vector<uint32_t> m_Touched;
 
     SymbolTable m_SymbolTable;
     MinificationStats m_Stats;
+    LiteralRules m_LiteralRules; // from the #version line
+    Ast m_Ast; // only for rewrite(), kept with its memory like the rest
+    ConstantFolder m_Folder;
+    DeadCodeEliminator m_DeadCode;
+    std::vector<char> m_Keep; // by token, what the passes of rewrite() leave
+    std::vector<ConstantFolder::Replacement> m_Replacements; // by token of m_Tokens, text in m_Folder
 
-    char m_NextVarName{'a'};
-    int m_VarCounter{0};
+    bool m_Rename{true};
+    bool m_Verbose{true};
+    bool m_RemoveDeadCode{false};
+    bool m_FoldConstants{false};
 
-    void initBuiltins();
-    bool isBuiltin(const std::string& name) const;
-    bool isTypeQualifier(TokenType type) const;
-    bool isType(TokenType type) const;
-    std::string getNextVarName();
-    void collectIdentifiers();
-    void collectProtectedIdentifiers();
-    void collectOriginalIdentifiers();
-    bool needsSpaceBetween(const Token& prev, const Token& curr);
+    double m_SearchBudgetMs{0.0};
+    int m_SearchSteps{0};
+    uint32_t m_SearchSeed{0};
 
-    void buildSymbolTable();
+    void rewrite(); // constant folding and dead code removal on one parse, before analyze()
+    void analyze();
+    void assignRenamings(const std::pmr::vector<uint32_t>& uses);
+    void nameSymbols();
+    std::string search(std::string output, std::size_t deflatedSize);
+    void generateOutput(Emitter& out);
     std::string generateOutput();
 
-    inline const MinificationStats& getStats() const { return m_Stats; }
-
 public:
-    Minifier(const std::vector<Token>& tokens);
+    // token rules shared with IncrementalMinifier
+    static bool isBuiltin(std::string_view name);
+    static bool isTypeQualifier(TokenType type) { return hasTrait(type, TRAIT_QUALIFIER); }
+    static bool isType(TokenType type) { return hasTrait(type, TRAIT_TYPE); }
+    static bool isReservedName(std::string_view name); // keyword or builtin
+    static std::string makeVarName(int index);
+    static bool needsSpaceBetween(TokenType prev, TokenType curr);
+
+    // calls function with every identifier-like word of a # line, those lines go out as they are
+    template <typename Function>
+    static void forEachWord(std::string_view line, Function function)
+    {
+        std::size_t i{0};
+        while (i < line.length())
+        {
+            std::size_t start{i};
+            while (i < line.length() && isIdentChar(line[i]))
+                ++i;
+            if (i > start && isIdentStartChar(line[start]))
+                function(line.substr(start, i - start));
+            i = std::max(i, start + 1);
+        }
+    }
+
+    // the first generated name from index on that is not reserved and that isFree accepts, index moves past it
+    template <typename IsFree>
+    static std::string nextFreeName(int& index, IsFree isFree)
+    {
+        for (;;)
+        {
+            std::string name{makeVarName(index++)};
+            if (!isReservedName(name) && isFree(std::string_view{name}))
+                return name;
+        }
+    }
+
+    explicit Minifier(TokenBuffer tokens);
+    explicit Minifier(const std::vector<Token>& tokens); // owned-string compatibility path
     std::string minify();
+    void minify(OutputSink& sink); // the output goes out in blocks and is never held whole, unless searching
+
+    // starts over with the next shader's tokens and hands back the old ones, for a scanner to fill again
+    // settings stay, and so does the memory of every container, a batch that reuses one minifier and one
+    // scanner stops allocating after its biggest shader
+    TokenBuffer reset(TokenBuffer tokens);
+
+    // single pass over a stream, no symbol table or dead code analysis
+    // memory is bounded by the distinct identifiers, not by the input size
+    // a name is renamed from its first declaration on, uses before that keep the original, members keep theirs
+    // short names go out in declaration order and avoid the identifiers seen so far. one that shows up later as it
+    // is (a uniform, a #define) stops being handed out, reporter gets a warning where the two can clash
+    static MinificationStats minifyStream(StreamScanner& scanner, std::ostream& out, bool rename,
+                                          ErrorReporter* reporter = nullptr);
     void printRenamings();
     inline void setOriginalSize(size_t size) { m_Stats.setOriginalSize(size); }
+    inline void setDeflatedSize(size_t size) { m_Stats.setDeflatedSize(size); } // see estimateDeflateSize()
+    inline void setRename(bool rename) { m_Rename = rename; } // false only strips whitespace and comments
+    inline void setVerbose(bool verbose) { m_Verbose = verbose; } // progress output on std::cout
+    // drops the functions, globals and consts main does not reach before anything else, see DeadCodeEliminator
+    inline void setRemoveDeadCode(bool remove) { m_RemoveDeadCode = remove; }
+    // folds constant expressions and prunes the branches and loops they decide, see ConstantFolder
+    inline void setFoldConstants(bool fold) { m_FoldConstants = fold; }
+    // names that stay as they are, are never given out and keep what they name from dead code removal, like the
+    // words of macros the caller puts in front of the output
+    inline void setReservedNames(std::set<std::string, std::less<>> names) { m_ReservedNames = std::move(names); }
+    // keeps the line of every use for printDeadCode, only the counts otherwise
+    inline void setTrackUsageLines(bool track) { m_SymbolTable.setTrackLines(track); }
 
+    // tries other namings and spacings for a smaller deflated output until the budget or the step count runs
+    // out (0 is no limit, both 0 is no search). the same seed and step count always give the same output
+    inline void setSearch(double budgetMs, int steps, uint32_t seed)
+    {
+        m_SearchBudgetMs = budgetMs;
+        m_SearchSteps = steps;
+        m_SearchSeed = seed;
+    }
+
+
+    inline const MinificationStats& getStats() const { return m_Stats; }
 
     void printStats();
     void printDeadCode();
@@ -0,0 +1,51 @@
+#ifndef MINIFYRESULT_HPP
+#define MINIFYRESULT_HPP
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "ErrorReporter.hpp"
+#include "MinificationStats.hpp"
+
+
+struct MinifyOptions
+{
+    bool rename{true};
+    bool removeDeadCode{false}; // see Minifier::setRemoveDeadCode
+    bool foldConstants{false}; // see Minifier::setFoldConstants
+    unsigned threads{1};
+    std::size_t maxErrors{ErrorReporter::DEFAULT_MAX_ERRORS};
+    bool deflatedSize{false}; // fill in the deflate estimate of the stats
+    double searchMs{0.0}; // see Minifier::setSearch
+    int searchSteps{0};
+    uint32_t seed{0};
+};
+
+// what minifyShader hands back, move only so the output buffer is never copied
+class MinifyResult
+{
+private:
+    std::string m_Output;
+    MinificationStats m_Stats;
+    ErrorReporter m_Errors;
+
+public:
+    MinifyResult(std::string output, const MinificationStats& stats, ErrorReporter errors);
+
+    inline bool ok() const { return !m_Errors.hasFatalErrors(); } // false leaves the output empty
+    inline const std::string& getOutput() const { return m_Output; }
+    inline std::string takeOutput() { return std::move(m_Output); }
+    inline const MinificationStats& getStats() const { return m_Stats; }
+    inline const ErrorReporter& getErrors() const { return m_Errors; } // they point into the source
+
+    MinifyResult(MinifyResult&&) = default;
+    MinifyResult& operator=(MinifyResult&&) = default;
+    MinifyResult(const MinifyResult&) = delete;
+    MinifyResult& operator=(const MinifyResult&) = delete;
+};
+
+// scans and minifies source without printing anything, source has to outlive the errors of the result
+MinifyResult minifyShader(std::string_view source, const MinifyOptions& options = {});
+
+
+#endif //MINIFYRESULT_HPP
@@ -0,0 +1,37 @@
+#ifndef NUMBERLITERAL_HPP
+#define NUMBERLITERAL_HPP
+#include <cstddef>
+#include <string_view>
+
+
+// what the shader's #version allows in numeric literals, without a #version line it is GLSL 1.10 or ES 1.00
+struct LiteralRules
+{
+    bool unsignedInts{false}; // 7u, from 1.30 and ES 3.00
+    bool doubles{false}; // 1.0lf, from 4.00, not in ES
+
+    // takes the version of a "#version 300 es" line, any other line leaves the rules as they are
+    void readDirective(std::string_view line);
+
+    inline bool operator==(const LiteralRules& other) const
+    {
+        return unsignedInts == other.unsignedInts && doubles == other.doubles;
+    }
+};
+
+// room shortestLiteral needs in its buffer
+constexpr std::size_t MAX_LITERAL_LENGTH{64};
+
+// the shortest spelling of a numeric literal with the same type that the compiler turns into the same bits:
+// 1.0 -> 1., 0.50 -> .5, 100000.0 -> 1e5, 2.0f -> 2., 0x10 -> 16
+// floats round trip through float, doubles through double, ints stay ints and keep their u suffix
+// the lexeme comes back as it is when nothing is shorter, or when it is no literal the rules allow
+// otherwise the result is in buffer, which has MAX_LITERAL_LENGTH chars
+std::string_view shortestLiteral(std::string_view lexeme, const LiteralRules& rules, char* buffer);
+
+// the shortest literal of a float that is positive and normal, or 0, written to buffer (MAX_LITERAL_LENGTH chars)
+// returns its length, 0 when value has no literal of its own (negative, denormal, inf or nan)
+std::size_t writeFloatLiteral(float value, char* buffer);
+
+
+#endif //NUMBERLITERAL_HPP
@@ -0,0 +1,93 @@
+#ifndef OUTPUTSINK_HPP
+#define OUTPUTSINK_HPP
+#include <functional>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+
+// where minified output goes, Emitter hands it over in large blocks
+class OutputSink
+{
+public:
+    virtual ~OutputSink() = default;
+    virtual void write(std::string_view data) = 0;
+};
+
+// writes to a file descriptor it does not own, retries short writes
+class FdSink : public OutputSink
+{
+private:
+    int m_Fd;
+    bool m_Failed{false};
+
+public:
+    explicit FdSink(int fd);
+    void write(std::string_view data) override;
+
+    inline bool failed() const { return m_Failed; }
+};
+
+// appends to a string the caller owns, reserve it up front and the appends do not allocate
+class MemorySink : public OutputSink
+{
+private:
+    std::string& m_Buffer;
+
+public:
+    explicit MemorySink(std::string& buffer);
+    void write(std::string_view data) override;
+};
+
+class CallbackSink : public OutputSink
+{
+private:
+    std::function<void(std::string_view)> m_Callback;
+
+public:
+    explicit CallbackSink(std::function<void(std::string_view)> callback);
+    void write(std::string_view data) override;
+};
+
+class StreamSink : public OutputSink
+{
+private:
+    std::ostream& m_Stream;
+
+public:
+    explicit StreamSink(std::ostream& stream);
+    void write(std::string_view data) override;
+};
+
+// an output file written under a temporary name in the target's directory and renamed over the target by commit()
+// the target, which may be the mapped input itself, is untouched until the output is complete
+class ReplacementFile
+{
+private:
+    std::string m_Path;
+    std::string m_TempPath;
+    int m_Fd{-1};
+
+public:
+    ReplacementFile() = default;
+
+    // false if the temporary file could not be created
+    bool open(const std::string& path);
+    // closes the temporary file and renames it over the target, false if either fails
+    bool commit();
+    // removes the temporary file, the target stays as it was
+    void discard();
+
+    inline int fd() const { return m_Fd; }
+    inline const std::string& tempPath() const { return m_TempPath; }
+
+    // a file that was not committed is removed
+    ~ReplacementFile();
+    ReplacementFile(const ReplacementFile&) = delete;
+    ReplacementFile& operator=(const ReplacementFile&) = delete;
+    ReplacementFile(ReplacementFile&&) = delete;
+    ReplacementFile& operator=(ReplacementFile&&) = delete;
+};
+
+
+#endif //OUTPUTSINK_HPP
@@ -0,0 +1,33 @@
+#ifndef PARALLELSCANNER_HPP
+#define PARALLELSCANNER_HPP
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+#include "ErrorReporter.hpp"
+#include "TokenBuffer.hpp"
+
+
+// scans one large source on several threads, the result is the same as Scanner::scan()
+// the source is split after newlines that are not inside a block comment, each chunk is scanned by its own
+// Scanner and the token arrays are stitched back together with the line numbers shifted
+class ParallelScanner
+{
+private:
+    std::string_view m_Source;
+    ErrorReporter* m_ErrorReporter;
+    unsigned m_Threads;
+
+    std::vector<std::size_t> findChunkStarts() const;
+
+public:
+    // below this a chunk is not worth a thread
+    static constexpr std::size_t MIN_CHUNK_SIZE{256 * 1024};
+
+    ParallelScanner(std::string_view src, unsigned threads, ErrorReporter* reporter = nullptr);
+
+    TokenBuffer scan();
+};
+
+
+#endif //PARALLELSCANNER_HPP
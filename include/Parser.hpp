@@ -0,0 +1,93 @@
+#ifndef PARSER_HPP
+#define PARSER_HPP
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Ast.hpp"
+#include "ErrorReporter.hpp"
+#include "TokenBuffer.hpp"
+
+
+// recursive descent over a scanned TokenBuffer, builds an Ast whose token ranges index into it
+// the parser knows no types beyond the names of structs it has seen, a name followed by a name is a declaration
+// # lines are skipped wherever they are, between items and statements they also become PREPROCESSOR nodes
+// after an error the rest of the statement or item becomes one ERROR node and parsing goes on after it
+class Parser
+{
+private:
+    const TokenBuffer& m_Tokens;
+    Ast& m_Ast;
+    ErrorReporter* m_ErrorReporter;
+
+    uint32_t m_Current{0}; // never on a # line
+    uint32_t m_Taken{0}; // one past the last token taken, where nodes end
+    uint32_t m_LastDirective{0}; // # lines before this token are in the tree already
+    uint32_t m_End{0}; // the END_OF_FILE token, or the size if there is none
+    bool m_Panic{false}; // an error in the current statement, no more errors until it is skipped
+    int m_Depth{0};
+    std::vector<char> m_StructNames; // by identifier id
+
+    inline TokenType type() const { return m_Current < m_End ? m_Tokens.type(m_Current) : TokenType::END_OF_FILE; }
+    TokenType typeAt(uint32_t at) const; // the significant token at or after at
+    uint32_t after(uint32_t at) const; // the significant token after at
+    inline bool check(TokenType t) const { return type() == t; }
+    bool checkWord(std::string_view word) const; // a KEYWORD spelled word
+    inline bool atEnd() const { return m_Current >= m_End; }
+    void skipDirectives();
+    uint32_t advance(); // returns the token taken
+    bool match(TokenType t);
+    bool expect(TokenType t, const char* what);
+    void error(const std::string& message);
+
+    uint16_t qualifierFlag() const; // 0 if the current token is no qualifier
+    bool isTypeStart() const;
+    bool startsDeclaration() const;
+    uint32_t skipBrackets(uint32_t at) const; // past a run of [..] groups starting at at
+
+    void addDirectives(uint32_t parent);
+    void finish(uint32_t node); // its range ends with the last token taken
+    uint32_t recover(uint32_t node); // turns node into an ERROR up to where parsing can go on
+
+    uint32_t parseExternal();
+    uint16_t parseQualifiers();
+    uint32_t parseTypeSpecifier(uint32_t declaration); // the type token, a STRUCT goes under declaration
+    uint32_t parseStruct(uint32_t begin, uint32_t name);
+    uint32_t parsePrecision();
+    uint32_t parseDeclaration(bool topLevel);
+    void parseFunction(uint32_t function);
+    uint32_t parseParameter();
+    void parseDeclarators(uint32_t declaration);
+    void parseArraySizes(uint32_t node);
+    uint32_t parseInitializer();
+
+    uint32_t parseStatement();
+    uint32_t parseBlock();
+    uint32_t parseIf();
+    uint32_t parseFor();
+    uint32_t parseWhile();
+    uint32_t parseDo();
+    uint32_t parseSwitch();
+    uint32_t parseSimple(NodeKind kind); // keyword, optional expression for return and case, then ';' or ':'
+
+    uint32_t parseExpression();
+    uint32_t parseAssignment();
+    uint32_t parseTernary();
+    uint32_t parseBinary(int precedence);
+    uint32_t parseUnary();
+    uint32_t parsePostfix(uint32_t node);
+    uint32_t parsePrimary();
+    void parseArguments(uint32_t call);
+
+public:
+    static constexpr int MAX_DEPTH{256}; // nesting of statements and expressions before it is an error
+
+    Parser(const TokenBuffer& tokens, Ast& ast, ErrorReporter* reporter = nullptr);
+
+    // parses every token, the ast is cleared first, returns the TRANSLATION_UNIT
+    uint32_t parse();
+};
+
+
+#endif //PARSER_HPP
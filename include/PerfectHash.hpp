@@ -0,0 +1,148 @@
+#ifndef PERFECTHASH_HPP
+#define PERFECTHASH_HPP
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+
+template <typename Value>
+struct PerfectHashEntry
+{
+    std::string_view key;
+    Value value;
+};
+
+constexpr uint32_t perfectHash(std::string_view key, uint32_t seed)
+{
+    // FNV-1a with a murmur finalizer so the low bits are usable as an index
+    uint32_t h{2166136261u ^ (seed * 0x9E3779B9u)};
+    for (char c : key)
+    {
+        h ^= static_cast<unsigned char>(c);
+        h *= 16777619u;
+    }
+    h ^= h >> 16;
+    h *= 0x85EBCA6Bu;
+    h ^= h >> 13;
+    h *= 0xC2B2AE35u;
+    h ^= h >> 16;
+    return h;
+}
+
+constexpr std::size_t perfectHashPow2(std::size_t n)
+{
+    std::size_t p{1};
+    while (p < n)
+        p <<= 1;
+    return p;
+}
+
+// hash-and-displace perfect hash built at compile time
+// keys are split into buckets by one hash, each bucket gets the first seed that moves all of its keys
+// into free slots, so a lookup is two hashes and a single key compare
+// the table is immutable once built, so a static constexpr instance is safe to share between threads
+template <typename Value, std::size_t N>
+class PerfectHashTable
+{
+private:
+    static constexpr std::size_t BUCKETS{perfectHashPow2((N + 1) / 2)};
+    static constexpr std::size_t SLOTS{perfectHashPow2(N) * 2};
+    static constexpr uint32_t MAX_SEED{0xFFFF};
+
+    std::array<PerfectHashEntry<Value>, SLOTS> m_Slots{};
+    std::array<uint16_t, BUCKETS> m_Seeds{};
+    std::size_t m_MaxKeyLength{0};
+
+    static constexpr std::size_t bucketOf(std::string_view key) { return perfectHash(key, 0) & (BUCKETS - 1); }
+    static constexpr std::size_t slotOf(std::string_view key, uint32_t seed) { return perfectHash(key, seed) & (SLOTS - 1); }
+
+public:
+    constexpr explicit PerfectHashTable(const PerfectHashEntry<Value> (&entries)[N])
+    {
+        // counting sort of the entries by bucket
+        std::array<std::size_t, BUCKETS + 1> start{};
+        for (std::size_t i{0}; i < N; ++i)
+        {
+            ++start[bucketOf(entries[i].key) + 1];
+            if (entries[i].key.length() > m_MaxKeyLength)
+                m_MaxKeyLength = entries[i].key.length();
+        }
+
+        std::size_t largest{0};
+        for (std::size_t b{0}; b < BUCKETS; ++b)
+        {
+            if (start[b + 1] > largest)
+                largest = start[b + 1];
+            start[b + 1] += start[b];
+        }
+
+        std::array<std::size_t, N> order{};
+        std::array<std::size_t, BUCKETS> fill{};
+        for (std::size_t i{0}; i < N; ++i)
+        {
+            std::size_t b{bucketOf(entries[i].key)};
+            order[start[b] + fill[b]++] = i;
+        }
+
+        std::array<bool, SLOTS> taken{};
+        std::array<std::size_t, N> placed{};
+
+        // biggest buckets first while the table is still empty
+        for (std::size_t size{largest}; size > 0; --size)
+        {
+            for (std::size_t b{0}; b < BUCKETS; ++b)
+            {
+                if (start[b + 1] - start[b] != size)
+                    continue;
+
+                uint32_t seed{1};
+                for (;; ++seed)
+                {
+                    if (seed > MAX_SEED)
+                        throw "PerfectHashTable: no seed found, duplicate keys?";
+
+                    bool fits{true};
+                    for (std::size_t k{0}; k < size && fits; ++k)
+                    {
+                        placed[k] = slotOf(entries[order[start[b] + k]].key, seed);
+                        if (taken[placed[k]])
+                            fits = false;
+                        for (std::size_t j{0}; j < k && fits; ++j)
+                            if (placed[j] == placed[k])
+                                fits = false;
+                    }
+                    if (fits)
+                        break;
+                }
+
+                m_Seeds[b] = static_cast<uint16_t>(seed);
+                for (std::size_t k{0}; k < size; ++k)
+                {
+                    taken[placed[k]] = true;
+                    m_Slots[placed[k]] = entries[order[start[b] + k]];
+                }
+            }
+        }
+    }
+
+    constexpr const Value* find(std::string_view key) const
+    {
+        if (key.empty() || key.length() > m_MaxKeyLength)
+            return nullptr;
+
+        const PerfectHashEntry<Value>& entry{m_Slots[slotOf(key, m_Seeds[bucketOf(key)])]};
+        return entry.key == key ? &entry.value : nullptr;
+    }
+
+    constexpr bool contains(std::string_view key) const { return find(key) != nullptr; }
+    static constexpr std::size_t size() { return N; }
+};
+
+template <typename Value, std::size_t N>
+constexpr PerfectHashTable<Value, N> makePerfectHashTable(const PerfectHashEntry<Value> (&entries)[N])
+{
+    return PerfectHashTable<Value, N>{entries};
+}
+
+
+#endif //PERFECTHASH_HPP
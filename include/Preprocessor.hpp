@@ -0,0 +1,74 @@
+#ifndef PREPROCESSOR_HPP
+#define PREPROCESSOR_HPP
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "TokenBuffer.hpp"
+
+
+// macro name -> replacement text, "" for a plain #define NAME
+using DefineSet = std::unordered_map<std::string, std::string>;
+
+// [begin, end) token indices
+struct TokenRange
+{
+    uint32_t begin;
+    uint32_t end;
+};
+
+// evaluates #if/#ifdef/#ifndef/#elif/#else/#endif over a scanned token stream, the scanner keeps every # line
+// as one PREPROCESSOR token so the directives are found once and every variant only walks those
+// #define/#undef lines in the source are tracked, macros are not expanded in the surviving code, so a variant's
+// defines go in front of its minified output as #define lines
+class Preprocessor
+{
+private:
+    enum class DirectiveKind
+    {
+        IF, IFDEF, IFNDEF, ELIF, ELSE, ENDIF, DEFINE, UNDEF
+    };
+
+    struct Directive
+    {
+        DirectiveKind kind;
+        uint32_t token;
+        std::string_view name; // macro name for IFDEF/IFNDEF/DEFINE/UNDEF
+        std::string_view argument; // expression for IF/ELIF, replacement text for DEFINE
+    };
+
+    const TokenBuffer& m_Tokens;
+    std::vector<Directive> m_Directives;
+
+public:
+    explicit Preprocessor(const TokenBuffer& tokens);
+
+    // the tokens that survive with these defines, conditional lines are dropped and END_OF_FILE is always kept
+    std::vector<TokenRange> select(const DefineSet& defines) const;
+
+    // the surviving tokens as a buffer on the same source
+    TokenBuffer filter(const std::vector<TokenRange>& ranges) const;
+
+    // the tokens name occurs in, as an identifier or a word of a # line, in order
+    std::vector<uint32_t> occurrences(std::string_view name) const;
+
+    // whether one of tokens, in order, is in ranges
+    static bool covers(const std::vector<TokenRange>& ranges, const std::vector<uint32_t>& tokens);
+
+    // text with defineLines(defines) after its #version line, or first without one
+    static std::string insertDefines(std::string_view text, const DefineSet& defines);
+
+    // {B: "", A: "2"} -> "#define A 2\n#define B\n", sorted by name so equal sets give equal lines
+    static std::string defineLines(const DefineSet& defines);
+
+    // value of an #if expression, undefined names are 0
+    static long long evaluate(std::string_view expression, const DefineSet& defines);
+
+    // "A B=2 -DC=3" -> {A: "1", B: "2", C: "3"}
+    static DefineSet parseDefines(std::string_view line);
+};
+
+
+#endif //PREPROCESSOR_HPP
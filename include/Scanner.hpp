@@ -2,51 +2,47 @@
 #define SCANNER_HPP
 #include <vector>
 #include <string>
-#include <unordered_map>
+#include <string_view>
 
 #include "ErrorReporter.hpp"
 #include "Token.hpp"
+#include "TokenBuffer.hpp"
 
 
 class Scanner
 {
 private:
-    std::string m_Source;
-    std::vector<Token> m_Tokens;
+    std::string_view m_Source;
+    TokenBuffer m_Tokens;
     ErrorReporter* m_ErrorReporter;
 
-    int m_Start{0};
-    int m_Current{0};
+    std::size_t m_End; // scanning stops here, the source length unless scanning a chunk
+    std::size_t m_Start{0};
+    std::size_t m_Current{0};
     int m_Line{1};
-    int m_Column{1};
 
-    std::unordered_map<std::string, TokenType> m_Keywords;
 
+    inline bool isAtEnd() const { return m_Current >= m_End; }
 
-    void initKeywords();
-    inline bool isAtEnd() const { return m_Current >= m_Source.length(); }
-
-    inline char advance()
-    {
-        m_Column++;
-        return m_Source[m_Current++];
-    }
-
-    inline char peek() const { return isAtEnd() ? '\0' : m_Source[m_Current]; }
-    inline char peekNext() const { return ((m_Current + 1) >= m_Source.length()) ? '\0' : m_Source[m_Current + 1]; }
-    bool match(char expected);
     void addToken(TokenType t);
     void skipWhitespace();
-    void number();
-    void identifier();
-    void preprocessor();
     void scanToken();
+    void scanUntilEnd();
     void reportError(const std::string& message);
 
 public:
     Scanner(std::string_view src, ErrorReporter* reporter = nullptr);
 
-    std::vector<Token> scanTokens();
+    // scans src next, into tokens' memory, for reusing one scanner and one buffer across a batch
+    void reset(std::string_view src, TokenBuffer tokens = TokenBuffer{});
+
+    TokenBuffer scan();
+    std::vector<Token> scanTokens(); // owned-string compatibility path
+
+    // scans [begin, end) only, begin has to be a token boundary outside any comment
+    // lines start at 1 and no END_OF_FILE is added, see ParallelScanner
+    TokenBuffer scanChunk(std::size_t begin, std::size_t end);
+    inline int getLine() const { return m_Line; }
 };
 
 
@@ -0,0 +1,24 @@
+#ifndef SHADERVIEWER_HPP
+#define SHADERVIEWER_HPP
+
+#include <functional>
+#include <string>
+
+
+// window that draws a fragment shader over the whole view, R asks load for the source again
+class ShaderViewer
+{
+private:
+    const unsigned int WIDTH{1024};
+    const unsigned int HEIGHT{1024};
+
+    std::function<std::string()> m_Load;
+
+public:
+    explicit ShaderViewer(std::function<std::string()> load);
+
+    void run();
+};
+
+
+#endif //SHADERVIEWER_HPP
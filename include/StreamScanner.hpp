@@ -0,0 +1,63 @@
+#ifndef STREAMSCANNER_HPP
+#define STREAMSCANNER_HPP
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ErrorReporter.hpp"
+#include "Token.hpp"
+
+
+struct StreamToken
+{
+    TokenType type;
+    std::string_view lexeme; // only valid until the next nextToken() call
+    int line;
+};
+
+// pull scanner over a file descriptor or istream, reads fixed size chunks into one reused buffer
+// memory does not depend on the input size, only on the chunk size (the buffer grows past it only for a
+// single token longer than a chunk)
+class StreamScanner
+{
+private:
+    enum class CommentState
+    {
+        NONE, LINE, BLOCK
+    };
+
+    int m_Fd{-1};
+    std::istream* m_Stream{nullptr};
+    ErrorReporter* m_ErrorReporter;
+
+    std::vector<char> m_Buffer;
+    std::size_t m_Begin{0}; // unconsumed bytes are [m_Begin, m_End)
+    std::size_t m_End{0};
+    bool m_Eof{false};
+    uint64_t m_BytesRead{0};
+
+    CommentState m_Comment{CommentState::NONE};
+    int m_Line{1};
+
+    std::size_t readSome(char* dst, std::size_t count);
+    void refill();
+    void reportError(const char* at, const std::string& message);
+
+public:
+    static constexpr std::size_t DEFAULT_CHUNK_SIZE{64 * 1024};
+
+    explicit StreamScanner(int fd, ErrorReporter* reporter = nullptr, std::size_t chunkSize = DEFAULT_CHUNK_SIZE);
+    explicit StreamScanner(std::istream& stream, ErrorReporter* reporter = nullptr,
+                           std::size_t chunkSize = DEFAULT_CHUNK_SIZE);
+
+    // next token, END_OF_FILE once the input is exhausted (and on every call after that)
+    StreamToken nextToken();
+
+    inline uint64_t getBytesRead() const { return m_BytesRead; }
+    inline std::size_t getBufferCapacity() const { return m_Buffer.size(); }
+};
+
+
+#endif //STREAMSCANNER_HPP
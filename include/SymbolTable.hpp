@@ -1,38 +1,62 @@
 #ifndef SYMBOLTABLE_HPP
 #define SYMBOLTABLE_HPP
+#include <cstdint>
+#include <memory_resource>
 #include <string>
-#include <unordered_map>
+#include <string_view>
 #include <vector>
 
-enum class SymbolKind
+#include "Arena.hpp"
+
+enum class SymbolKind : uint8_t
 {
     VARIABLE, FUNCTION, UNIFORM, PARAMETER
 };
 
 struct Symbol
 {
-    std::string name;
-    SymbolKind kind;
-    bool isDeclared;
-    bool isUsed;
-    int declarationLine;
-    std::vector<int> usageLines;
-
-    Symbol() : isDeclared{false}, isUsed{false}, declarationLine{0}
-    {
-    }
+    std::string_view name;
+    int declarationLine{0};
+    uint32_t uses{0}; // the declaration itself is not one
+    SymbolKind kind{SymbolKind::VARIABLE};
+    bool isDeclared{false};
 };
 
 class SymbolTable
 {
 private:
-    std::unordered_map<std::string, Symbol> m_Symbols;
+    Arena m_Arena;
+    // indexed by the token buffer's identifier ids, which are dense, so there is nothing to hash
+    // names are views into the scanned source, which must outlive the table
+    std::pmr::vector<Symbol> m_Symbols{&m_Arena};
+
+    // only with tracking on, every use in order as the varint of its id and the zigzag varint of its line minus
+    // the line of the use before, uses come in source order so that is one byte for most
+    bool m_TrackLines{false};
+    std::pmr::vector<uint8_t> m_Lines{&m_Arena};
+    int m_LastLine{0};
+
+    void recordLine(uint32_t id, int line);
+    template <typename Function>
+    void forEachUse(Function function) const; // function(id, line) for every recorded use
 
 public:
-    void declareSymbol(const std::string& name, SymbolKind kind, int line);
-    void useSymbol(const std::string& name, int line);
-    bool isSymbolUsed(const std::string& name) const;
-    std::vector<std::string> getUnusedSymbols() const;
+    inline void setTrackLines(bool track) { m_TrackLines = track; }
+
+    void resize(std::size_t identifierCount);
+    void reset(); // forgets every symbol but keeps the memory for the next shader
+    void declareSymbol(uint32_t id, std::string_view name, SymbolKind kind, int line);
+    inline void useSymbol(uint32_t id, int line)
+    {
+        ++m_Symbols[id].uses;
+        if (m_TrackLines)
+            recordLine(id, line);
+    }
+
+    bool isSymbolUsed(uint32_t id) const;
+    inline uint32_t getUseCount(uint32_t id) const { return id < m_Symbols.size() ? m_Symbols[id].uses : 0; }
+    std::vector<int> getUsageLines(uint32_t id) const; // empty unless lines are tracked
+    std::vector<std::string_view> getUnusedSymbols() const;
     int getUnusedCount() const;
 
     void print() const;
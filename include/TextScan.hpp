@@ -0,0 +1,27 @@
+#ifndef TEXTSCAN_HPP
+#define TEXTSCAN_HPP
+
+
+// byte scanning used to skip whitespace and comments
+// the implementation is picked once at runtime (AVX2, SSE2 or plain scalar)
+enum class SimdLevel
+{
+    SCALAR, SSE2, AVX2
+};
+
+SimdLevel detectSimdLevel(); // best level this cpu supports
+SimdLevel getSimdLevel();
+void setSimdLevel(SimdLevel level); // clamped to detectSimdLevel(), meant for benchmarks and testing
+const char* simdLevelName(SimdLevel level);
+
+// end of a run of ' ', '\t', '\r', '\n', adds the newlines passed to lines
+const char* skipBlanks(const char* p, const char* end, int& lines);
+
+// next '\n' or end
+const char* findNewline(const char* p, const char* end);
+
+// the '*' of the next "*/" or end, adds the newlines passed to lines
+const char* findBlockCommentEnd(const char* p, const char* end, int& lines);
+
+
+#endif //TEXTSCAN_HPP
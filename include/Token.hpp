@@ -1,53 +1,152 @@
 #ifndef TOKEN_HPP
 #define TOKEN_HPP
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
 #include <string>
+#include <string_view>
 
-enum class TokenType
+// what a token type is, a TokenType indexes TOKEN_TRAITS so each question is one load and a mask
+enum TokenTrait : uint16_t
 {
-    // Literals
-    IDENTIFIER, NUMBER,
-
-    // Keywords
-    VOID, FLOAT, INT, BOOL,
-    VEC2, VEC3, VEC4,
-    IVEC2, IVEC3, IVEC4,
-    BVEC2, BVEC3, BVEC4,
-    MAT2, MAT3, MAT4,
-    SAMPLER2D, SAMPLER_CUBE,
-
-    // Qualifiers
-    IN, OUT, INOUT, UNIFORM, ATTRIBUTE, VARYING,
-    CONST, HIGHP, MEDIUMP, LOWP,
-
-    // Control flow
-    IF, ELSE, FOR, WHILE, DO, BREAK, CONTINUE, RETURN,
-    DISCARD, STRUCT,
-
-    // Operators
-    PLUS, MINUS, STAR, SLASH, PERCENT,
-    EQUAL, PLUS_EQUAL, MINUS_EQUAL, STAR_EQUAL, SLASH_EQUAL,
-    EQUAL_EQUAL, BANG_EQUAL,
-    LESS, LESS_EQUAL, GREATER, GREATER_EQUAL,
-    AMPERSAND_AMPERSAND, PIPE_PIPE,
-    BANG, TILDE, AMPERSAND, PIPE, CARET,
-    LESS_LESS, GREATER_GREATER,
-    PLUS_PLUS, MINUS_MINUS,
-    QUESTION, COLON,
-
-    // Delimiters
-    SEMICOLON, COMMA, DOT,
-    LEFT_PAREN, RIGHT_PAREN,
-    LEFT_BRACE, RIGHT_BRACE,
-    LEFT_BRACKET, RIGHT_BRACKET,
-
-    // Special
-    PREPROCESSOR,  // #version, #define..
-    WHITESPACE,
-    NEWLINE,
-
-    END_OF_FILE, ERROR
+    TRAIT_TYPE = 1 << 0, // builtin type names
+    TRAIT_QUALIFIER = 1 << 1, // storage and precision qualifiers
+    TRAIT_KEYWORD = 1 << 2, // control flow and the other reserved words
+    TRAIT_WORD = 1 << 3, // made of letters, digits and '_', two in a row need a separator
+    TRAIT_OPERATOR = 1 << 4,
+    TRAIT_ASSIGNMENT = 1 << 5, // = += -= *= /=
+    TRAIT_DELIMITER = 1 << 6,
 };
 
+// every token type once: X(name, traits, spelling), the spelling is empty when the lexeme varies
+// the enum, TOKEN_TRAITS and TOKEN_SPELLINGS are all made from this list
+#define TOKEN_TYPES(X) \
+    /* literals */ \
+    X(IDENTIFIER, TRAIT_WORD, "") \
+    X(NUMBER, TRAIT_WORD, "") \
+    \
+    /* keywords */ \
+    X(VOID, TRAIT_TYPE | TRAIT_WORD, "void") \
+    X(FLOAT, TRAIT_TYPE | TRAIT_WORD, "float") \
+    X(INT, TRAIT_TYPE | TRAIT_WORD, "int") \
+    X(BOOL, TRAIT_TYPE | TRAIT_WORD, "bool") \
+    X(VEC2, TRAIT_TYPE | TRAIT_WORD, "vec2") \
+    X(VEC3, TRAIT_TYPE | TRAIT_WORD, "vec3") \
+    X(VEC4, TRAIT_TYPE | TRAIT_WORD, "vec4") \
+    X(IVEC2, TRAIT_TYPE | TRAIT_WORD, "ivec2") \
+    X(IVEC3, TRAIT_TYPE | TRAIT_WORD, "ivec3") \
+    X(IVEC4, TRAIT_TYPE | TRAIT_WORD, "ivec4") \
+    X(BVEC2, TRAIT_TYPE | TRAIT_WORD, "bvec2") \
+    X(BVEC3, TRAIT_TYPE | TRAIT_WORD, "bvec3") \
+    X(BVEC4, TRAIT_TYPE | TRAIT_WORD, "bvec4") \
+    X(MAT2, TRAIT_TYPE | TRAIT_WORD, "mat2") \
+    X(MAT3, TRAIT_TYPE | TRAIT_WORD, "mat3") \
+    X(MAT4, TRAIT_TYPE | TRAIT_WORD, "mat4") \
+    X(SAMPLER2D, TRAIT_TYPE | TRAIT_WORD, "sampler2D") \
+    X(SAMPLER_CUBE, TRAIT_TYPE | TRAIT_WORD, "samplerCube") \
+    X(TYPE, TRAIT_TYPE | TRAIT_WORD, "") /* any other builtin type (uint, dvec3, mat2x3, sampler3D, image2D..) */ \
+    \
+    /* qualifiers */ \
+    X(IN, TRAIT_QUALIFIER | TRAIT_WORD, "in") \
+    X(OUT, TRAIT_QUALIFIER | TRAIT_WORD, "out") \
+    X(INOUT, TRAIT_QUALIFIER | TRAIT_WORD, "inout") \
+    X(UNIFORM, TRAIT_QUALIFIER | TRAIT_WORD, "uniform") \
+    X(ATTRIBUTE, TRAIT_QUALIFIER | TRAIT_WORD, "attribute") \
+    X(VARYING, TRAIT_QUALIFIER | TRAIT_WORD, "varying") \
+    X(CONST, TRAIT_QUALIFIER | TRAIT_WORD, "const") \
+    X(HIGHP, TRAIT_QUALIFIER | TRAIT_WORD, "highp") \
+    X(MEDIUMP, TRAIT_QUALIFIER | TRAIT_WORD, "mediump") \
+    X(LOWP, TRAIT_QUALIFIER | TRAIT_WORD, "lowp") \
+    \
+    /* control flow */ \
+    X(IF, TRAIT_KEYWORD | TRAIT_WORD, "if") \
+    X(ELSE, TRAIT_KEYWORD | TRAIT_WORD, "else") \
+    X(FOR, TRAIT_KEYWORD | TRAIT_WORD, "for") \
+    X(WHILE, TRAIT_KEYWORD | TRAIT_WORD, "while") \
+    X(DO, TRAIT_KEYWORD | TRAIT_WORD, "do") \
+    X(BREAK, TRAIT_KEYWORD | TRAIT_WORD, "break") \
+    X(CONTINUE, TRAIT_KEYWORD | TRAIT_WORD, "continue") \
+    X(RETURN, TRAIT_KEYWORD | TRAIT_WORD, "return") \
+    X(DISCARD, TRAIT_KEYWORD | TRAIT_WORD, "discard") \
+    X(STRUCT, TRAIT_KEYWORD | TRAIT_WORD, "struct") \
+    X(KEYWORD, TRAIT_KEYWORD | TRAIT_WORD, "") /* any other reserved word (layout, precision, switch, true..) */ \
+    \
+    /* operators */ \
+    X(PLUS, TRAIT_OPERATOR, "+") \
+    X(MINUS, TRAIT_OPERATOR, "-") \
+    X(STAR, TRAIT_OPERATOR, "*") \
+    X(SLASH, TRAIT_OPERATOR, "/") \
+    X(PERCENT, TRAIT_OPERATOR, "%") \
+    X(EQUAL, TRAIT_OPERATOR | TRAIT_ASSIGNMENT, "=") \
+    X(PLUS_EQUAL, TRAIT_OPERATOR | TRAIT_ASSIGNMENT, "+=") \
+    X(MINUS_EQUAL, TRAIT_OPERATOR | TRAIT_ASSIGNMENT, "-=") \
+    X(STAR_EQUAL, TRAIT_OPERATOR | TRAIT_ASSIGNMENT, "*=") \
+    X(SLASH_EQUAL, TRAIT_OPERATOR | TRAIT_ASSIGNMENT, "/=") \
+    X(EQUAL_EQUAL, TRAIT_OPERATOR, "==") \
+    X(BANG_EQUAL, TRAIT_OPERATOR, "!=") \
+    X(LESS, TRAIT_OPERATOR, "<") \
+    X(LESS_EQUAL, TRAIT_OPERATOR, "<=") \
+    X(GREATER, TRAIT_OPERATOR, ">") \
+    X(GREATER_EQUAL, TRAIT_OPERATOR, ">=") \
+    X(AMPERSAND_AMPERSAND, TRAIT_OPERATOR, "&&") \
+    X(PIPE_PIPE, TRAIT_OPERATOR, "||") \
+    X(BANG, TRAIT_OPERATOR, "!") \
+    X(TILDE, TRAIT_OPERATOR, "~") \
+    X(AMPERSAND, TRAIT_OPERATOR, "&") \
+    X(PIPE, TRAIT_OPERATOR, "|") \
+    X(CARET, TRAIT_OPERATOR, "^") \
+    X(LESS_LESS, TRAIT_OPERATOR, "<<") \
+    X(GREATER_GREATER, TRAIT_OPERATOR, ">>") \
+    X(PLUS_PLUS, TRAIT_OPERATOR, "++") \
+    X(MINUS_MINUS, TRAIT_OPERATOR, "--") \
+    X(QUESTION, TRAIT_OPERATOR, "?") \
+    X(COLON, TRAIT_OPERATOR, ":") \
+    \
+    /* delimiters */ \
+    X(SEMICOLON, TRAIT_DELIMITER, ";") \
+    X(COMMA, TRAIT_DELIMITER, ",") \
+    X(DOT, TRAIT_DELIMITER, ".") \
+    X(LEFT_PAREN, TRAIT_DELIMITER, "(") \
+    X(RIGHT_PAREN, TRAIT_DELIMITER, ")") \
+    X(LEFT_BRACE, TRAIT_DELIMITER, "{") \
+    X(RIGHT_BRACE, TRAIT_DELIMITER, "}") \
+    X(LEFT_BRACKET, TRAIT_DELIMITER, "[") \
+    X(RIGHT_BRACKET, TRAIT_DELIMITER, "]") \
+    \
+    /* special */ \
+    X(PREPROCESSOR, 0, "") /* #version, #define.. */ \
+    X(WHITESPACE, 0, "") \
+    X(NEWLINE, 0, "") \
+    X(END_OF_FILE, 0, "") \
+    X(ERROR, 0, "")
+
+enum class TokenType : uint8_t
+{
+#define TOKEN_ENUM(name, traits, spelling) name,
+    TOKEN_TYPES(TOKEN_ENUM)
+#undef TOKEN_ENUM
+};
+
+inline constexpr uint16_t TOKEN_TRAITS[]{
+#define TOKEN_TRAIT(name, traits, spelling) static_cast<uint16_t>(traits),
+    TOKEN_TYPES(TOKEN_TRAIT)
+#undef TOKEN_TRAIT
+};
+
+inline constexpr std::string_view TOKEN_SPELLINGS[]{
+#define TOKEN_SPELLING(name, traits, spelling) spelling,
+    TOKEN_TYPES(TOKEN_SPELLING)
+#undef TOKEN_SPELLING
+};
+
+inline constexpr std::size_t TOKEN_TYPE_COUNT{std::size(TOKEN_TRAITS)};
+static_assert(TOKEN_TYPE_COUNT == static_cast<std::size_t>(TokenType::ERROR) + 1);
+
+constexpr bool hasTrait(TokenType type, uint16_t traits)
+{
+    return (TOKEN_TRAITS[static_cast<std::size_t>(type)] & traits) != 0;
+}
+
 struct Token {
     TokenType type;
     std::string lexeme;
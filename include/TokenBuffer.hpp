@@ -0,0 +1,87 @@
+#ifndef TOKENBUFFER_HPP
+#define TOKENBUFFER_HPP
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "IdentifierTable.hpp"
+#include "Token.hpp"
+
+
+// tokens stored as parallel arrays, lexemes are (offset, length) into the scanned source
+// the source is not copied, it has to outlive the buffer
+// identifiers are interned while tokens are pushed, every IDENTIFIER token carries a dense id so later passes
+// index vectors instead of hashing names
+class TokenBuffer
+{
+private:
+    std::string_view m_Source;
+    std::string m_OwnedSource; // only used when built from std::vector<Token>
+    bool m_OwnsSource{false};
+
+    std::vector<TokenType> m_Types;
+    std::vector<uint32_t> m_Offsets;
+    std::vector<uint32_t> m_Lengths;
+    std::vector<int> m_Lines;
+    std::vector<uint32_t> m_Ids; // IdentifierTable::NO_ID for everything but identifiers
+    IdentifierTable m_Identifiers;
+
+public:
+    TokenBuffer() = default;
+    explicit TokenBuffer(std::string_view source);
+    explicit TokenBuffer(const std::vector<Token>& tokens);
+
+    void reserve(std::size_t count);
+    void resize(std::size_t count);
+    void clear();
+    void reset(std::string_view source); // empty again for tokens scanned from source, keeps the capacity
+
+    // appends other's tokens [begin, end), both have to share a source and the ids are kept as they are,
+    // so an empty buffer takes other's identifier table
+    void append(const TokenBuffer& other, std::size_t begin, std::size_t end);
+
+    // interns other's identifiers here, both have to share a source, the result maps other's ids to ids in this buffer
+    std::vector<uint32_t> mergeIdentifiers(const TokenBuffer& other);
+
+    // copies other into [at, at + other.size()) with its lines shifted by lineOffset and its ids mapped through
+    // idMap (from mergeIdentifiers), used to stitch chunks scanned from the same source, so offsets stay valid
+    void copyFrom(const TokenBuffer& other, std::size_t at, int lineOffset, const std::vector<uint32_t>& idMap);
+
+    // drops the tokens whose keep entry is 0 in place, ids and lines stay as they are
+    void compact(const std::vector<char>& keep);
+
+    inline void push(TokenType type, uint32_t offset, uint32_t length, int line)
+    {
+        m_Types.push_back(type);
+        m_Offsets.push_back(offset);
+        m_Lengths.push_back(length);
+        m_Lines.push_back(line);
+        m_Ids.push_back(type == TokenType::IDENTIFIER ? m_Identifiers.intern(source(), offset, length)
+                            : IdentifierTable::NO_ID);
+    }
+
+    inline std::size_t size() const { return m_Types.size(); }
+    inline bool empty() const { return m_Types.empty(); }
+
+    inline TokenType type(std::size_t i) const { return m_Types[i]; }
+    inline uint32_t offset(std::size_t i) const { return m_Offsets[i]; }
+    inline uint32_t length(std::size_t i) const { return m_Lengths[i]; }
+    inline int line(std::size_t i) const { return m_Lines[i]; }
+    inline uint32_t id(std::size_t i) const { return m_Ids[i]; }
+
+    // distinct identifiers, ids are [0, identifierCount())
+    inline std::size_t identifierCount() const { return m_Identifiers.size(); }
+    inline std::string_view name(uint32_t id) const { return m_Identifiers.name(source(), id); }
+    inline uint32_t findId(std::string_view name) const { return m_Identifiers.find(source(), name); }
+
+    inline std::string_view source() const { return m_OwnsSource ? std::string_view{m_OwnedSource} : m_Source; }
+    inline std::string_view lexeme(std::size_t i) const { return source().substr(m_Offsets[i], m_Lengths[i]); }
+
+    // compatibility with the owned-string Token path
+    Token token(std::size_t i) const;
+    std::vector<Token> toTokens() const;
+};
+
+
+#endif //TOKENBUFFER_HPP
@@ -1,21 +1,54 @@
 #include "Application.hpp"
+#include "Ast.hpp"
+#include "BatchMinifier.hpp"
+#include "DeflateEstimator.hpp"
 #include "Scanner.hpp"
+#include "IncrementalMinifier.hpp"
 #include "Minifier.hpp"
-#include "ShaderVerifier.hpp"
+#include "OutputSink.hpp"
+#include "ParallelScanner.hpp"
+#include "Parser.hpp"
+#include "Preprocessor.hpp"
 #include "ErrorReporter.hpp"
-
-#include <SFML/Graphics.hpp>
+#include "StreamScanner.hpp"
+#include "TextScan.hpp"
+#ifdef GLSL_MINIFIER_WITH_SFML
+#include "ShaderVerifier.hpp"
+#include "ShaderViewer.hpp"
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fcntl.h>
+#include <filesystem>
 #include <iostream>
 #include <fstream>
-#include <sstream>
+#include <set>
+#include <thread>
+#include <unistd.h>
+#include <unordered_map>
 
 void Application::runMinifier()
 {
-    std::string source{readFile(m_Config.inputPath)};
+    if (m_Config.stream)
+    {
+        runStreamMinifier();
+        return;
+    }
+
+    if (m_Config.watch)
+    {
+        runWatch();
+        return;
+    }
+
+    MappedFile source{readFile(m_Config.inputPath)};
     ErrorReporter errorReporter;
+    errorReporter.setMaxErrors(static_cast<std::size_t>(m_Config.maxErrors));
 
-    Scanner scanner{source, &errorReporter};
-    std::vector<Token> tokens{scanner.scanTokens()};
+    ParallelScanner scanner{source.view(), m_Config.threads, &errorReporter};
+    TokenBuffer tokens{scanner.scan()};
     std::cout << "Tokens generated: " << tokens.size() << '\n';
 
     if (errorReporter.hasFatalErrors())
@@ -26,9 +59,38 @@ void Application::runMinifier()
     }
 
     std::cout << "\nminifying..\n";
-    Minifier minifier{tokens};
-    minifier.setOriginalSize(source.length());
-    std::string minified{minifier.minify()};
+    Minifier minifier{std::move(tokens)};
+    minifier.setOriginalSize(source.size());
+    minifier.setRename(m_Config.rename);
+    minifier.setRemoveDeadCode(m_Config.removeDeadCode);
+    minifier.setTrackUsageLines(m_Config.showDeadCode);
+    minifier.setFoldConstants(m_Config.foldConstants);
+    minifier.setSearch(m_Config.searchMs, m_Config.searchSteps, m_Config.seed);
+
+    // the output goes straight to the file a block at a time, it is only kept whole for --verify
+    // it replaces the target once complete, the target may be the input that is still mapped
+    ReplacementFile output;
+    if (!m_Config.outputPath.empty() && !output.open(m_Config.outputPath))
+    {
+        std::cerr << "Error: Could not write to file " << m_Config.outputPath << std::endl;
+        exit(1);
+    }
+    int fd{output.fd()};
+    FdSink file{fd};
+    DeflateEstimator deflated;
+    std::string minified;
+    CallbackSink sink{
+        [&](std::string_view block)
+        {
+            if (fd >= 0)
+                file.write(block);
+            deflated.add(block);
+            if (m_Config.verify)
+                minified += block;
+        }
+    };
+    minifier.minify(sink);
+    minifier.setDeflatedSize(deflated.finish());
 
     minifier.printStats();
 
@@ -37,121 +99,473 @@ void Application::runMinifier()
 
     minifier.printRenamings();
 
-    if (!m_Config.outputPath.empty())
+    if (fd >= 0)
     {
-        writeFile(m_Config.outputPath, minified);
+        if (file.failed())
+            output.discard();
+        if (file.failed() || !output.commit())
+        {
+            std::cerr << "Error: Could not write to file " << m_Config.outputPath << std::endl;
+            exit(1);
+        }
         std::cout << "Minified version written to: " << m_Config.outputPath << '\n';
     }
 
     if (m_Config.verify)
     {
+#ifdef GLSL_MINIFIER_WITH_SFML
         std::cout << "\nVerifying minified shader correctness\n";
         ShaderVerifier verifier;
-        auto result{verifier.verify(source, minified)};
+        auto result{verifier.verify(std::string{source.view()}, minified)};
         verifier.printResult(result);
 
         if (!result.passed())
             std::cerr << "Minification has changed the default behaviour!\n";
+#else
+        std::cerr << "Error: --verify needs a build with GLSL_MINIFIER_WITH_SFML\n";
+#endif
     }
     errorReporter.print();
 }
 
-void Application::runRenderer()
+bool Application::runBatch()
 {
-    const unsigned int WIDTH{1024};
-    const unsigned int HEIGHT{1024};
-    sf::RenderWindow window{sf::VideoMode({WIDTH, HEIGHT}), "GLSL Shader Viewer"};
-    window.setFramerateLimit(60);
+    std::string errors;
+    std::vector<BatchMinifier::Job> jobs{BatchMinifier::collectJobs(m_Config.inputPath, m_Config.outputPath, errors)};
+    if (!errors.empty())
+    {
+        std::cerr << errors;
+        return false;
+    }
+    if (jobs.empty())
+    {
+        std::cerr << "Error: no shaders found in " << m_Config.inputPath << '\n';
+        return false;
+    }
 
-    std::string fragmentSource{readFile(m_Config.inputPath)};
+    MinifyOptions options;
+    options.rename = m_Config.rename;
+    options.removeDeadCode = m_Config.removeDeadCode;
+    options.foldConstants = m_Config.foldConstants;
+    options.maxErrors = static_cast<std::size_t>(m_Config.maxErrors);
 
-    std::string vertexSource{
-        R"(
-        #version 330 core
+    BatchMinifier batch;
+    batch.run(std::move(jobs), options, m_Config.threads);
+    batch.print();
+    return batch.getFailedCount() == 0;
+}
 
-        layout(location = 0) in vec2 position;
-        layout(location = 1) in vec2 texCoord;
+void Application::runStreamMinifier()
+{
+    // "-" reads stdin, without an output path the result goes to stdout
+    int fd{m_Config.inputPath == "-" ? STDIN_FILENO : ::open(m_Config.inputPath.c_str(), O_RDONLY)};
+    if (fd < 0)
+    {
+        std::cerr << "Error: Could not open file " << m_Config.inputPath << std::endl;
+        exit(1);
+    }
 
-        out vec2 fragTexCoord;
+    ErrorReporter errorReporter;
+    errorReporter.setMaxErrors(static_cast<std::size_t>(m_Config.maxErrors));
+    StreamScanner scanner{fd, &errorReporter};
+    MinificationStats stats;
 
-        void main() {
-            gl_Position = vec4(position, 0.0, 1.0);
-            fragTexCoord = texCoord;
+    if (m_Config.outputPath.empty())
+        stats = Minifier::minifyStream(scanner, std::cout, m_Config.rename, &errorReporter);
+    else
+    {
+        // the input is read while the output is written, so the output only replaces the target at the end
+        ReplacementFile output;
+        std::ofstream file;
+        if (output.open(m_Config.outputPath))
+            file.open(output.tempPath(), std::ios::binary);
+        if (!file.is_open())
+        {
+            output.discard();
+            std::cerr << "Error: Could not write to file " << m_Config.outputPath << std::endl;
+            exit(1);
+        }
+        stats = Minifier::minifyStream(scanner, file, m_Config.rename, &errorReporter);
+        file.close();
+        if (file.fail())
+            output.discard();
+        if (file.fail() || !output.commit())
+        {
+            std::cerr << "Error: Could not write to file " << m_Config.outputPath << std::endl;
+            exit(1);
+        }
+    }
+
+    if (fd != STDIN_FILENO)
+        ::close(fd);
+
+    if (!m_Config.outputPath.empty())
+    {
+        stats.print();
+        std::cout << "Minified version written to: " << m_Config.outputPath << '\n';
+        errorReporter.print();
+    }
+    else if (errorReporter.hasErrors())
+        errorReporter.print(std::cerr, std::cerr); // stdout is the shader
+}
+
+void Application::runWatch()
+{
+    // polls the input and minifies again on every change, only the changed units are redone
+    // writing the input would change it again and again
+    std::error_code sameError;
+    if (!m_Config.outputPath.empty() && std::filesystem::equivalent(m_Config.inputPath, m_Config.outputPath, sameError))
+    {
+        std::cerr << "Error: --watch can not write its output to the input " << m_Config.inputPath << std::endl;
+        exit(1);
+    }
+
+    IncrementalMinifier minifier;
+    minifier.setRename(m_Config.rename);
+    std::filesystem::file_time_type lastWrite{};
+
+    std::cout << "Watching " << m_Config.inputPath << ", Ctrl+C to stop" << std::endl;
+    for (;;)
+    {
+        std::error_code error;
+        std::filesystem::file_time_type write{std::filesystem::last_write_time(m_Config.inputPath, error)};
+        if (error || write == lastWrite)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds{100});
+            continue;
+        }
+        lastWrite = write;
+
+        MappedFile source{readFile(m_Config.inputPath)};
+        auto start{std::chrono::high_resolution_clock::now()};
+        const std::string& minified{minifier.update(source.view())};
+        auto end{std::chrono::high_resolution_clock::now()};
+
+        if (!m_Config.outputPath.empty())
+        {
+            // an editor or viewer reading the output never sees half of it
+            ReplacementFile output;
+            bool written{output.open(m_Config.outputPath)};
+            if (written)
+            {
+                FdSink file{output.fd()};
+                file.write(minified);
+                if (file.failed())
+                    output.discard();
+                written = !file.failed() && output.commit();
+            }
+            if (!written)
+            {
+                std::cerr << "Error: Could not write to file " << m_Config.outputPath << std::endl;
+                exit(1);
+            }
+        }
+        else
+            std::cout << minified << '\n';
+
+        std::cout << "Minified in " << std::chrono::duration<double, std::milli>{end - start}.count() << " ms ("
+            << minifier.getRelexedUnits() << " of " << minifier.getUnitCount() << " units relexed, "
+            << minified.length() << " bytes)" << std::endl;
+    }
+}
+
+void Application::runRenderer()
+{
+#ifdef GLSL_MINIFIER_WITH_SFML
+    // with --minified the shader goes through the minifier first, a reload only redoes what changed
+    IncrementalMinifier minifier;
+    auto loadSource{
+        [&]()
+        {
+            MappedFile source{readFile(m_Config.inputPath)};
+            if (!m_Config.minified)
+                return std::string{source.view()};
+
+            auto start{std::chrono::high_resolution_clock::now()};
+            std::string minified{minifier.update(source.view())};
+            auto end{std::chrono::high_resolution_clock::now()};
+            std::cout << "Minified in " << std::chrono::duration<double, std::milli>{end - start}.count() << " ms ("
+                << minifier.getRelexedUnits() << " of " << minifier.getUnitCount() << " units relexed)" << std::endl;
+            return minified;
         }
-    )"
     };
 
-    sf::Shader shader;
-    if (!shader.loadFromMemory(vertexSource, fragmentSource))
+    ShaderViewer viewer{loadSource};
+    viewer.run();
+#else
+    std::cerr << "Error: render needs a build with GLSL_MINIFIER_WITH_SFML" << std::endl;
+#endif
+}
+
+void Application::runBenchmark()
+{
+    auto loadStart{std::chrono::high_resolution_clock::now()};
+    MappedFile source{readFile(m_Config.inputPath)};
+    auto loadEnd{std::chrono::high_resolution_clock::now()};
+
+    double megabytes{source.size() / (1024.0 * 1024.0)};
+    std::cout << "Input: " << m_Config.inputPath << " (" << source.size() << " bytes), "
+        << m_Config.iterations << " iterations\n";
+    std::cout << "Load (" << (source.isMapped() ? "mmap" : "read") << "):\t"
+        << std::chrono::duration<double, std::milli>{loadEnd - loadStart}.count() << " ms\n\n";
+
+    // scanner on every whitespace/comment skipping implementation this cpu supports
+    SimdLevel best{detectSimdLevel()};
+    for (int level{0}; level <= static_cast<int>(best); ++level)
     {
-        std::cerr << "Error: Failed to compile shader" << std::endl;
-        return;
+        setSimdLevel(static_cast<SimdLevel>(level));
+
+        std::size_t tokenCount{0};
+        auto start{std::chrono::high_resolution_clock::now()};
+        for (int i{0}; i < m_Config.iterations; ++i)
+        {
+            Scanner scanner{source.view()};
+            tokenCount = scanner.scan().size();
+        }
+        auto end{std::chrono::high_resolution_clock::now()};
+
+        double ms{std::chrono::duration<double, std::milli>{end - start}.count() / m_Config.iterations};
+        std::cout << "Scan (" << simdLevelName(getSimdLevel()) << "):\t" << ms << " ms, "
+            << megabytes / (ms / 1000.0) << " MB/s, "
+            << tokenCount / (ms / 1000.0) / 1e6 << " Mtokens/s\n";
     }
+    setSimdLevel(best);
 
-    std::cout << "Shader compiled successfully!" << std::endl;
-    std::cout << "Controls: ESC to exit, R to reload shader" << std::endl;
+    // parallel scan scaling, one thread is the plain Scanner
+    for (unsigned threads{1}; threads <= 32; threads *= 2)
+    {
+        std::size_t tokenCount{0};
+        auto start{std::chrono::high_resolution_clock::now()};
+        for (int i{0}; i < m_Config.iterations; ++i)
+        {
+            ParallelScanner scanner{source.view(), threads};
+            tokenCount = scanner.scan().size();
+        }
+        auto end{std::chrono::high_resolution_clock::now()};
+
+        double ms{std::chrono::duration<double, std::milli>{end - start}.count() / m_Config.iterations};
+        std::cout << "Parallel scan (" << threads << " threads):\t" << ms << " ms, "
+            << megabytes / (ms / 1000.0) << " MB/s, "
+            << tokenCount / (ms / 1000.0) / 1e6 << " Mtokens/s\n";
+    }
 
-    sf::VertexArray vertices{sf::PrimitiveType::TriangleStrip, 4};
-    vertices[0].position = sf::Vector2f(-1.f, -1.f);
-    vertices[1].position = sf::Vector2f(1.f, -1.f);
-    vertices[2].position = sf::Vector2f(-1.f, 1.f);
-    vertices[3].position = sf::Vector2f(1.f, 1.f);
+    // parse on its own, the tokens are scanned once and the ast is reused
+    {
+        Scanner scanner{source.view()};
+        TokenBuffer tokens{scanner.scan()};
+        Ast ast;
 
-    vertices[0].texCoords = sf::Vector2f(0.f, 0.f);
-    vertices[1].texCoords = sf::Vector2f(1.f, 0.f);
-    vertices[2].texCoords = sf::Vector2f(0.f, 1.f);
-    vertices[3].texCoords = sf::Vector2f(1.f, 1.f);
+        auto start{std::chrono::high_resolution_clock::now()};
+        for (int i{0}; i < m_Config.iterations; ++i)
+        {
+            Parser parser{tokens, ast};
+            parser.parse();
+        }
+        auto end{std::chrono::high_resolution_clock::now()};
 
-    sf::Clock clock;
-    while (window.isOpen())
+        double ms{std::chrono::duration<double, std::milli>{end - start}.count() / m_Config.iterations};
+        std::cout << "Parse:\t" << ms << " ms, " << megabytes / (ms / 1000.0) << " MB/s, "
+            << tokens.size() / (ms / 1000.0) / 1e6 << " Mtokens/s, " << ast.size() << " nodes ("
+            << ast.size() * Ast::NODE_SIZE / 1024 << " KB)\n";
+    }
+
+    // the per token classification the passes lean on: type and qualifier checks, and a separator check per pair
     {
-        while (const std::optional event = window.pollEvent())
+        Scanner scanner{source.view()};
+        TokenBuffer tokens{scanner.scan()};
+        std::size_t hits{0};
+
+        auto start{std::chrono::high_resolution_clock::now()};
+        for (int i{0}; i < m_Config.iterations; ++i)
         {
-            if (event->is<sf::Event::Closed>())
-                window.close();
+            TokenType prev{TokenType::END_OF_FILE};
+            for (std::size_t t{0}; t < tokens.size(); ++t)
+            {
+                TokenType type{tokens.type(t)};
+                hits += Minifier::isType(type) + Minifier::isTypeQualifier(type) +
+                    Minifier::needsSpaceBetween(prev, type);
+                prev = type;
+            }
+        }
+        auto end{std::chrono::high_resolution_clock::now()};
 
-            if (sf::Keyboard::isKeyPressed(sf::Keyboard::Scancode::Escape))
-                window.close();
+        double ms{std::chrono::duration<double, std::milli>{end - start}.count() / m_Config.iterations};
+        std::cout << "Classify:\t" << ms << " ms, " << tokens.size() / (ms / 1000.0) / 1e6 << " Mtokens/s, "
+            << hits / m_Config.iterations << " hits\n";
+    }
 
-            if (sf::Keyboard::isKeyPressed(sf::Keyboard::Scancode::R))
+    // scan and minify with new instances every time, then with one scanner and minifier reset in between
+    std::size_t minifiedSize{0};
+    CallbackSink sink{[&](std::string_view data) { minifiedSize += data.size(); }};
+    for (bool reuse : {false, true})
+    {
+        Scanner scanner{source.view()};
+        Minifier minifier{TokenBuffer{}};
+        minifier.setVerbose(false);
+        minifier.setRename(m_Config.rename);
+        TokenBuffer spare;
+
+        auto start{std::chrono::high_resolution_clock::now()};
+        for (int i{0}; i < m_Config.iterations; ++i)
+        {
+            minifiedSize = 0;
+            if (reuse)
+            {
+                scanner.reset(source.view(), std::move(spare));
+                spare = minifier.reset(scanner.scan());
+                minifier.minify(sink);
+            }
+            else
             {
-                std::cout << "Reloading shader..." << std::endl;
-                fragmentSource = readFile(m_Config.inputPath);
-                if (shader.loadFromMemory(vertexSource, fragmentSource))
-                {
-                    std::cout << "Shader reloaded successfully!" << std::endl;
-                    clock.restart();
-                }
-                else
-                    std::cerr << "Failed to reload shader!" << std::endl;
+                Scanner fresh{source.view()};
+                Minifier freshMinifier{fresh.scan()};
+                freshMinifier.setVerbose(false);
+                freshMinifier.setRename(m_Config.rename);
+                freshMinifier.minify(sink);
             }
         }
+        auto end{std::chrono::high_resolution_clock::now()};
+
+        double ms{std::chrono::duration<double, std::milli>{end - start}.count() / m_Config.iterations};
+        std::cout << "Scan + minify (" << (reuse ? "reset" : "new") << "):\t" << ms << " ms, "
+            << megabytes / (ms / 1000.0) << " MB/s, " << minifiedSize << " bytes out\n";
+    }
+}
+
+void Application::runVariants()
+{
+    MappedFile source{readFile(m_Config.inputPath)};
+    MappedFile definesFile{readFile(m_Config.definesPath)};
+
+    // one define set per line, blank lines and // comments are skipped
+    std::vector<DefineSet> variants;
+    std::string_view lines{definesFile.view()};
+    while (!lines.empty())
+    {
+        std::size_t newline{lines.find('\n')};
+        std::string_view line{lines.substr(0, newline)};
+        lines.remove_prefix(newline == std::string_view::npos ? lines.length() : newline + 1);
+
+        std::size_t first{line.find_first_not_of(" \t\r")};
+        if (first == std::string_view::npos || line.substr(first, 2) == "//")
+            continue;
+        variants.push_back(Preprocessor::parseDefines(line));
+    }
+
+    auto start{std::chrono::high_resolution_clock::now()};
+
+    ErrorReporter errorReporter;
+    errorReporter.setMaxErrors(static_cast<std::size_t>(m_Config.maxErrors));
+    Scanner scanner{source.view(), &errorReporter};
+    TokenBuffer tokens{scanner.scan()};
+    Preprocessor preprocessor{tokens};
+
+    // the tokens every defined name occurs in. every output starts with its variant's #define lines, so their names
+    // and the words of their values, like a function SHADE=shadeA calls, keep their names and are never dropped
+    std::unordered_map<std::string, std::vector<uint32_t>> defineUses;
+    std::set<std::string, std::less<>> defineWords;
+    for (const DefineSet& defines : variants)
+    {
+        for (const auto& define : defines)
+        {
+            if (defineWords.insert(define.first).second)
+                defineUses.emplace(define.first, preprocessor.occurrences(define.first));
+            Minifier::forEachWord(define.second, [&](std::string_view word) { defineWords.emplace(word); });
+        }
+    }
+
+    // variants that keep the same tokens minify to the same text, the defines are put in front when it is written.
+    // the ones the kept tokens mention are part of the key as well, the others can not change what the code means
+    std::unordered_map<std::string, std::size_t> uniqueVariants;
+    std::vector<std::string> outputs;
+    std::vector<std::size_t> outputOf(variants.size());
+    Minifier minifier{TokenBuffer{}};
+    minifier.setVerbose(false);
+    minifier.setRename(m_Config.rename);
+    minifier.setRemoveDeadCode(m_Config.removeDeadCode);
+    minifier.setFoldConstants(m_Config.foldConstants);
+    minifier.setReservedNames(std::move(defineWords));
+    for (std::size_t i{0}; i < variants.size(); ++i)
+    {
+        std::vector<TokenRange> ranges{preprocessor.select(variants[i])};
+        DefineSet used;
+        for (const auto& define : variants[i])
+        {
+            if (Preprocessor::covers(ranges, defineUses.at(define.first)))
+                used.insert(define);
+        }
+        // the lines never hold a '\0', so it ends them
+        std::string key{Preprocessor::defineLines(used)};
+        key += '\0';
+        key.append(reinterpret_cast<const char*>(ranges.data()), ranges.size() * sizeof(TokenRange));
+
+        auto [it, inserted]{uniqueVariants.try_emplace(std::move(key), outputs.size())};
+        if (inserted)
+        {
+            minifier.reset(preprocessor.filter(ranges));
+            outputs.push_back(minifier.minify());
+        }
+        outputOf[i] = it->second;
+    }
 
-        float time{clock.getElapsedTime().asSeconds()};
+    auto end{std::chrono::high_resolution_clock::now()};
+    double seconds{std::chrono::duration<double>{end - start}.count()};
 
-        shader.setUniform("time", time);
-        shader.setUniform("resolution", sf::Vector2f(WIDTH, HEIGHT));
-        shader.setUniform("iTime", time);
-        shader.setUniform("iResolution", sf::Vector3f(WIDTH, HEIGHT, 0.0f));
+    std::cout << "Variants:\t\t" << variants.size() << '\n';
+    std::cout << "Unique variants:\t" << outputs.size() << '\n';
+    std::cout << "Processing time:\t" << seconds * 1000.0 << " ms\n";
+    if (seconds > 0)
+        std::cout << "Throughput:\t\t" << variants.size() / seconds << " variants/s\n";
 
-        window.clear(sf::Color::Black);
-        window.draw(vertices, &shader);
-        window.display();
+    if (!m_Config.outputPath.empty())
+    {
+        std::filesystem::create_directories(m_Config.outputPath);
+        for (std::size_t i{0}; i < variants.size(); ++i)
+            writeFile(m_Config.outputPath + "/variant_" + std::to_string(i) + ".glsl",
+                      Preprocessor::insertDefines(outputs[outputOf[i]], variants[i]));
+        std::cout << "Variants written to: " << m_Config.outputPath << '\n';
     }
+    errorReporter.print();
 }
 
 void Application::showHelp() const
 {
     std::cout << "Usage:\n";
     std::cout << "  Minify:   glsl_minifier minify <input.glsl> [output.glsl] [options]\n";
-    std::cout << "  Render:   glsl_minifier render <shader.glsl>\n";
+    std::cout << "  Batch:    glsl_minifier minify-batch <dir|pattern|manifest> [output_dir] [--threads N]\n"
+        << "            [--no-rename] [--remove-dead-code] [--fold-constants] [--max-errors N]\n";
+    std::cout << "  Render:   glsl_minifier render <shader.glsl> [--minified]\n";
+    std::cout << "  Bench:    glsl_minifier bench <input.glsl> [--iterations N]\n";
+    std::cout << "  Variants: glsl_minifier variants <input.glsl> <defines.txt> [output_dir] [--no-rename]\n"
+        << "            [--remove-dead-code] [--fold-constants]\n";
     std::cout << "  Help:     glsl_minifier --help\n\n";
     std::cout << "Options:\n";
     std::cout << "  --verify        Run correctness verification (compile and compare)\n";
-    std::cout << "  --dead-code     Show dead code analysis\n\n";
+    std::cout << "  --dead-code     Show unused symbols and those used only once\n";
+    std::cout << "  --remove-dead-code  Drop the functions, globals and consts main does not reach\n";
+    std::cout << "  --fold-constants  Fold constant expressions, drop the branches and loops they decide\n";
+    std::cout << "  --stream        Minify in one pass with bounded memory (input - reads stdin), only\n"
+        << "                  --no-rename and --max-errors go with it\n";
+    std::cout << "  --no-rename     Only strip whitespace and comments\n";
+    std::cout << "  --watch         Minify again whenever the input changes, only the edited parts are redone,\n"
+        << "                  only --no-rename goes with it\n";
+    std::cout << "  --minified      Render the minified shader, R reloads it incrementally\n";
+    std::cout << "  --threads N     Scan a large input on N threads (default 1), minify-batch: files at once\n"
+        << "                  (default one per core)\n";
+    std::cout << "  --search MS     Spend up to MS milliseconds looking for a smaller deflated output\n";
+    std::cout << "  --search-steps N  Stop the search after N candidates, same seed and N give the same output\n";
+    std::cout << "  --seed N        Seed of the search (default 0)\n";
+    std::cout << "  --max-errors N  Errors to keep and print, the rest are only counted (default 100)\n";
+    std::cout << "  --iterations N  Benchmark repetitions (default 10)\n\n";
     std::cout << "Examples:\n";
     std::cout << "  glsl_minifier minify shader.glsl out.glsl\n";
     std::cout << "  glsl_minifier minify shader.glsl out.glsl --verify --dead-code\n";
+    std::cout << "  glsl_minifier minify shader.glsl out.glsl --remove-dead-code --fold-constants\n";
+    std::cout << "  glsl_minifier minify dump.glsl out.glsl --stream\n";
+    std::cout << "  glsl_minifier variants uber.glsl variants.txt out/\n";
+    std::cout << "  glsl_minifier minify-batch 'shaders/**/*.frag' out/\n";
+    std::cout << "  glsl_minifier minify shader.glsl out.glsl --watch\n";
+    std::cout << "  glsl_minifier minify shader.glsl out.glsl --search 2000 --seed 7\n";
     std::cout << "  glsl_minifier render shader.glsl\n";
 }
 
@@ -182,15 +596,88 @@ bool Application::parseCommandLine(int argc, char* argv[])
         if (argc >= 4 && argv[3][0] != '-')
             m_Config.outputPath = argv[3];
 
+        // one pass has no symbol table, parse or whole output, the options that need one do not go with --stream
+        // --watch relexes only what changed and has none of them either, nor an error report
+        std::string notStreamed;
+        std::string notWatched;
         for (int i{3}; i < argc; ++i)
         {
             std::string arg{argv[i]};
+            bool wholeShader{arg == "--verify" || arg == "--dead-code" || arg == "--remove-dead-code" ||
+                arg == "--fold-constants" || arg == "--threads" || arg == "--search" || arg == "--search-steps"};
+            if (notStreamed.empty() && (wholeShader || arg == "--watch"))
+                notStreamed = arg;
+            if (notWatched.empty() && (wholeShader || arg == "--max-errors"))
+                notWatched = arg;
+
             if (arg == "--verify")
                 m_Config.verify = true;
             else if (arg == "--dead-code")
                 m_Config.showDeadCode = true;
+            else if (arg == "--remove-dead-code")
+                m_Config.removeDeadCode = true;
+            else if (arg == "--fold-constants")
+                m_Config.foldConstants = true;
+            else if (arg == "--stream")
+                m_Config.stream = true;
+            else if (arg == "--no-rename")
+                m_Config.rename = false;
+            else if (arg == "--watch")
+                m_Config.watch = true;
+            else if (arg == "--max-errors" && i + 1 < argc)
+                m_Config.maxErrors = std::max(0, std::atoi(argv[++i]));
+            else if (arg == "--threads" && i + 1 < argc)
+                m_Config.threads = static_cast<unsigned>(std::max(1, std::atoi(argv[++i])));
+            else if (arg == "--search" && i + 1 < argc)
+                m_Config.searchMs = std::max(0, std::atoi(argv[++i]));
+            else if (arg == "--search-steps" && i + 1 < argc)
+                m_Config.searchSteps = std::max(0, std::atoi(argv[++i]));
+            else if (arg == "--seed" && i + 1 < argc)
+                m_Config.seed = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        }
+
+        if (m_Config.stream && !notStreamed.empty())
+        {
+            std::cerr << "Error: " << notStreamed << " can not be used with --stream\n";
+            return false;
+        }
+        if (m_Config.watch && !notWatched.empty())
+        {
+            std::cerr << "Error: " << notWatched << " can not be used with --watch\n";
+            return false;
+        }
+        return true;
+    }
+    else if (modeStr == "minify-batch")
+    {
+        m_Config.mode = Config::Mode::BATCH;
+        m_Config.threads = 0;
+
+        if (argc < 3)
+        {
+            std::cerr << "Error: minify-batch requires a directory, a pattern or a manifest\n";
+            return false;
         }
 
+        m_Config.inputPath = argv[2];
+
+        if (argc >= 4 && argv[3][0] != '-')
+            m_Config.outputPath = argv[3];
+
+        for (int i{3}; i < argc; ++i)
+        {
+            std::string arg{argv[i]};
+            if (arg == "--no-rename")
+                m_Config.rename = false;
+            else if (arg == "--remove-dead-code")
+                m_Config.removeDeadCode = true;
+            else if (arg == "--fold-constants")
+                m_Config.foldConstants = true;
+            else if (arg == "--max-errors" && i + 1 < argc)
+                m_Config.maxErrors = std::max(0, std::atoi(argv[++i]));
+            else if (arg == "--threads" && i + 1 < argc)
+                m_Config.threads = static_cast<unsigned>(std::max(0, std::atoi(argv[++i])));
+        }
         return true;
     }
     else if (modeStr == "render")
@@ -204,24 +691,75 @@ bool Application::parseCommandLine(int argc, char* argv[])
         }
 
         m_Config.inputPath = argv[2];
+
+        for (int i{3}; i < argc; ++i)
+            if (std::string{argv[i]} == "--minified")
+                m_Config.minified = true;
+        return true;
+    }
+    else if (modeStr == "bench")
+    {
+        m_Config.mode = Config::Mode::BENCH;
+
+        if (argc < 3)
+        {
+            std::cerr << "Error: bench requires an input file\n";
+            return false;
+        }
+
+        m_Config.inputPath = argv[2];
+
+        for (int i{3}; i < argc; ++i)
+        {
+            std::string arg{argv[i]};
+            if (arg == "--iterations" && i + 1 < argc)
+                m_Config.iterations = std::max(1, std::atoi(argv[++i]));
+        }
+        return true;
+    }
+    else if (modeStr == "variants")
+    {
+        m_Config.mode = Config::Mode::VARIANTS;
+
+        if (argc < 4)
+        {
+            std::cerr << "Error: variants requires an input file and a defines file\n";
+            return false;
+        }
+
+        m_Config.inputPath = argv[2];
+        m_Config.definesPath = argv[3];
+
+        if (argc >= 5 && argv[4][0] != '-')
+            m_Config.outputPath = argv[4];
+
+        for (int i{4}; i < argc; ++i)
+        {
+            std::string arg{argv[i]};
+            if (arg == "--no-rename")
+                m_Config.rename = false;
+            else if (arg == "--remove-dead-code")
+                m_Config.removeDeadCode = true;
+            else if (arg == "--fold-constants")
+                m_Config.foldConstants = true;
+            else if (arg == "--max-errors" && i + 1 < argc)
+                m_Config.maxErrors = std::max(0, std::atoi(argv[++i]));
+        }
         return true;
     }
     std::cerr << "Error: unknown mode " << modeStr << '\n';
     return false;
 }
 
-std::string Application::readFile(const std::string& path)
+MappedFile Application::readFile(const std::string& path)
 {
-    std::ifstream file{path};
-    if (!file.is_open())
+    MappedFile file;
+    if (!file.open(path))
     {
         std::cerr << "Error: Could not open file " << path << std::endl;
         exit(1);
     }
-
-    std::stringstream buffer;
-    buffer << file.rdbuf();
-    return buffer.str();
+    return file;
 }
 
 void Application::writeFile(const std::string& path, const std::string& content)
@@ -248,9 +786,17 @@ int Application::run()
     case Config::Mode::MINIFY:
         runMinifier();
         return 0;
+    case Config::Mode::BATCH:
+        return runBatch() ? 0 : 1;
     case Config::Mode::RENDER:
         runRenderer();
         return 0;
+    case Config::Mode::BENCH:
+        runBenchmark();
+        return 0;
+    case Config::Mode::VARIANTS:
+        runVariants();
+        return 0;
     case Config::Mode::HELP:
         showHelp();
         return 0;
@@ -0,0 +1,72 @@
+#include "Arena.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+void Arena::addBlock(std::size_t size)
+{
+    // not value initialized, a fresh block is never read before it is written
+    m_Blocks.push_back({std::unique_ptr<std::byte[]>{new std::byte[size]}, size});
+    m_Used = 0;
+}
+
+void* Arena::do_allocate(std::size_t bytes, std::size_t alignment)
+{
+    if (!m_Blocks.empty())
+    {
+        const Block& block{m_Blocks.back()};
+        auto base{reinterpret_cast<std::uintptr_t>(block.data.get())};
+        std::size_t at{((base + m_Used + alignment - 1) & ~(alignment - 1)) - base};
+        if (at + bytes <= block.size)
+        {
+            m_Used = at + bytes;
+            m_Allocated += bytes;
+            return block.data.get() + at;
+        }
+    }
+
+    // blocks double so a growing container costs a logarithmic number of them
+    std::size_t size{std::max(MIN_BLOCK_SIZE, bytes + alignment)};
+    if (!m_Blocks.empty())
+        size = std::max(size, 2 * m_Blocks.back().size);
+    addBlock(size);
+    return do_allocate(bytes, alignment);
+}
+
+void Arena::do_deallocate(void* p, std::size_t bytes, std::size_t)
+{
+    // only the last allocation can be taken back, enough for a scratch buffer that is freed before the next one
+    if (m_Blocks.empty())
+        return;
+    std::byte* top{m_Blocks.back().data.get() + m_Used};
+    if (static_cast<std::byte*>(p) + bytes == top)
+    {
+        m_Used -= bytes;
+        m_Allocated -= bytes;
+    }
+}
+
+bool Arena::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+{
+    return this == &other;
+}
+
+void Arena::reset()
+{
+    if (m_Blocks.size() > 1)
+    {
+        std::size_t capacity{getCapacity()};
+        m_Blocks.clear();
+        addBlock(capacity);
+    }
+    m_Used = 0;
+    m_Allocated = 0;
+}
+
+std::size_t Arena::getCapacity() const
+{
+    std::size_t capacity{0};
+    for (const Block& block : m_Blocks)
+        capacity += block.size;
+    return capacity;
+}
@@ -0,0 +1,76 @@
+#include "Ast.hpp"
+
+void Ast::reserve(std::size_t nodes)
+{
+    m_Kinds.reserve(nodes);
+    m_Flags.reserve(nodes);
+    m_Tokens.reserve(nodes);
+    m_Types.reserve(nodes);
+    m_Begins.reserve(nodes);
+    m_Ends.reserve(nodes);
+    m_FirstChildren.reserve(nodes);
+    m_LastChildren.reserve(nodes);
+    m_NextSiblings.reserve(nodes);
+}
+
+void Ast::clear()
+{
+    // the arrays live in the arena, they go before it is reset
+    m_Kinds = std::pmr::vector<NodeKind>{&m_Arena};
+    m_Flags = std::pmr::vector<uint16_t>{&m_Arena};
+    m_Tokens = std::pmr::vector<uint32_t>{&m_Arena};
+    m_Types = std::pmr::vector<uint32_t>{&m_Arena};
+    m_Begins = std::pmr::vector<uint32_t>{&m_Arena};
+    m_Ends = std::pmr::vector<uint32_t>{&m_Arena};
+    m_FirstChildren = std::pmr::vector<uint32_t>{&m_Arena};
+    m_LastChildren = std::pmr::vector<uint32_t>{&m_Arena};
+    m_NextSiblings = std::pmr::vector<uint32_t>{&m_Arena};
+    m_Arena.reset();
+}
+
+uint32_t Ast::add(NodeKind kind, uint32_t token, uint32_t begin)
+{
+    auto node{static_cast<uint32_t>(m_Kinds.size())};
+    m_Kinds.push_back(kind);
+    m_Flags.push_back(0);
+    m_Tokens.push_back(token);
+    m_Types.push_back(NO_TOKEN);
+    m_Begins.push_back(begin);
+    m_Ends.push_back(begin);
+    m_FirstChildren.push_back(NO_NODE);
+    m_LastChildren.push_back(NO_NODE);
+    m_NextSiblings.push_back(NO_NODE);
+    return node;
+}
+
+void Ast::addChild(uint32_t parent, uint32_t child)
+{
+    if (m_FirstChildren[parent] == NO_NODE)
+        m_FirstChildren[parent] = child;
+    else
+        m_NextSiblings[m_LastChildren[parent]] = child;
+    m_LastChildren[parent] = child;
+}
+
+void Ast::dropChildren(uint32_t node)
+{
+    // the children stay in the arrays, nothing reaches them any more
+    m_FirstChildren[node] = NO_NODE;
+    m_LastChildren[node] = NO_NODE;
+}
+
+std::size_t Ast::childCount(uint32_t node) const
+{
+    std::size_t count{0};
+    for (uint32_t c{m_FirstChildren[node]}; c != NO_NODE; c = m_NextSiblings[c])
+        ++count;
+    return count;
+}
+
+uint32_t Ast::child(uint32_t node, std::size_t index) const
+{
+    uint32_t c{m_FirstChildren[node]};
+    for (; c != NO_NODE && index > 0; --index)
+        c = m_NextSiblings[c];
+    return c;
+}
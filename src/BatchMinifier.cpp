@@ -0,0 +1,397 @@
+#include "BatchMinifier.hpp"
+#include "DeflateEstimator.hpp"
+#include "MappedFile.hpp"
+#include "Minifier.hpp"
+#include "OutputSink.hpp"
+#include "Scanner.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <numeric>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace
+{
+constexpr std::string_view SHADER_EXTENSIONS[]{".glsl", ".vert", ".frag", ".geom", ".comp", ".tesc", ".tese"};
+
+// name.min.ext is what a batch without an output root writes, it is never an input
+bool isOutputName(const std::filesystem::path& path)
+{
+    std::string stem{path.stem().string()};
+    return stem.length() >= 4 && stem.compare(stem.length() - 4, 4, ".min") == 0;
+}
+
+bool isShaderFile(const std::filesystem::path& path)
+{
+    std::string extension{path.extension().string()};
+    return std::find(std::begin(SHADER_EXTENSIONS), std::end(SHADER_EXTENSIONS), extension) !=
+        std::end(SHADER_EXTENSIONS) && !isOutputName(path);
+}
+
+// * and ? stay inside one directory, ** crosses any number of them, **/ none as well
+bool matchGlob(std::string_view pattern, std::string_view path)
+{
+    while (!pattern.empty())
+    {
+        if (pattern.substr(0, 2) == "**")
+        {
+            pattern.remove_prefix(2);
+            if (!pattern.empty() && pattern[0] == '/' && matchGlob(pattern.substr(1), path))
+                return true;
+            for (std::size_t i{0}; i <= path.length(); ++i)
+            {
+                if (matchGlob(pattern, path.substr(i)))
+                    return true;
+            }
+            return false;
+        }
+
+        if (pattern[0] == '*')
+        {
+            pattern.remove_prefix(1);
+            for (std::size_t i{0}; i <= path.length(); ++i)
+            {
+                if (matchGlob(pattern, path.substr(i)))
+                    return true;
+                if (i < path.length() && path[i] == '/')
+                    break;
+            }
+            return false;
+        }
+
+        if (path.empty() || (pattern[0] == '?' ? path[0] == '/' : pattern[0] != path[0]))
+            return false;
+        pattern.remove_prefix(1);
+        path.remove_prefix(1);
+    }
+    return path.empty();
+}
+
+// the regular files below base, the output root is not gone into
+template <typename Function>
+bool walk(const std::filesystem::path& base, bool recursive, const std::string& outputRoot, Function function)
+{
+    std::error_code error;
+    std::filesystem::recursive_directory_iterator it{base,
+                                                     std::filesystem::directory_options::skip_permission_denied,
+                                                     error};
+    if (error)
+        return false;
+
+    for (; it != std::filesystem::recursive_directory_iterator{}; it.increment(error))
+    {
+        if (error)
+            return false;
+
+        if (it->is_directory(error))
+        {
+            if (!recursive || (!outputRoot.empty() && std::filesystem::equivalent(it->path(), outputRoot, error)))
+                it.disable_recursion_pending();
+            continue;
+        }
+        if (it->is_regular_file(error))
+            function(it->path());
+    }
+    return true;
+}
+
+std::string outputFor(const std::filesystem::path& input, const std::filesystem::path& base,
+                      const std::string& outputRoot)
+{
+    if (outputRoot.empty())
+    {
+        std::filesystem::path output{input};
+        output.replace_extension();
+        output += ".min";
+        output += input.extension();
+        return output.string();
+    }
+
+    // an input outside base, like ../a/x.glsl in a manifest, keeps its path without the leading ..
+    std::filesystem::path relative{input.lexically_relative(base)};
+    if (relative.empty())
+        relative = input.relative_path();
+    auto part{relative.begin()};
+    while (part != relative.end() && *part == "..")
+        ++part;
+    std::filesystem::path kept;
+    for (; part != relative.end(); ++part)
+        kept /= *part;
+    if (kept.empty())
+        kept = input.filename();
+    return (std::filesystem::path{outputRoot} / kept).lexically_normal().string();
+}
+
+// what one thread keeps from file to file, the scanner reports to errors so it must not move
+struct Worker
+{
+    MappedFile source; // small files are read into its buffer, which stays
+    ErrorReporter errors;
+    Scanner scanner{std::string_view{}, &errors};
+    Minifier minifier{TokenBuffer{}};
+    TokenBuffer spare;
+
+    explicit Worker(const MinifyOptions& options)
+    {
+        errors.setMaxErrors(options.maxErrors);
+        minifier.setVerbose(false);
+        minifier.setRename(options.rename);
+        minifier.setRemoveDeadCode(options.removeDeadCode);
+        minifier.setFoldConstants(options.foldConstants);
+        minifier.setSearch(options.searchMs, options.searchSteps, options.seed);
+    }
+
+    Worker(const Worker&) = delete;
+    Worker& operator=(const Worker&) = delete;
+};
+
+void minifyFile(const BatchMinifier::Job& job, BatchMinifier::FileResult& result, const MinifyOptions& options,
+                Worker& worker)
+{
+    MappedFile& source{worker.source};
+    if (!source.open(job.input))
+    {
+        result.errors = "Error: Could not open file " + job.input + '\n';
+        return;
+    }
+
+    worker.errors.clear();
+    worker.scanner.reset(source.view(), std::move(worker.spare));
+    TokenBuffer tokens{worker.scanner.scan()};
+
+    // rendered while the source is still mapped, the errors point into it
+    if (worker.errors.hasErrors())
+    {
+        std::ostringstream text;
+        worker.errors.print(text, text);
+        result.errors = text.str();
+    }
+    if (worker.errors.hasFatalErrors())
+    {
+        worker.spare = std::move(tokens);
+        return;
+    }
+    worker.spare = worker.minifier.reset(std::move(tokens));
+    worker.minifier.setOriginalSize(source.size());
+
+    std::error_code error;
+    std::filesystem::path parent{std::filesystem::path{job.output}.parent_path()};
+    if (!parent.empty())
+        std::filesystem::create_directories(parent, error);
+    // written next to the target and renamed over it once complete, a failed file leaves no half output behind
+    ReplacementFile output;
+    if (!output.open(job.output))
+    {
+        result.errors += "Error: Could not write to file " + job.output + '\n';
+        return;
+    }
+
+    FdSink file{output.fd()};
+    DeflateEstimator deflated;
+    CallbackSink sink{
+        [&](std::string_view block)
+        {
+            file.write(block);
+            if (options.deflatedSize)
+                deflated.add(block);
+        }
+    };
+    worker.minifier.minify(sink);
+    if (options.deflatedSize)
+        worker.minifier.setDeflatedSize(deflated.finish());
+
+    if (file.failed() || !output.commit())
+    {
+        result.errors += "Error: Could not write to file " + job.output + '\n';
+        return;
+    }
+    result.stats = worker.minifier.getStats();
+    result.ok = true;
+}
+}
+
+std::vector<BatchMinifier::Job> BatchMinifier::collectJobs(const std::string& inputs, const std::string& outputRoot,
+                                                           std::string& errors)
+{
+    std::vector<std::filesystem::path> paths;
+    std::filesystem::path base;
+    std::error_code error;
+
+    if (inputs.find_first_of("*?") != std::string::npos)
+    {
+        // the directories before the first wildcard are walked, the rest is matched against the paths below them
+        std::size_t slash{inputs.rfind('/', inputs.find_first_of("*?"))};
+        base = slash == std::string::npos ? "." : inputs.substr(0, std::max<std::size_t>(slash, 1));
+        std::string pattern{slash == std::string::npos ? inputs : inputs.substr(slash + 1)};
+        bool recursive{pattern.find('/') != std::string::npos || pattern.find("**") != std::string::npos};
+
+        bool read{walk(base, recursive, outputRoot, [&](const std::filesystem::path& path)
+        {
+            if (!isOutputName(path) && matchGlob(pattern, path.lexically_relative(base).generic_string()))
+                paths.push_back(path);
+        })};
+        if (!read)
+        {
+            errors += "Error: Could not read directory " + base.string() + '\n';
+            return {};
+        }
+        std::sort(paths.begin(), paths.end());
+    }
+    else if (std::filesystem::is_directory(inputs, error))
+    {
+        base = inputs;
+        bool read{walk(base, true, outputRoot, [&](const std::filesystem::path& path)
+        {
+            if (isShaderFile(path))
+                paths.push_back(path);
+        })};
+        if (!read)
+        {
+            errors += "Error: Could not read directory " + inputs + '\n';
+            return {};
+        }
+        std::sort(paths.begin(), paths.end());
+    }
+    else
+    {
+        // a manifest, one input per line in the order they are listed
+        MappedFile manifest;
+        if (!manifest.open(inputs))
+        {
+            errors += "Error: Could not open file " + inputs + '\n';
+            return {};
+        }
+        base = std::filesystem::path{inputs}.parent_path();
+
+        std::string_view lines{manifest.view()};
+        while (!lines.empty())
+        {
+            std::size_t newline{lines.find('\n')};
+            std::string_view line{lines.substr(0, newline)};
+            lines.remove_prefix(newline == std::string_view::npos ? lines.length() : newline + 1);
+
+            std::size_t first{line.find_first_not_of(" \t\r")};
+            if (first == std::string_view::npos || line.substr(first, 2) == "//")
+                continue;
+            line = line.substr(first, line.find_last_not_of(" \t\r") + 1 - first);
+
+            std::filesystem::path path{std::string{line}};
+            paths.push_back(path.is_relative() ? base / path : path);
+        }
+    }
+
+    // two jobs writing one file would race, like an input listed twice or ../x.glsl and ../../x.glsl,
+    // and an output that is an input, like minify-batch dir dir, would replace a file another job reads
+    // paths are compared resolved, so links and .. do not hide a clash
+    auto resolved{
+        [](const std::filesystem::path& path)
+        {
+            std::error_code resolveError;
+            std::filesystem::path full{std::filesystem::weakly_canonical(path, resolveError)};
+            if (resolveError)
+                return std::filesystem::absolute(path, resolveError).lexically_normal().string();
+            return full.string();
+        }
+    };
+    std::vector<Job> jobs;
+    jobs.reserve(paths.size());
+    std::unordered_set<std::string> inputPaths;
+    for (const std::filesystem::path& path : paths)
+        inputPaths.insert(resolved(path));
+
+    std::unordered_map<std::string, std::size_t> outputs;
+    bool clash{false};
+    for (const std::filesystem::path& path : paths)
+    {
+        Job job{path.string(), outputFor(path, base, outputRoot)};
+        std::string output{resolved(job.output)};
+        if (inputPaths.count(output) != 0)
+        {
+            clash = true;
+            errors += "Error: " + job.input + " writes " + job.output + ", which is an input\n";
+        }
+        auto [it, inserted]{outputs.try_emplace(std::move(output), jobs.size())};
+        if (!inserted)
+        {
+            clash = true;
+            errors += "Error: " + jobs[it->second].input + " and " + job.input + " both write " + job.output + '\n';
+        }
+        jobs.push_back(std::move(job));
+    }
+    if (clash)
+        return {};
+    return jobs;
+}
+
+void BatchMinifier::run(std::vector<Job> jobs, const MinifyOptions& options, unsigned threads)
+{
+    m_Jobs = std::move(jobs);
+    m_Results.assign(m_Jobs.size(), FileResult{});
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    m_Threads = static_cast<unsigned>(std::max<std::size_t>(1, std::min<std::size_t>(threads, m_Jobs.size())));
+
+    // the biggest files first, so the last ones to start are small and the threads finish together
+    std::vector<uintmax_t> sizes(m_Jobs.size(), 0);
+    for (std::size_t i{0}; i < m_Jobs.size(); ++i)
+    {
+        std::error_code error;
+        uintmax_t size{std::filesystem::file_size(m_Jobs[i].input, error)};
+        sizes[i] = error ? 0 : size;
+    }
+    std::vector<std::size_t> order(m_Jobs.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) { return sizes[a] > sizes[b]; });
+
+    m_Total = MinificationStats{};
+    m_Total.startTiming();
+
+    // files are handed out one at a time, a thread never waits for another
+    std::atomic<std::size_t> next{0};
+    auto work{
+        [&]()
+        {
+            Worker worker{options};
+            for (std::size_t i{next++}; i < order.size(); i = next++)
+                minifyFile(m_Jobs[order[i]], m_Results[order[i]], options, worker);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve(m_Threads - 1);
+    for (unsigned i{1}; i < m_Threads; ++i)
+        pool.emplace_back(work);
+    work();
+    for (auto& thread : pool)
+        thread.join();
+
+    m_Total.stopTiming();
+    for (const FileResult& result : m_Results)
+        m_Total.add(result.stats);
+}
+
+std::size_t BatchMinifier::getFailedCount() const
+{
+    return static_cast<std::size_t>(std::count_if(m_Results.begin(), m_Results.end(),
+                                                  [](const FileResult& result) { return !result.ok; }));
+}
+
+void BatchMinifier::print() const
+{
+    for (std::size_t i{0}; i < m_Jobs.size(); ++i)
+    {
+        if (!m_Results[i].errors.empty())
+            std::cerr << m_Jobs[i].input << ":\n" << m_Results[i].errors << '\n';
+    }
+
+    std::cout << "Files:\t\t\t" << m_Jobs.size() << '\n';
+    std::cout << "Failed:\t\t\t" << getFailedCount() << '\n';
+    std::cout << "Threads:\t\t" << m_Threads << '\n';
+    if (m_Total.getProcessingTimeMs() > 0)
+        std::cout << "Files per second:\t" << m_Jobs.size() / (m_Total.getProcessingTimeMs() / 1000.0) << '\n';
+    m_Total.print();
+}
@@ -0,0 +1,1202 @@
+#include "ConstantFolder.hpp"
+#include "Keywords.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+
+namespace
+{
+    // deeper expressions are left as they are, a long a + b + c + .. chain is one level per operator
+    constexpr int MAX_DEPTH{256};
+
+    struct DepthGuard
+    {
+        int& depth;
+
+        explicit DepthGuard(int& d) : depth{++d}
+        {
+        }
+
+        ~DepthGuard() { --depth; }
+    };
+
+    bool isBoolWord(std::string_view word)
+    {
+        return word == "true" || word == "false";
+    }
+
+    // a result the compiler may flush or that has no literal is not folded
+    bool isPlainFloat(float value)
+    {
+        return value == 0 || std::isnormal(value);
+    }
+
+    int swizzleIndex(char c)
+    {
+        constexpr std::string_view SETS[]{"xyzw", "rgba", "stpq"};
+        for (int set{0}; set < 3; ++set)
+        {
+            std::size_t at{SETS[set].find(c)};
+            if (at != std::string_view::npos)
+                return set * 4 + static_cast<int>(at);
+        }
+        return -1;
+    }
+}
+
+bool ConstantFolder::describeType(TokenType type, std::string_view name, BaseType& base, int& size)
+{
+    switch (type)
+    {
+    case TokenType::FLOAT:
+    case TokenType::VEC2:
+    case TokenType::VEC3:
+    case TokenType::VEC4:
+        base = BaseType::FLOAT;
+        size = type == TokenType::FLOAT ? 1 : static_cast<int>(type) - static_cast<int>(TokenType::VEC2) + 2;
+        return true;
+    case TokenType::INT:
+    case TokenType::IVEC2:
+    case TokenType::IVEC3:
+    case TokenType::IVEC4:
+        base = BaseType::INT;
+        size = type == TokenType::INT ? 1 : static_cast<int>(type) - static_cast<int>(TokenType::IVEC2) + 2;
+        return true;
+    case TokenType::BOOL:
+    case TokenType::BVEC2:
+    case TokenType::BVEC3:
+    case TokenType::BVEC4:
+        base = BaseType::BOOL;
+        size = type == TokenType::BOOL ? 1 : static_cast<int>(type) - static_cast<int>(TokenType::BVEC2) + 2;
+        return true;
+    case TokenType::MAT2:
+    case TokenType::MAT3:
+    case TokenType::MAT4:
+        base = BaseType::FLOAT;
+        size = 0;
+        return true;
+    case TokenType::TYPE:
+        if (name == "uint")
+        {
+            base = BaseType::UINT;
+            size = 1;
+            return true;
+        }
+        if (name.length() == 5 && name.substr(0, 4) == "uvec" && name[4] >= '2' && name[4] <= '4')
+        {
+            base = BaseType::UINT;
+            size = name[4] - '0';
+            return true;
+        }
+        if (name.substr(0, 3) == "mat")
+        {
+            base = BaseType::FLOAT;
+            size = 0;
+            return true;
+        }
+        return false;
+    default:
+        return false;
+    }
+}
+
+bool ConstantFolder::unary(TokenType op, const Constant& operand, Constant& value)
+{
+    value = operand;
+    for (int i{0}; i < operand.size; ++i)
+    {
+        switch (op)
+        {
+        case TokenType::PLUS:
+            if (operand.type == BaseType::BOOL)
+                return false;
+            break;
+        case TokenType::MINUS:
+            if (operand.type == BaseType::BOOL)
+                return false;
+            value.floats[i] = -operand.floats[i];
+            value.bits[i] = 0u - operand.bits[i];
+            break;
+        case TokenType::BANG:
+            if (operand.type != BaseType::BOOL || operand.size != 1)
+                return false;
+            value.bits[i] = !operand.bits[i];
+            break;
+        case TokenType::TILDE:
+            if (operand.type != BaseType::INT && operand.type != BaseType::UINT)
+                return false;
+            value.bits[i] = ~operand.bits[i];
+            break;
+        default:
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ConstantFolder::binary(TokenType op, bool logicalXor, const Constant& left, const Constant& right,
+                            Constant& value)
+{
+    bool scalars{left.size == 1 && right.size == 1};
+    bool sameType{left.type == right.type};
+
+    if (logicalXor || op == TokenType::AMPERSAND_AMPERSAND || op == TokenType::PIPE_PIPE)
+    {
+        if (!scalars || left.type != BaseType::BOOL || !sameType)
+            return false;
+        bool a{left.bits[0] != 0};
+        bool b{right.bits[0] != 0};
+        value = {BaseType::BOOL, 1};
+        value.bits[0] = logicalXor ? a != b : op == TokenType::PIPE_PIPE ? a || b : a && b;
+        return true;
+    }
+
+    if (op == TokenType::EQUAL_EQUAL || op == TokenType::BANG_EQUAL)
+    {
+        if (!sameType || left.size != right.size)
+            return false;
+        bool equal{true};
+        for (int i{0}; i < left.size; ++i)
+        {
+            equal = equal && (left.type == BaseType::FLOAT ? left.floats[i] == right.floats[i]
+                                                            : left.bits[i] == right.bits[i]);
+        }
+        value = {BaseType::BOOL, 1};
+        value.bits[0] = equal == (op == TokenType::EQUAL_EQUAL);
+        return true;
+    }
+
+    if (op == TokenType::LESS || op == TokenType::LESS_EQUAL || op == TokenType::GREATER ||
+        op == TokenType::GREATER_EQUAL)
+    {
+        if (!scalars || !sameType || left.type == BaseType::BOOL)
+            return false;
+        // -1, 0 or 1, in the operands' own type
+        int order{0};
+        if (left.type == BaseType::FLOAT)
+            order = (left.floats[0] > right.floats[0]) - (left.floats[0] < right.floats[0]);
+        else if (left.type == BaseType::INT)
+        {
+            auto a{static_cast<int32_t>(left.bits[0])};
+            auto b{static_cast<int32_t>(right.bits[0])};
+            order = (a > b) - (a < b);
+        }
+        else
+            order = (left.bits[0] > right.bits[0]) - (left.bits[0] < right.bits[0]);
+        value = {BaseType::BOOL, 1};
+        value.bits[0] = op == TokenType::LESS ? order < 0 : op == TokenType::LESS_EQUAL ? order <= 0
+                        : op == TokenType::GREATER ? order > 0 : order >= 0;
+        return true;
+    }
+
+    // componentwise, a scalar goes with every component of a vector
+    bool shift{op == TokenType::LESS_LESS || op == TokenType::GREATER_GREATER};
+    if (left.type == BaseType::BOOL || right.type == BaseType::BOOL)
+        return false;
+    if (shift ? left.type == BaseType::FLOAT || right.type == BaseType::FLOAT : !sameType)
+        return false;
+    if (left.size != right.size && left.size != 1 && right.size != 1)
+        return false;
+    if (shift && left.size == 1 && right.size != 1)
+        return false;
+
+    value = {left.type, std::max(left.size, right.size)};
+    for (int i{0}; i < value.size; ++i)
+    {
+        int l{left.size == 1 ? 0 : i};
+        int r{right.size == 1 ? 0 : i};
+        if (left.type == BaseType::FLOAT)
+        {
+            float a{left.floats[l]};
+            float b{right.floats[r]};
+            float result{};
+            switch (op)
+            {
+            case TokenType::PLUS:
+                result = a + b;
+                break;
+            case TokenType::MINUS:
+                result = a - b;
+                break;
+            case TokenType::STAR:
+                result = a * b;
+                break;
+            case TokenType::SLASH:
+                if (b == 0)
+                    return false;
+                result = a / b;
+                break;
+            default:
+                return false;
+            }
+            if (!isPlainFloat(result))
+                return false;
+            value.floats[i] = result;
+            continue;
+        }
+
+        uint32_t a{left.bits[l]};
+        uint32_t b{right.bits[r]};
+        bool isSigned{left.type == BaseType::INT};
+        auto sa{static_cast<int32_t>(a)};
+        auto sb{static_cast<int32_t>(b)};
+        uint32_t result{};
+        switch (op)
+        {
+        case TokenType::PLUS:
+            result = a + b;
+            break;
+        case TokenType::MINUS:
+            result = a - b;
+            break;
+        case TokenType::STAR:
+            result = a * b;
+            break;
+        case TokenType::SLASH:
+            if (b == 0 || (isSigned && sa == INT32_MIN && sb == -1))
+                return false;
+            result = isSigned ? static_cast<uint32_t>(sa / sb) : a / b;
+            break;
+        case TokenType::PERCENT:
+            // undefined for negative operands
+            if (b == 0 || (isSigned && (sa < 0 || sb < 0)))
+                return false;
+            result = a % b;
+            break;
+        case TokenType::AMPERSAND:
+            result = a & b;
+            break;
+        case TokenType::PIPE:
+            result = a | b;
+            break;
+        case TokenType::CARET:
+            result = a ^ b;
+            break;
+        case TokenType::LESS_LESS:
+        case TokenType::GREATER_GREATER:
+            {
+                // undefined for a negative count or one past the bits
+                bool negative{right.type == BaseType::INT && sb < 0};
+                if (negative || b >= 32)
+                    return false;
+                if (op == TokenType::LESS_LESS)
+                    result = a << b;
+                else
+                    result = isSigned ? static_cast<uint32_t>(sa >> b) : a >> b;
+                break;
+            }
+        default:
+            return false;
+        }
+        value.bits[i] = result;
+    }
+    return true;
+}
+
+bool ConstantFolder::construct(BaseType base, int size, const Constant* args, int count, Constant& value)
+{
+    if (size < 1 || count < 1)
+        return false;
+
+    // one scalar fills a vector, anything else is taken component by component and every argument has to be used
+    int total{0};
+    for (int a{0}; a < count; ++a)
+        total += args[a].size;
+    bool splat{count == 1 && args[0].size == 1};
+    if (!splat && (total < size || total - args[count - 1].size >= size))
+        return false;
+
+    value = {base, size};
+    int arg{0};
+    int component{0};
+    for (int i{0}; i < size; ++i)
+    {
+        const Constant& from{args[arg]};
+        int at{splat ? 0 : component};
+        float f{from.floats[at]};
+        uint32_t bits{from.bits[at]};
+        switch (base)
+        {
+        case BaseType::FLOAT:
+            value.floats[i] = from.type == BaseType::FLOAT ? f
+                              : from.type == BaseType::INT ? static_cast<float>(static_cast<int32_t>(bits))
+                              : static_cast<float>(bits);
+            break;
+        case BaseType::INT:
+            if (from.type == BaseType::FLOAT)
+            {
+                // out of range is undefined
+                if (!(f > -2147483904.0f && f < 2147483648.0f))
+                    return false;
+                value.bits[i] = static_cast<uint32_t>(static_cast<int32_t>(f));
+            }
+            else
+                value.bits[i] = bits;
+            break;
+        case BaseType::UINT:
+            if (from.type == BaseType::FLOAT)
+            {
+                if (!(f > -1.0f && f < 4294967296.0f))
+                    return false;
+                value.bits[i] = static_cast<uint32_t>(f);
+            }
+            else
+                value.bits[i] = bits;
+            break;
+        case BaseType::BOOL:
+            value.bits[i] = from.type == BaseType::FLOAT ? f != 0 : bits != 0;
+            break;
+        default:
+            return false;
+        }
+
+        if (!splat && ++component == from.size)
+        {
+            ++arg;
+            component = 0;
+        }
+    }
+    return true;
+}
+
+bool ConstantFolder::hasDirective(uint32_t node) const
+{
+    if (m_Directives.empty())
+        return false;
+    auto it{std::lower_bound(m_Directives.begin(), m_Directives.end(), m_Ast->begin(node))};
+    return it != m_Directives.end() && *it < m_Ast->end(node);
+}
+
+int ConstantFolder::subtreeSize(uint32_t node)
+{
+    int size{0};
+    m_Stack.clear();
+    m_Stack.push_back(node);
+    while (!m_Stack.empty())
+    {
+        uint32_t at{m_Stack.back()};
+        m_Stack.pop_back();
+        ++size;
+        for (uint32_t c{m_Ast->firstChild(at)}; c != Ast::NO_NODE; c = m_Ast->nextSibling(c))
+            m_Stack.push_back(c);
+    }
+    return size;
+}
+
+uint32_t ConstantFolder::lookup(uint32_t id) const
+{
+    return m_Active[id] == NO_BINDING ? Ast::NO_TOKEN : m_Names[m_Active[id]].type;
+}
+
+void ConstantFolder::declare(uint32_t id, uint32_t type)
+{
+    m_Names.push_back({id, type, m_Active[id]});
+    m_Active[id] = static_cast<uint32_t>(m_Names.size() - 1);
+}
+
+void ConstantFolder::closeScope(std::size_t size)
+{
+    while (m_Names.size() > size)
+    {
+        m_Active[m_Names.back().id] = m_Names.back().shadowed;
+        m_Names.pop_back();
+    }
+}
+
+ConstantFolder::BaseType ConstantFolder::typeOf(uint32_t node, int depth) const
+{
+    const Ast& ast{*m_Ast};
+    const TokenBuffer& tokens{*m_Tokens};
+    if (depth > MAX_DEPTH)
+        return BaseType::UNKNOWN;
+
+    BaseType base{BaseType::UNKNOWN};
+    int size{0};
+    uint32_t first{ast.firstChild(node)};
+    switch (ast.kind(node))
+    {
+    case NodeKind::LITERAL:
+        {
+            Constant value;
+            return readLiteral(ast.token(node), value) ? value.type : BaseType::UNKNOWN;
+        }
+    case NodeKind::NAME:
+        {
+            uint32_t type{lookup(tokens.id(ast.token(node)))};
+            if (type == Ast::NO_TOKEN || !describeType(tokens.type(type), tokens.lexeme(type), base, size))
+                return BaseType::UNKNOWN;
+            return base;
+        }
+    case NodeKind::CALL:
+        if (ast.flags(node) & FLAG_METHOD)
+            return BaseType::INT;
+        if (!describeType(tokens.type(ast.token(node)), tokens.lexeme(ast.token(node)), base, size))
+            return BaseType::UNKNOWN;
+        return base;
+    case NodeKind::UNARY:
+        return tokens.type(ast.token(node)) == TokenType::BANG ? BaseType::BOOL : typeOf(first, depth + 1);
+    // a swizzle or an index keeps the base type, a struct field has none that is known
+    case NodeKind::GROUP:
+    case NodeKind::POSTFIX:
+    case NodeKind::MEMBER:
+    case NodeKind::INDEX:
+    case NodeKind::ASSIGNMENT:
+        return typeOf(first, depth + 1);
+    case NodeKind::SEQUENCE:
+        return typeOf(ast.nextSibling(first), depth + 1);
+    case NodeKind::TERNARY:
+        {
+            uint32_t then{ast.nextSibling(first)};
+            BaseType a{typeOf(then, depth + 1)};
+            return a == typeOf(ast.nextSibling(then), depth + 1) ? a : BaseType::UNKNOWN;
+        }
+    case NodeKind::BINARY:
+        {
+            switch (tokens.type(ast.token(node)))
+            {
+            case TokenType::EQUAL_EQUAL:
+            case TokenType::BANG_EQUAL:
+            case TokenType::LESS:
+            case TokenType::LESS_EQUAL:
+            case TokenType::GREATER:
+            case TokenType::GREATER_EQUAL:
+            case TokenType::AMPERSAND_AMPERSAND:
+            case TokenType::PIPE_PIPE:
+                return BaseType::BOOL;
+            default:
+                break;
+            }
+            BaseType a{typeOf(first, depth + 1)};
+            if (tokens.type(ast.token(node)) == TokenType::LESS_LESS ||
+                tokens.type(ast.token(node)) == TokenType::GREATER_GREATER)
+                return a;
+            BaseType b{typeOf(ast.nextSibling(first), depth + 1)};
+            if (a == b)
+                return a;
+            // desktop GLSL turns an int operand into a float
+            bool numeric{(a == BaseType::INT || a == BaseType::UINT) && (b == BaseType::INT || b == BaseType::UINT)};
+            if ((a == BaseType::FLOAT || b == BaseType::FLOAT) && !numeric && a != BaseType::UNKNOWN &&
+                b != BaseType::UNKNOWN && a != BaseType::BOOL && b != BaseType::BOOL)
+                return BaseType::FLOAT;
+            return BaseType::UNKNOWN;
+        }
+    default:
+        return BaseType::UNKNOWN;
+    }
+}
+
+bool ConstantFolder::readLiteral(uint32_t token, Constant& value) const
+{
+    const TokenBuffer& tokens{*m_Tokens};
+    std::string_view lexeme{tokens.lexeme(token)};
+    value = {BaseType::UNKNOWN, 1};
+    if (tokens.type(token) == TokenType::KEYWORD)
+    {
+        if (!isBoolWord(lexeme))
+            return false;
+        value.type = BaseType::BOOL;
+        value.bits[0] = lexeme == "true";
+        return true;
+    }
+    if (tokens.type(token) != TokenType::NUMBER || lexeme.empty())
+        return false;
+
+    bool hex{lexeme.length() > 1 && lexeme[0] == '0' && (lexeme[1] == 'x' || lexeme[1] == 'X')};
+    if (!hex && lexeme.find_first_of(".eEfF") != std::string_view::npos)
+    {
+        // doubles are not folded
+        std::size_t length{lexeme.length()};
+        if (length > 2 && (lexeme.substr(length - 2) == "lf" || lexeme.substr(length - 2) == "LF"))
+            return false;
+        if (lexeme.back() == 'f' || lexeme.back() == 'F')
+            --length;
+        float f{};
+        auto [end, error]{std::from_chars(lexeme.data(), lexeme.data() + length, f)};
+        if (error != std::errc{} || end != lexeme.data() + length || !isPlainFloat(f))
+            return false;
+        // 1e-50 is 0 after underflow, which the compiler may do differently
+        if (f == 0 && lexeme.substr(0, lexeme.find_first_of("eE")).find_first_of("123456789") != std::string_view::npos)
+            return false;
+        value.type = BaseType::FLOAT;
+        value.floats[0] = f;
+        return true;
+    }
+
+    bool isUnsigned{lexeme.back() == 'u' || lexeme.back() == 'U'};
+    std::string_view digits{lexeme.substr(0, lexeme.length() - isUnsigned)};
+    int base{10};
+    if (hex)
+    {
+        base = 16;
+        digits.remove_prefix(2);
+    }
+    else if (digits.length() > 1 && digits[0] == '0')
+        base = 8;
+
+    uint64_t number{0};
+    auto [end, error]{std::from_chars(digits.data(), digits.data() + digits.length(), number, base)};
+    if (error != std::errc{} || end != digits.data() + digits.length() || number > UINT32_MAX)
+        return false;
+    // a decimal int past INT32_MAX is an error, hex and octal ones are the bits
+    if (!isUnsigned && base == 10 && number > INT32_MAX)
+        return false;
+    value.type = isUnsigned ? BaseType::UINT : BaseType::INT;
+    value.bits[0] = static_cast<uint32_t>(number);
+    return true;
+}
+
+bool ConstantFolder::evaluate(uint32_t node, Constant& value)
+{
+    bool dryRun{m_DryRun};
+    m_DryRun = true;
+    bool constant{fold(node, value)};
+    m_DryRun = dryRun;
+    return constant;
+}
+
+bool ConstantFolder::fold(uint32_t node, Constant& value)
+{
+    const Ast& ast{*m_Ast};
+    const TokenBuffer& tokens{*m_Tokens};
+    DepthGuard guard{m_Depth};
+    if (m_Depth > MAX_DEPTH)
+        return false;
+    if (hasDirective(node))
+    {
+        foldChildren(node);
+        return false;
+    }
+
+    uint32_t first{ast.firstChild(node)};
+    switch (ast.kind(node))
+    {
+    case NodeKind::LITERAL:
+        return readLiteral(ast.token(node), value);
+    case NodeKind::NAME:
+        if (tokens.id(ast.token(node)) != m_LoopName)
+            return false;
+        value = m_LoopValue;
+        return true;
+    case NodeKind::GROUP:
+        return first != Ast::NO_NODE && fold(first, value);
+    case NodeKind::UNARY:
+        {
+            Constant operand;
+            TokenType op{tokens.type(ast.token(node))};
+            if (op == TokenType::PLUS_PLUS || op == TokenType::MINUS_MINUS)
+            {
+                foldChildren(node);
+                return false;
+            }
+            if (!fold(first, operand))
+                return false;
+            if (unary(op, operand, value))
+                return true;
+            replace(first, operand);
+            return false;
+        }
+    case NodeKind::BINARY:
+        return foldBinary(node, value);
+    case NodeKind::TERNARY:
+        return foldTernary(node, value);
+    case NodeKind::CALL:
+        return foldCall(node, value);
+    case NodeKind::MEMBER:
+        {
+            // a swizzle of a constant vector
+            Constant object;
+            if (!fold(first, object))
+                return false;
+            std::string_view field{tokens.lexeme(ast.token(node))};
+            bool swizzle{object.size > 1 && !field.empty() && field.length() <= 4};
+            int set{swizzle ? swizzleIndex(field[0]) / 4 : -1};
+            value = {object.type, static_cast<int>(field.length())};
+            for (std::size_t i{0}; swizzle && i < field.length(); ++i)
+            {
+                int index{swizzleIndex(field[i])};
+                swizzle = index >= 0 && index / 4 == set && index % 4 < object.size;
+                if (swizzle)
+                {
+                    value.floats[i] = object.floats[index % 4];
+                    value.bits[i] = object.bits[index % 4];
+                }
+            }
+            if (swizzle)
+                return true;
+            replace(first, object);
+            return false;
+        }
+    case NodeKind::INDEX:
+        {
+            Constant object;
+            Constant index;
+            uint32_t second{ast.nextSibling(first)};
+            bool objectConstant{fold(first, object)};
+            bool indexConstant{fold(second, index)};
+            if (objectConstant && indexConstant && object.size > 1 && index.size == 1 &&
+                (index.type == BaseType::INT || index.type == BaseType::UINT) &&
+                index.bits[0] < static_cast<uint32_t>(object.size))
+            {
+                value = {object.type, 1};
+                value.floats[0] = object.floats[index.bits[0]];
+                value.bits[0] = object.bits[index.bits[0]];
+                return true;
+            }
+            if (objectConstant)
+                replace(first, object);
+            if (indexConstant)
+                replace(second, index);
+            return false;
+        }
+    default:
+        foldChildren(node);
+        return false;
+    }
+}
+
+void ConstantFolder::foldExpression(uint32_t node)
+{
+    Constant value;
+    if (fold(node, value))
+        replace(node, value);
+}
+
+void ConstantFolder::foldChildren(uint32_t node)
+{
+    for (uint32_t c{m_Ast->firstChild(node)}; c != Ast::NO_NODE; c = m_Ast->nextSibling(c))
+        foldExpression(c);
+}
+
+bool ConstantFolder::foldBinary(uint32_t node, Constant& value)
+{
+    const Ast& ast{*m_Ast};
+    const TokenBuffer& tokens{*m_Tokens};
+    uint32_t left{ast.firstChild(node)};
+    uint32_t right{ast.nextSibling(left)};
+    uint32_t token{ast.token(node)};
+    TokenType op{tokens.type(token)};
+    bool logicalXor{op == TokenType::CARET && tokens.type(token + 1) == TokenType::CARET};
+
+    Constant l;
+    Constant r;
+    bool leftConstant{fold(left, l)};
+    bool rightConstant{fold(right, r)};
+    if (leftConstant && rightConstant && binary(op, logicalXor, l, r, value))
+        return true;
+
+    // x * 1.0, 1.0 * x, x / 1.0, x + 0.0, 0.0 + x, x - 0.0, x && true, x || false.. are x
+    // the constant is a scalar, so x keeps its size, and it has x's type, so x keeps its type
+    if (leftConstant != rightConstant && !m_DryRun)
+    {
+        const Constant& c{leftConstant ? l : r};
+        uint32_t other{leftConstant ? right : left};
+        bool one{c.type == BaseType::FLOAT ? c.floats[0] == 1 : c.bits[0] == 1};
+        bool zero{c.type == BaseType::FLOAT ? c.floats[0] == 0 && !std::signbit(c.floats[0]) : c.bits[0] == 0};
+        bool identity{false};
+        if (c.size == 1 && c.type == BaseType::BOOL)
+            identity = (op == TokenType::AMPERSAND_AMPERSAND && one) || (op == TokenType::PIPE_PIPE && zero);
+        else if (c.size == 1)
+        {
+            identity = (op == TokenType::STAR && one) || (op == TokenType::PLUS && zero) ||
+                (rightConstant && ((op == TokenType::SLASH && one) || (op == TokenType::MINUS && zero)));
+            identity = identity && typeOf(other, 0) == c.type;
+        }
+        if (identity)
+        {
+            if (rightConstant)
+                drop(ast.end(left), ast.end(node));
+            else
+                drop(ast.begin(node), ast.begin(right));
+            m_RemovedNodes += subtreeSize(leftConstant ? left : right) + 1;
+            return false;
+        }
+    }
+
+    if (leftConstant)
+        replace(left, l);
+    if (rightConstant)
+        replace(right, r);
+    return false;
+}
+
+bool ConstantFolder::foldTernary(uint32_t node, Constant& value)
+{
+    const Ast& ast{*m_Ast};
+    uint32_t condition{ast.firstChild(node)};
+    uint32_t then{ast.nextSibling(condition)};
+    uint32_t otherwise{ast.nextSibling(then)};
+
+    Constant c;
+    bool decided{fold(condition, c)};
+    uint32_t chosen{decided && c.type == BaseType::BOOL && c.size == 1 ? (c.bits[0] ? then : otherwise)
+                                                                      : Ast::NO_NODE};
+    // an assignment or a sequence would bind differently without the ?:
+    if (chosen != Ast::NO_NODE && ast.kind(chosen) != NodeKind::ASSIGNMENT && ast.kind(chosen) != NodeKind::SEQUENCE)
+    {
+        if (fold(chosen, value))
+            return true;
+        if (!m_DryRun)
+        {
+            drop(ast.begin(node), ast.begin(chosen));
+            drop(ast.end(chosen), ast.end(node));
+            m_RemovedNodes += subtreeSize(node) - subtreeSize(chosen);
+        }
+        return false;
+    }
+
+    if (decided)
+        replace(condition, c);
+    foldExpression(then);
+    foldExpression(otherwise);
+    return false;
+}
+
+bool ConstantFolder::foldCall(uint32_t node, Constant& value)
+{
+    const Ast& ast{*m_Ast};
+    const TokenBuffer& tokens{*m_Tokens};
+    uint32_t token{ast.token(node)};
+    BaseType base{BaseType::UNKNOWN};
+    int size{0};
+    uint32_t first{ast.firstChild(node)};
+
+    // vector and scalar constructors, not arrays, matrices or functions
+    bool constructor{!(ast.flags(node) & FLAG_METHOD) && ast.childCount(node) <= 4 &&
+        describeType(tokens.type(token), tokens.lexeme(token), base, size) && size > 0 &&
+        (first == Ast::NO_NODE || ast.kind(first) != NodeKind::ARRAY_SIZE)};
+    if (!constructor)
+    {
+        foldChildren(node);
+        return false;
+    }
+
+    Constant args[4];
+    bool constant[4]{};
+    int count{0};
+    bool all{true};
+    for (uint32_t c{first}; c != Ast::NO_NODE; c = ast.nextSibling(c), ++count)
+    {
+        constant[count] = fold(c, args[count]);
+        all = all && constant[count];
+    }
+    if (all && construct(base, size, args, count, value))
+        return true;
+
+    count = 0;
+    for (uint32_t c{first}; c != Ast::NO_NODE; c = ast.nextSibling(c), ++count)
+    {
+        if (constant[count])
+            replace(c, args[count]);
+    }
+    return false;
+}
+
+void ConstantFolder::foldStatement(uint32_t node, uint32_t parent)
+{
+    const Ast& ast{*m_Ast};
+    switch (ast.kind(node))
+    {
+    case NodeKind::BLOCK:
+        {
+            std::size_t scope{m_Names.size()};
+            for (uint32_t c{ast.firstChild(node)}; c != Ast::NO_NODE; c = ast.nextSibling(c))
+                foldStatement(c, node);
+            closeScope(scope);
+            break;
+        }
+    case NodeKind::DECLARATION:
+        foldDeclaration(node);
+        break;
+    case NodeKind::EXPRESSION_STATEMENT:
+    case NodeKind::RETURN:
+    case NodeKind::CASE:
+        foldChildren(node);
+        break;
+    case NodeKind::IF:
+        foldIf(node, parent);
+        break;
+    case NodeKind::FOR:
+    case NodeKind::WHILE:
+    case NodeKind::DO:
+        foldLoop(node, parent);
+        break;
+    case NodeKind::SWITCH:
+        {
+            uint32_t expression{ast.firstChild(node)};
+            foldExpression(expression);
+            uint32_t body{ast.nextSibling(expression)};
+            if (body != Ast::NO_NODE)
+                foldStatement(body, node);
+            break;
+        }
+    default:
+        break;
+    }
+}
+
+void ConstantFolder::foldDeclaration(uint32_t node)
+{
+    const Ast& ast{*m_Ast};
+    for (uint32_t c{ast.firstChild(node)}; c != Ast::NO_NODE; c = ast.nextSibling(c))
+    {
+        if (ast.kind(c) == NodeKind::ARRAY_SIZE)
+            foldChildren(c);
+        if (ast.kind(c) != NodeKind::DECLARATOR)
+            continue;
+
+        // the name is in scope from its initializer on
+        for (uint32_t d{ast.firstChild(c)}; d != Ast::NO_NODE; d = ast.nextSibling(d))
+        {
+            if (ast.kind(d) == NodeKind::ARRAY_SIZE)
+                foldChildren(d);
+            else
+                foldExpression(d);
+        }
+        if (ast.token(c) != Ast::NO_TOKEN && ast.type(node) != Ast::NO_TOKEN)
+            declare(m_Tokens->id(ast.token(c)), ast.type(node));
+    }
+}
+
+void ConstantFolder::foldIf(uint32_t node, uint32_t parent)
+{
+    const Ast& ast{*m_Ast};
+    uint32_t condition{ast.firstChild(node)};
+    uint32_t then{ast.nextSibling(condition)};
+    uint32_t otherwise{then != Ast::NO_NODE ? ast.nextSibling(then) : Ast::NO_NODE};
+
+    Constant c;
+    bool constant{fold(condition, c)};
+    if (constant && c.type == BaseType::BOOL && c.size == 1)
+    {
+        uint32_t chosen{c.bits[0] ? then : otherwise};
+        if (chosen == Ast::NO_NODE)
+        {
+            dropStatement(node, parent);
+            return;
+        }
+        // a declaration would move into the enclosing scope, blocks keep their braces
+        if (ast.kind(chosen) != NodeKind::DECLARATION)
+        {
+            drop(ast.begin(node), ast.begin(chosen));
+            drop(ast.end(chosen), ast.end(node));
+            m_RemovedNodes += subtreeSize(node) - subtreeSize(chosen);
+            foldStatement(chosen, parent);
+            return;
+        }
+    }
+
+    if (constant)
+        replace(condition, c);
+    if (then != Ast::NO_NODE)
+        foldStatement(then, node);
+    if (otherwise != Ast::NO_NODE)
+        foldStatement(otherwise, node);
+}
+
+void ConstantFolder::foldLoop(uint32_t node, uint32_t parent)
+{
+    const Ast& ast{*m_Ast};
+    const TokenBuffer& tokens{*m_Tokens};
+    uint32_t first{ast.firstChild(node)};
+    uint32_t second{ast.nextSibling(first)};
+    Constant c;
+
+    if (ast.kind(node) == NodeKind::WHILE)
+    {
+        bool constant{fold(first, c)};
+        if (constant && c.type == BaseType::BOOL && c.size == 1 && !c.bits[0])
+        {
+            dropStatement(node, parent);
+            return;
+        }
+        if (constant)
+            replace(first, c);
+        foldStatement(second, node);
+        return;
+    }
+
+    if (ast.kind(node) == NodeKind::DO)
+    {
+        // do { .. } while (false); runs the block once, unless a break or continue in it means this loop
+        bool constant{fold(second, c)};
+        bool once{constant && c.type == BaseType::BOOL && c.size == 1 && !c.bits[0] &&
+            ast.kind(first) == NodeKind::BLOCK};
+        for (uint32_t i{ast.begin(first)}; once && i < ast.end(first); ++i)
+            once = tokens.type(i) != TokenType::BREAK && tokens.type(i) != TokenType::CONTINUE;
+        if (once)
+        {
+            drop(ast.begin(node), ast.begin(first));
+            drop(ast.end(first), ast.end(node));
+            m_RemovedNodes += subtreeSize(node) - subtreeSize(first);
+            foldStatement(first, parent);
+            return;
+        }
+        if (constant)
+            replace(second, c);
+        foldStatement(first, node);
+        return;
+    }
+
+    // a for loop whose condition is false before the first step, with the variable its init declares
+    uint32_t step{ast.nextSibling(second)};
+    uint32_t body{ast.nextSibling(step)};
+    bool zeroTrip{false};
+    if (ast.kind(second) != NodeKind::EMPTY)
+    {
+        if (ast.kind(first) == NodeKind::EMPTY)
+            zeroTrip = evaluate(second, c);
+        else if (ast.kind(first) == NodeKind::DECLARATION && ast.childCount(first) == 1)
+        {
+            uint32_t declarator{ast.firstChild(first)};
+            uint32_t init{ast.firstChild(declarator)};
+            BaseType base{BaseType::UNKNOWN};
+            int size{0};
+            uint32_t type{ast.type(first)};
+            Constant value;
+            if (ast.kind(declarator) == NodeKind::DECLARATOR && init != Ast::NO_NODE &&
+                ast.kind(init) != NodeKind::ARRAY_SIZE && type != Ast::NO_TOKEN &&
+                describeType(tokens.type(type), tokens.lexeme(type), base, size) && size == 1 &&
+                evaluate(init, value) && construct(base, 1, &value, 1, m_LoopValue))
+            {
+                m_LoopName = tokens.id(ast.token(declarator));
+                zeroTrip = evaluate(second, c);
+                m_LoopName = UINT32_MAX;
+            }
+        }
+        zeroTrip = zeroTrip && c.type == BaseType::BOOL && c.size == 1 && !c.bits[0];
+    }
+    if (zeroTrip)
+    {
+        dropStatement(node, parent);
+        return;
+    }
+
+    std::size_t scope{m_Names.size()};
+    foldStatement(first, node);
+    foldExpression(second);
+    foldExpression(step);
+    if (body != Ast::NO_NODE)
+        foldStatement(body, node);
+    closeScope(scope);
+}
+
+void ConstantFolder::drop(uint32_t begin, uint32_t end)
+{
+    if (m_DryRun)
+        return;
+    std::vector<char>& keep{*m_Keep};
+    for (uint32_t i{begin}; i < end; ++i)
+        keep[i] = keep[i] && m_Tokens->type(i) == TokenType::PREPROCESSOR;
+}
+
+void ConstantFolder::dropStatement(uint32_t node, uint32_t parent)
+{
+    const Ast& ast{*m_Ast};
+    if (m_DryRun)
+        return;
+    drop(ast.begin(node), ast.end(node));
+    m_RemovedNodes += subtreeSize(node);
+    if (parent != Ast::NO_NODE && ast.kind(parent) == NodeKind::BLOCK)
+        return;
+
+    // if (a) while (false) ..; still needs its statement, the keyword stays and a ';' goes out instead
+    (*m_Keep)[ast.begin(node)] = true;
+    m_Replacements.push_back({ast.begin(node), static_cast<uint32_t>(m_Text.size()), 1, TokenType::SEMICOLON,
+                              TokenType::SEMICOLON});
+    m_Text += ';';
+}
+
+bool ConstantFolder::print(const Constant& value, bool bareNegative, std::string& out, TokenType& first,
+                           TokenType& last) const
+{
+    constexpr std::string_view NAMES[]{"", "vec", "ivec", "uvec", "bvec"};
+    char buffer[MAX_LITERAL_LENGTH];
+
+    // a component without its sign, false if it has no literal
+    auto component{
+        [&](int i, bool& negative) -> std::string_view
+        {
+            switch (value.type)
+            {
+            case BaseType::FLOAT:
+                {
+                    negative = std::signbit(value.floats[i]);
+                    std::size_t length{writeFloatLiteral(std::fabs(value.floats[i]), buffer)};
+                    return {buffer, length};
+                }
+            case BaseType::INT:
+                {
+                    auto number{static_cast<int32_t>(value.bits[i])};
+                    negative = number < 0;
+                    if (number == INT32_MIN)
+                        return {};
+                    char* end{std::to_chars(buffer, buffer + 16, negative ? -number : number).ptr};
+                    return {buffer, static_cast<std::size_t>(end - buffer)};
+                }
+            case BaseType::UINT:
+                {
+                    negative = false;
+                    if (!m_Rules.unsignedInts)
+                        return {};
+                    char* end{std::to_chars(buffer, buffer + 16, value.bits[i]).ptr};
+                    *end++ = 'u';
+                    return {buffer, static_cast<std::size_t>(end - buffer)};
+                }
+            case BaseType::BOOL:
+                negative = false;
+                return value.bits[i] ? "true" : "false";
+            default:
+                return {};
+            }
+        }
+    };
+
+    out.clear();
+    bool negative{false};
+    if (value.size == 1)
+    {
+        std::string_view text{component(0, negative)};
+        if (text.empty())
+            return false;
+        // (-2.) where a - in front would merge with what comes before or bind differently
+        bool group{negative && !bareNegative};
+        if (group)
+            out += '(';
+        if (negative)
+            out += '-';
+        out += text;
+        if (group)
+            out += ')';
+        first = group ? TokenType::LEFT_PAREN : negative ? TokenType::MINUS
+                : value.type == BaseType::BOOL ? TokenType::KEYWORD : TokenType::NUMBER;
+        last = group ? TokenType::RIGHT_PAREN : value.type == BaseType::BOOL ? TokenType::KEYWORD : TokenType::NUMBER;
+        return true;
+    }
+
+    // vec3(1.) for three equal components
+    bool same{true};
+    for (int i{1}; i < value.size; ++i)
+        same = same && value.floats[i] == value.floats[0] && value.bits[i] == value.bits[0] &&
+            std::signbit(value.floats[i]) == std::signbit(value.floats[0]);
+    out += NAMES[static_cast<int>(value.type)];
+    out += static_cast<char>('0' + value.size);
+    out += '(';
+    for (int i{0}; i < (same ? 1 : value.size); ++i)
+    {
+        std::string_view text{component(i, negative)};
+        if (text.empty())
+            return false;
+        if (i > 0)
+            out += ',';
+        if (negative)
+            out += '-';
+        out += text;
+    }
+    out += ')';
+    first = lookupKeyword(std::string_view{out}.substr(0, out.find('(')));
+    last = TokenType::RIGHT_PAREN;
+    return true;
+}
+
+bool ConstantFolder::replace(uint32_t node, const Constant& value)
+{
+    const Ast& ast{*m_Ast};
+    const TokenBuffer& tokens{*m_Tokens};
+    // literals are shortened as they go out
+    if (m_DryRun || ast.kind(node) == NodeKind::LITERAL)
+        return false;
+
+    std::string& text{m_Printed};
+    TokenType first{};
+    TokenType last{};
+    if (!print(value, tokens.type(ast.begin(node)) == TokenType::MINUS, text, first, last))
+        return false;
+
+    // what goes out now, and a literal or true/false to stand in for the range
+    std::size_t length{0};
+    uint32_t kept{Ast::NO_TOKEN};
+    char literal[MAX_LITERAL_LENGTH];
+    for (uint32_t i{ast.begin(node)}; i < ast.end(node); ++i)
+    {
+        TokenType type{tokens.type(i)};
+        bool isLiteral{type == TokenType::NUMBER || (type == TokenType::KEYWORD && isBoolWord(tokens.lexeme(i)))};
+        if (isLiteral && kept == Ast::NO_TOKEN)
+            kept = i;
+        length += type == TokenType::NUMBER ? shortestLiteral(tokens.lexeme(i), m_Rules, literal).length()
+                                            : tokens.length(i);
+    }
+    if (text.length() >= length || kept == Ast::NO_TOKEN)
+        return false;
+
+    drop(ast.begin(node), ast.end(node));
+    (*m_Keep)[kept] = true;
+    m_Replacements.push_back({kept, static_cast<uint32_t>(m_Text.size()), static_cast<uint32_t>(text.length()),
+                              first, last});
+    m_Text += text;
+    m_RemovedNodes += subtreeSize(node) - 1;
+    return true;
+}
+
+void ConstantFolder::run(const TokenBuffer& tokens, const Ast& ast, uint32_t root, std::vector<char>& keep)
+{
+    m_Tokens = &tokens;
+    m_Ast = &ast;
+    m_Keep = &keep;
+    m_Replacements.clear();
+    m_Text.clear();
+    m_Names.clear();
+    m_Active.assign(tokens.identifierCount(), NO_BINDING);
+    m_Directives.clear();
+    m_RemovedNodes = 0;
+    m_RemovedBytes = 0;
+
+    // the tree of a shader that does not parse may not be what the compiler sees
+    for (uint32_t node{0}; node < ast.size(); ++node)
+    {
+        if (ast.kind(node) == NodeKind::ERROR)
+            return;
+    }
+
+    m_Rules = LiteralRules{};
+    for (uint32_t i{0}; i < tokens.size(); ++i)
+    {
+        if (tokens.type(i) != TokenType::PREPROCESSOR)
+            continue;
+        m_Directives.push_back(i);
+        m_Rules.readDirective(tokens.lexeme(i));
+    }
+
+    for (uint32_t item{ast.firstChild(root)}; item != Ast::NO_NODE; item = ast.nextSibling(item))
+    {
+        if (ast.kind(item) == NodeKind::DECLARATION)
+            foldDeclaration(item);
+        if (ast.kind(item) != NodeKind::FUNCTION)
+            continue;
+
+        std::size_t scope{m_Names.size()};
+        for (uint32_t c{ast.firstChild(item)}; c != Ast::NO_NODE; c = ast.nextSibling(c))
+        {
+            if (ast.kind(c) == NodeKind::PARAMETER && ast.token(c) != Ast::NO_TOKEN)
+                declare(tokens.id(ast.token(c)), ast.type(c));
+            else if (ast.kind(c) == NodeKind::ARRAY_SIZE)
+                foldChildren(c);
+            else if (ast.kind(c) == NodeKind::BLOCK)
+                foldStatement(c, item);
+        }
+        closeScope(scope);
+    }
+
+    // a do-while has its condition folded before its body
+    std::sort(m_Replacements.begin(), m_Replacements.end(),
+              [](const Replacement& a, const Replacement& b) { return a.token < b.token; });
+    long long removed{0};
+    for (uint32_t i{0}; i < tokens.size(); ++i)
+    {
+        if (!keep[i])
+            removed += tokens.length(i);
+    }
+    for (const Replacement& r : m_Replacements)
+        removed += static_cast<long long>(tokens.length(r.token)) - r.length;
+    m_RemovedBytes = static_cast<std::size_t>(std::max(removed, 0LL));
+}
@@ -0,0 +1,136 @@
+#include "DeadCodeEliminator.hpp"
+#include "Minifier.hpp"
+
+namespace
+{
+    // declarations with these are what the shader shows the pipeline, they stay even if nothing reads them
+    constexpr uint16_t INTERFACE_FLAGS{
+        FLAG_UNIFORM | FLAG_IN | FLAG_OUT | FLAG_ATTRIBUTE | FLAG_VARYING | FLAG_BUFFER | FLAG_SHARED | FLAG_LAYOUT |
+        FLAG_OTHER_QUALIFIER
+    };
+}
+
+void DeadCodeEliminator::declare(uint32_t id, uint32_t item)
+{
+    m_Entries.push_back({item, m_FirstEntry[id]});
+    m_FirstEntry[id] = static_cast<uint32_t>(m_Entries.size() - 1);
+}
+
+void DeadCodeEliminator::reach(uint32_t id)
+{
+    if (m_Seen[id])
+        return;
+    m_Seen[id] = true;
+    for (uint32_t e{m_FirstEntry[id]}; e != NO_ENTRY; e = m_Entries[e].next)
+        reachItem(m_Entries[e].item);
+}
+
+void DeadCodeEliminator::reachItem(uint32_t item)
+{
+    if (m_Reached[item])
+        return;
+    m_Reached[item] = true;
+    m_Work.push_back(item);
+}
+
+bool DeadCodeEliminator::run(const TokenBuffer& tokens, const Ast& ast, uint32_t root, std::vector<char>& keep,
+                             const std::set<std::string, std::less<>>& reached)
+{
+    m_RemovedFunctions = 0;
+    m_RemovedDeclarations = 0;
+    m_RemovedBytes = 0;
+
+    uint32_t mainId{tokens.findId("main")};
+    if (mainId == IdentifierTable::NO_ID)
+        return false;
+    for (uint32_t node{0}; node < ast.size(); ++node)
+    {
+        if (ast.kind(node) == NodeKind::ERROR)
+            return false;
+    }
+
+    m_Items.clear();
+    for (uint32_t node{ast.firstChild(root)}; node != Ast::NO_NODE; node = ast.nextSibling(node))
+        m_Items.push_back(node);
+    m_Reached.assign(m_Items.size(), false);
+    m_FirstEntry.assign(tokens.identifierCount(), NO_ENTRY);
+    m_Entries.clear();
+    m_Seen.assign(tokens.identifierCount(), false);
+    m_Work.clear();
+
+    // who declares which name, anything that is neither a function nor a plain declaration just stays
+    for (uint32_t item{0}; item < m_Items.size(); ++item)
+    {
+        uint32_t node{m_Items[item]};
+        switch (ast.kind(node))
+        {
+        case NodeKind::FUNCTION:
+            declare(tokens.id(ast.token(node)), item);
+            break;
+        case NodeKind::DECLARATION:
+            if (ast.flags(node) & INTERFACE_FLAGS)
+            {
+                reachItem(item);
+                break;
+            }
+            for (uint32_t c{ast.firstChild(node)}; c != Ast::NO_NODE; c = ast.nextSibling(c))
+            {
+                if ((ast.kind(c) == NodeKind::DECLARATOR || ast.kind(c) == NodeKind::STRUCT) &&
+                    ast.token(c) != Ast::NO_TOKEN)
+                    declare(tokens.id(ast.token(c)), item);
+            }
+            break;
+        default:
+            reachItem(item);
+            break;
+        }
+    }
+
+    // a # line can use any name, a macro body can call a function
+    for (std::size_t i{0}; i < tokens.size(); ++i)
+    {
+        if (tokens.type(i) != TokenType::PREPROCESSOR)
+            continue;
+        Minifier::forEachWord(tokens.lexeme(i), [&](std::string_view word)
+        {
+            uint32_t id{tokens.findId(word)};
+            if (id != IdentifierTable::NO_ID)
+                reach(id);
+        });
+    }
+    for (const std::string& name : reached)
+    {
+        uint32_t id{tokens.findId(name)};
+        if (id != IdentifierTable::NO_ID)
+            reach(id);
+    }
+    reach(mainId);
+
+    // field and swizzle names after '.' are no uses, anything else may be, locals that shadow a global included
+    while (!m_Work.empty())
+    {
+        uint32_t node{m_Items[m_Work.back()]};
+        m_Work.pop_back();
+        for (uint32_t i{ast.begin(node)}; i < ast.end(node); ++i)
+        {
+            if (keep[i] && tokens.type(i) == TokenType::IDENTIFIER && (i == 0 || tokens.type(i - 1) != TokenType::DOT))
+                reach(tokens.id(i));
+        }
+    }
+
+    for (uint32_t item{0}; item < m_Items.size(); ++item)
+    {
+        if (m_Reached[item])
+            continue;
+        uint32_t node{m_Items[item]};
+        if (ast.kind(node) == NodeKind::FUNCTION)
+            ++m_RemovedFunctions;
+        else
+            ++m_RemovedDeclarations;
+        uint32_t last{ast.end(node) - 1};
+        m_RemovedBytes += tokens.offset(last) + tokens.length(last) - tokens.offset(ast.begin(node));
+        for (uint32_t i{ast.begin(node)}; i < ast.end(node); ++i)
+            keep[i] = keep[i] && tokens.type(i) == TokenType::PREPROCESSOR;
+    }
+    return true;
+}
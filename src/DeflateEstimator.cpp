@@ -0,0 +1,358 @@
+#include "DeflateEstimator.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <utility>
+#include <vector>
+
+namespace
+{
+    constexpr std::size_t WINDOW{32768};
+    constexpr std::size_t MIN_MATCH{3};
+    constexpr std::size_t MAX_MATCH{258};
+    constexpr std::size_t LAZY_LENGTH{32}; // a match this long is taken without looking one byte further
+    constexpr int MAX_CHAIN{64};
+    constexpr int HASH_BITS{15};
+    constexpr std::size_t BLOCK_SYMBOLS{16384};
+    // a position is encoded once this much input follows it, enough for a match one byte on and its inserts
+    constexpr std::size_t LOOKAHEAD{MAX_MATCH + MIN_MATCH + 1};
+
+    constexpr int LITERAL_CODES{286};
+    constexpr int DISTANCE_CODES{30};
+    constexpr int END_OF_BLOCK{256};
+
+    int lengthCode(std::size_t length, int& extra)
+    {
+        if (length == MAX_MATCH)
+        {
+            extra = 0;
+            return 285;
+        }
+        if (length < 11)
+        {
+            extra = 0;
+            return 257 + static_cast<int>(length) - 3;
+        }
+        std::size_t value{length - 3};
+        int log{0};
+        while ((value >> (log + 1)) != 0)
+            ++log;
+        extra = log - 2;
+        return 261 + 4 * extra + static_cast<int>(value >> extra) - 4;
+    }
+
+    int distanceCode(std::size_t distance, int& extra)
+    {
+        std::size_t value{distance - 1};
+        if (value < 4)
+        {
+            extra = 0;
+            return static_cast<int>(value);
+        }
+        int log{0};
+        while ((value >> (log + 1)) != 0)
+            ++log;
+        extra = log - 1;
+        return 2 * extra + 2 + static_cast<int>((value >> extra) & 1);
+    }
+
+    // huffman code lengths no longer than limit, 0 for unused symbols
+    // a tree that is too deep is built again from halved counts, the way most encoders handle it
+    std::vector<int> codeLengths(std::vector<uint32_t> counts, int limit)
+    {
+        std::vector<int> lengths(counts.size(), 0);
+        for (;;)
+        {
+            using Node = std::pair<uint64_t, int>; // weight, node
+            std::priority_queue<Node, std::vector<Node>, std::greater<Node>> queue;
+            std::vector<int> parent;
+            for (std::size_t s{0}; s < counts.size(); ++s)
+            {
+                if (counts[s] == 0)
+                    continue;
+                queue.push({counts[s], static_cast<int>(parent.size())});
+                parent.push_back(-1);
+            }
+
+            if (parent.size() <= 1)
+            {
+                // deflate still spends one bit on a lone symbol
+                for (std::size_t s{0}; s < counts.size(); ++s)
+                    lengths[s] = counts[s] != 0 ? 1 : 0;
+                return lengths;
+            }
+
+            std::size_t leaves{parent.size()};
+            while (queue.size() > 1)
+            {
+                Node a{queue.top()};
+                queue.pop();
+                Node b{queue.top()};
+                queue.pop();
+                int node{static_cast<int>(parent.size())};
+                parent.push_back(-1);
+                parent[a.second] = node;
+                parent[b.second] = node;
+                queue.push({a.first + b.first, node});
+            }
+
+            // parents are always created after their children, so depths fill in from the root down
+            std::vector<int> depth(parent.size(), 0);
+            for (std::size_t n{parent.size() - 1}; n-- > 0;)
+                depth[n] = depth[parent[n]] + 1;
+
+            int deepest{0};
+            for (std::size_t n{0}; n < leaves; ++n)
+                deepest = std::max(deepest, depth[n]);
+
+            if (deepest <= limit)
+            {
+                std::size_t leaf{0};
+                for (std::size_t s{0}; s < counts.size(); ++s)
+                    if (counts[s] != 0)
+                        lengths[s] = depth[leaf++];
+                return lengths;
+            }
+
+            for (uint32_t& count : counts)
+                if (count != 0)
+                    count = std::max<uint32_t>(1, count / 2);
+        }
+    }
+
+    // bits for the code lengths of a dynamic block header, run length coded with the 19 symbol alphabet
+    std::size_t headerBits(const std::vector<int>& literalLengths, const std::vector<int>& distanceLengths)
+    {
+        int literals{LITERAL_CODES};
+        while (literals > 257 && literalLengths[literals - 1] == 0)
+            --literals;
+        int distances{DISTANCE_CODES};
+        while (distances > 1 && distanceLengths[distances - 1] == 0)
+            --distances;
+
+        std::vector<int> all(literalLengths.begin(), literalLengths.begin() + literals);
+        all.insert(all.end(), distanceLengths.begin(), distanceLengths.begin() + distances);
+
+        std::vector<uint32_t> counts(19, 0);
+        std::size_t extraBits{0};
+        for (std::size_t i{0}; i < all.size();)
+        {
+            std::size_t run{1};
+            while (i + run < all.size() && all[i + run] == all[i])
+                ++run;
+
+            if (all[i] == 0 && run >= 3)
+            {
+                std::size_t taken{std::min<std::size_t>(run, 138)};
+                ++counts[taken >= 11 ? 18 : 17];
+                extraBits += taken >= 11 ? 7 : 3;
+                i += taken;
+            }
+            else if (run >= 4)
+            {
+                // the length once, then repeats of 3 to 6
+                ++counts[all[i]];
+                std::size_t taken{std::min<std::size_t>(run - 1, 6)};
+                ++counts[16];
+                extraBits += 2;
+                i += taken + 1;
+            }
+            else
+            {
+                ++counts[all[i]];
+                ++i;
+            }
+        }
+
+        std::vector<int> lengths{codeLengths(counts, 7)};
+        std::size_t bits{5 + 5 + 4 + 19 * 3 + extraBits};
+        for (std::size_t s{0}; s < counts.size(); ++s)
+            bits += counts[s] * static_cast<std::size_t>(lengths[s]);
+        return bits;
+    }
+
+    inline uint32_t hash3(const unsigned char* p)
+    {
+        return ((static_cast<uint32_t>(p[0]) << 16 | static_cast<uint32_t>(p[1]) << 8 | p[2]) * 2654435761u) >>
+            (32 - HASH_BITS);
+    }
+}
+
+DeflateEstimator::DeflateEstimator()
+    : m_Head(std::size_t{1} << HASH_BITS, 0), m_Chain(WINDOW, 0)
+{
+    m_Block.literals.assign(LITERAL_CODES, 0);
+    m_Block.distances.assign(DISTANCE_CODES, 0);
+}
+
+void DeflateEstimator::insert(std::size_t at, std::size_t end)
+{
+    if (at + MIN_MATCH > end)
+        return;
+    uint32_t h{hash3(&m_Data[at - m_Base])};
+    m_Chain[at & (WINDOW - 1)] = m_Head[h];
+    m_Head[h] = at + 1;
+}
+
+std::size_t DeflateEstimator::longestMatch(std::size_t at, std::size_t end, std::size_t& distance) const
+{
+    std::size_t best{0};
+    if (at + MIN_MATCH > end)
+        return best;
+
+    const unsigned char* here{&m_Data[at - m_Base]};
+    std::size_t limit{std::min(MAX_MATCH, end - at)};
+    std::size_t candidate{m_Head[hash3(here)]};
+    for (int steps{0}; candidate != 0 && steps < MAX_CHAIN; ++steps)
+    {
+        std::size_t from{candidate - 1};
+        if (at - from > WINDOW - 1)
+            break;
+
+        const unsigned char* there{&m_Data[from - m_Base]};
+        if (there[best] == here[best])
+        {
+            std::size_t length{0};
+            while (length < limit && there[length] == here[length])
+                ++length;
+            if (length > best)
+            {
+                best = length;
+                distance = at - from;
+                if (length == limit)
+                    break;
+            }
+        }
+
+        std::size_t next{m_Chain[from & (WINDOW - 1)]};
+        if (next == 0 || next - 1 >= from)
+            break;
+        candidate = next;
+    }
+    return best >= MIN_MATCH ? best : 0;
+}
+
+void DeflateEstimator::encode(std::size_t until, std::size_t end)
+{
+    while (m_At < until)
+    {
+        if (!m_Ready)
+        {
+            m_Length = longestMatch(m_At, end, m_Distance);
+            m_Ready = true;
+        }
+
+        if (m_Length == 0)
+        {
+            literal(m_Data[m_At - m_Base]);
+            insert(m_At, end);
+            ++m_At;
+            m_Ready = false;
+        }
+        else
+        {
+            // lazy evaluation, a longer match one byte on beats this one
+            insert(m_At, end);
+            std::size_t nextDistance{0};
+            std::size_t next{m_Length < LAZY_LENGTH ? longestMatch(m_At + 1, end, nextDistance) : 0};
+            if (next > m_Length)
+            {
+                literal(m_Data[m_At - m_Base]);
+                ++m_At;
+                m_Length = next;
+                m_Distance = nextDistance;
+            }
+            else
+            {
+                match(m_Length, m_Distance);
+                for (std::size_t k{1}; k < m_Length; ++k)
+                    insert(m_At + k, end);
+                m_At += m_Length;
+                m_Ready = false;
+            }
+        }
+
+        if (m_Block.symbols >= BLOCK_SYMBOLS)
+            flushBlock();
+    }
+}
+
+void DeflateEstimator::literal(unsigned char c)
+{
+    ++m_Block.literals[c];
+    ++m_Block.symbols;
+    ++m_Block.bytes;
+}
+
+void DeflateEstimator::match(std::size_t length, std::size_t distance)
+{
+    int extra{0};
+    ++m_Block.literals[lengthCode(length, extra)];
+    m_Block.extraBits += static_cast<std::size_t>(extra);
+    ++m_Block.distances[distanceCode(distance, extra)];
+    m_Block.extraBits += static_cast<std::size_t>(extra);
+    ++m_Block.symbols;
+    m_Block.bytes += length;
+}
+
+void DeflateEstimator::flushBlock()
+{
+    // the cheapest of a dynamic, a fixed and a stored block
+    m_Block.literals[END_OF_BLOCK] = 1;
+
+    std::vector<int> literalLengths{codeLengths(m_Block.literals, 15)};
+    std::vector<int> distanceLengths{codeLengths(m_Block.distances, 15)};
+    std::size_t dynamic{3 + headerBits(literalLengths, distanceLengths) + m_Block.extraBits};
+    std::size_t fixed{3 + m_Block.extraBits};
+    for (int s{0}; s < LITERAL_CODES; ++s)
+    {
+        dynamic += m_Block.literals[s] * static_cast<std::size_t>(literalLengths[s]);
+        fixed += m_Block.literals[s] * static_cast<std::size_t>(s < 144 ? 8 : s < 256 ? 9 : s < 280 ? 7 : 8);
+    }
+    for (int s{0}; s < DISTANCE_CODES; ++s)
+    {
+        dynamic += m_Block.distances[s] * static_cast<std::size_t>(distanceLengths[s]);
+        fixed += m_Block.distances[s] * 5;
+    }
+    std::size_t stored{(m_Block.bytes + 5) * 8};
+    m_Bits += std::min({dynamic, fixed, stored});
+
+    m_Block.literals.assign(LITERAL_CODES, 0);
+    m_Block.distances.assign(DISTANCE_CODES, 0);
+    m_Block.extraBits = 0;
+    m_Block.symbols = 0;
+    m_Block.bytes = 0;
+}
+
+void DeflateEstimator::add(std::string_view data)
+{
+    m_Data.insert(m_Data.end(), data.begin(), data.end());
+    std::size_t end{m_Base + m_Data.size()};
+    if (end >= m_At + LOOKAHEAD)
+        encode(end - LOOKAHEAD, end);
+
+    // only a window before the next position is ever looked at again
+    if (m_At - m_Base > 4 * WINDOW)
+    {
+        std::size_t drop{m_At - WINDOW - m_Base};
+        m_Data.erase(m_Data.begin(), m_Data.begin() + static_cast<std::ptrdiff_t>(drop));
+        m_Base += drop;
+    }
+}
+
+std::size_t DeflateEstimator::finish()
+{
+    std::size_t end{m_Base + m_Data.size()};
+    encode(end, end);
+    flushBlock();
+    return (m_Bits + 7) / 8;
+}
+
+std::size_t estimateDeflateSize(std::string_view data)
+{
+    DeflateEstimator estimator;
+    estimator.add(data);
+    return estimator.finish();
+}
@@ -0,0 +1,52 @@
+#include "Emitter.hpp"
+
+#include <cstring>
+
+Emitter::Emitter(OutputSink& sink, std::pmr::memory_resource* memory)
+    : m_Sink{sink}, m_Memory{memory}, m_Block{static_cast<char*>(memory->allocate(BLOCK_SIZE, 1))}
+{
+}
+
+Emitter::~Emitter()
+{
+    flush();
+    m_Memory->deallocate(m_Block, BLOCK_SIZE, 1);
+}
+
+void Emitter::emit(std::string_view text)
+{
+    if (text.empty())
+        return;
+    m_Last = text.back();
+
+    if (m_Used + text.size() > BLOCK_SIZE)
+    {
+        flush();
+        // bigger than a block, no point copying it
+        if (text.size() >= BLOCK_SIZE)
+        {
+            m_Sink.write(text);
+            m_Flushed += text.size();
+            return;
+        }
+    }
+    std::memcpy(m_Block + m_Used, text.data(), text.size());
+    m_Used += text.size();
+}
+
+void Emitter::emit(char c)
+{
+    if (m_Used == BLOCK_SIZE)
+        flush();
+    m_Block[m_Used++] = c;
+    m_Last = c;
+}
+
+void Emitter::flush()
+{
+    if (m_Used == 0)
+        return;
+    m_Sink.write(std::string_view{m_Block, m_Used});
+    m_Flushed += m_Used;
+    m_Used = 0;
+}
@@ -1,6 +1,14 @@
 #include "ErrorReporter.hpp"
 
-void CompilerError::print() const
+#include <algorithm>
+
+namespace
+{
+// a binary file can be one multi-megabyte line
+constexpr std::size_t MAX_CONTEXT_WIDTH{120};
+}
+
+void CompilerError::print(int resolvedColumn, std::string_view resolvedContext, std::ostream& out) const
 {
     std::string severityStr;
     switch (severity)
@@ -16,62 +24,115 @@ void CompilerError::print() const
         break;
     }
 
-    std::cerr << severityStr << " at line " << line << ", column " << column << ": " << message << '\n';
-    if (!context.empty())
+    out << severityStr << " at line " << line << ", column " << resolvedColumn << ": " << message << '\n';
+    if (!resolvedContext.empty())
+    {
+        std::size_t caret{resolvedColumn > 0 ? static_cast<std::size_t>(resolvedColumn - 1) : 0};
+        if (resolvedContext.length() > MAX_CONTEXT_WIDTH)
+        {
+            std::size_t start{caret > MAX_CONTEXT_WIDTH / 2 ? caret - MAX_CONTEXT_WIDTH / 2 : 0};
+            resolvedContext = resolvedContext.substr(start, MAX_CONTEXT_WIDTH);
+            caret -= std::min(caret, start);
+        }
+
+        out << "\t" << resolvedContext << '\n';
+        if (resolvedColumn > 0 && caret <= resolvedContext.length())
+            out << "\t" << std::string(caret, ' ') << "^\n";
+    }
+}
+
+bool ErrorReporter::keep(ErrorSeverity severity)
+{
+    m_Counts[static_cast<int>(severity)]++;
+    if (severity == ErrorSeverity::FATAL)
+        m_HasFatalError = true;
+
+    if (m_Errors.size() >= m_MaxErrors && severity != ErrorSeverity::FATAL)
     {
-        std::cerr << "\t" << context << '\n';
-        std::cerr << "\t" << std::string(column - 1, ' ') << "^\n";
+        m_Suppressed++;
+        return false;
     }
+    return true;
 }
 
 void ErrorReporter::reportError(ErrorSeverity severity, const std::string& message, int line, int column,
                                 const std::string& context)
 {
-    CompilerError error{severity, message, line, column, context};
-    m_Errors.push_back(error);
+    if (keep(severity))
+        m_Errors.push_back(CompilerError{severity, message, line, column, context});
+}
+
+void ErrorReporter::reportErrorAt(ErrorSeverity severity, std::string message, int line, std::size_t offset)
+{
+    if (keep(severity))
+        m_Errors.push_back(CompilerError{severity, std::move(message), line, 0, {}, offset});
+}
 
-    if (severity == ErrorSeverity::FATAL)
-        m_HasFatalError = true;
+void ErrorReporter::merge(const ErrorReporter& other, int lineOffset)
+{
+    for (int i{0}; i < 3; ++i)
+        m_Counts[i] += other.m_Counts[i];
+    m_HasFatalError = m_HasFatalError || other.m_HasFatalError;
+    m_Suppressed += other.m_Suppressed;
+
+    for (const CompilerError& error : other.m_Errors)
+    {
+        if (m_Errors.size() >= m_MaxErrors && error.severity != ErrorSeverity::FATAL)
+        {
+            m_Suppressed++;
+            continue;
+        }
+        m_Errors.push_back(error);
+        m_Errors.back().line += lineOffset;
+    }
+}
 
-    error.print();
+void ErrorReporter::setSource(std::string_view source)
+{
+    m_Source = source;
+    m_LineIndexBuilt = false;
 }
 
-void ErrorReporter::print() const
+void ErrorReporter::print(std::ostream& errors, std::ostream& summary) const
 {
-    if (m_Errors.empty())
+    if (!hasErrors())
     {
-        std::cout << "No errors found\n";
+        summary << "No errors found\n";
         return;
     }
 
-    int warnings{0}, errors{0}, fatal{0};
-    for (const auto& err : m_Errors)
+    for (const CompilerError& error : m_Errors)
     {
-        switch (err.severity)
+        if (error.offset == CompilerError::NO_OFFSET)
+        {
+            error.print(error.column, error.context, errors);
+            continue;
+        }
+
+        if (!m_LineIndexBuilt)
         {
-        case ErrorSeverity::WARNING:
-            ++warnings;
-            break;
-        case ErrorSeverity::ERROR:
-            ++errors;
-            break;
-        case ErrorSeverity::FATAL:
-            ++fatal;
-            break;
+            m_LineIndex = LineIndex{m_Source};
+            m_LineIndexBuilt = true;
         }
+        error.print(m_LineIndex.columnOf(error.offset), m_LineIndex.lineText(m_LineIndex.lineOf(error.offset)),
+                    errors);
     }
+    if (m_Suppressed > 0)
+        errors << m_Suppressed << " more errors suppressed\n";
 
-    std::cout << "\n";
-    if (fatal > 0)
-        std::cout << fatal << " fatal errors\n";
-    if (errors > 0)
-        std::cout << errors << " errors\n";
-    if (warnings > 0)
-        std::cout << warnings << " warnings\n";
+    summary << "\n";
+    if (m_Counts[static_cast<int>(ErrorSeverity::FATAL)] > 0)
+        summary << m_Counts[static_cast<int>(ErrorSeverity::FATAL)] << " fatal errors\n";
+    if (m_Counts[static_cast<int>(ErrorSeverity::ERROR)] > 0)
+        summary << m_Counts[static_cast<int>(ErrorSeverity::ERROR)] << " errors\n";
+    if (m_Counts[static_cast<int>(ErrorSeverity::WARNING)] > 0)
+        summary << m_Counts[static_cast<int>(ErrorSeverity::WARNING)] << " warnings\n";
 }
 
 void ErrorReporter::clear()
 {
     m_Errors.clear();
     m_HasFatalError = false;
+    m_Suppressed = 0;
+    std::fill(std::begin(m_Counts), std::end(m_Counts), 0);
 }
@@ -0,0 +1,73 @@
+#include "IdentifierTable.hpp"
+#include "PerfectHash.hpp"
+
+#include <algorithm>
+
+void IdentifierTable::grow(std::size_t slots)
+{
+    m_Slots.assign(slots, 0);
+    std::size_t mask{slots - 1};
+    for (uint32_t id{0}; id < m_Hashes.size(); ++id)
+    {
+        std::size_t slot{m_Hashes[id] & mask};
+        while (m_Slots[slot] != 0)
+            slot = (slot + 1) & mask;
+        m_Slots[slot] = id + 1;
+    }
+}
+
+uint32_t IdentifierTable::intern(std::string_view source, uint32_t offset, uint32_t length)
+{
+    // at most half full
+    if (2 * (m_Offsets.size() + 1) > m_Slots.size())
+        grow(m_Slots.empty() ? 256 : m_Slots.size() * 2);
+
+    std::string_view name{source.substr(offset, length)};
+    uint32_t hash{perfectHash(name, 0)};
+    std::size_t mask{m_Slots.size() - 1};
+    for (std::size_t slot{hash & mask};; slot = (slot + 1) & mask)
+    {
+        uint32_t entry{m_Slots[slot]};
+        if (entry == 0)
+        {
+            uint32_t id{static_cast<uint32_t>(m_Offsets.size())};
+            m_Slots[slot] = id + 1;
+            m_Offsets.push_back(offset);
+            m_Lengths.push_back(length);
+            m_Hashes.push_back(hash);
+            return id;
+        }
+
+        uint32_t id{entry - 1};
+        if (m_Hashes[id] == hash && m_Lengths[id] == length && this->name(source, id) == name)
+            return id;
+    }
+}
+
+uint32_t IdentifierTable::find(std::string_view source, std::string_view name) const
+{
+    if (m_Slots.empty())
+        return NO_ID;
+
+    uint32_t hash{perfectHash(name, 0)};
+    std::size_t mask{m_Slots.size() - 1};
+    for (std::size_t slot{hash & mask};; slot = (slot + 1) & mask)
+    {
+        uint32_t entry{m_Slots[slot]};
+        if (entry == 0)
+            return NO_ID;
+
+        uint32_t id{entry - 1};
+        if (m_Hashes[id] == hash && this->name(source, id) == name)
+            return id;
+    }
+}
+
+void IdentifierTable::clear()
+{
+    m_Offsets.clear();
+    m_Lengths.clear();
+    m_Hashes.clear();
+    // the slots stay as many, the next shader of a batch is likely just as big
+    std::fill(m_Slots.begin(), m_Slots.end(), 0);
+}
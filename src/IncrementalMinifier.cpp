@@ -0,0 +1,485 @@
+#include "IncrementalMinifier.hpp"
+#include "Lexer.hpp"
+#include "Minifier.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+// memcmp over blocks first, a byte loop only inside the block that differs
+const std::size_t COMPARE_BLOCK{4096};
+
+std::size_t commonPrefix(const char* a, const char* b, std::size_t length)
+{
+    std::size_t i{0};
+    while (i + COMPARE_BLOCK <= length && std::memcmp(a + i, b + i, COMPARE_BLOCK) == 0)
+        i += COMPARE_BLOCK;
+    while (i < length && a[i] == b[i])
+        ++i;
+    return i;
+}
+
+// a and b point one past the ends
+std::size_t commonSuffix(const char* a, const char* b, std::size_t length)
+{
+    std::size_t i{0};
+    while (i + COMPARE_BLOCK <= length && std::memcmp(a - i - COMPARE_BLOCK, b - i - COMPARE_BLOCK, COMPARE_BLOCK) == 0)
+        i += COMPARE_BLOCK;
+    while (i < length && a[-1 - static_cast<std::ptrdiff_t>(i)] == b[-1 - static_cast<std::ptrdiff_t>(i)])
+        ++i;
+    return i;
+}
+
+// the members declared in the braces of a struct or an interface block, a name in them followed by ',' ';' or '['
+// a unit starts at the top level, so braces after a name or 'struct' are the only ones that hold members
+template <typename Function>
+void forEachMember(const TokenBuffer& tokens, Function function)
+{
+    int depth{0};
+    int aggregateDepth{0};
+    for (std::size_t i{0}; i < tokens.size(); ++i)
+    {
+        TokenType type{tokens.type(i)};
+        if (type == TokenType::LEFT_BRACE)
+        {
+            ++depth;
+            TokenType before{i > 0 ? tokens.type(i - 1) : TokenType::SEMICOLON};
+            if (aggregateDepth == 0 && (before == TokenType::IDENTIFIER || before == TokenType::STRUCT))
+                aggregateDepth = depth;
+        }
+        else if (type == TokenType::RIGHT_BRACE)
+        {
+            if (depth == aggregateDepth)
+                aggregateDepth = 0;
+            depth = std::max(0, depth - 1);
+        }
+        else if (type == TokenType::IDENTIFIER && aggregateDepth != 0 && i + 1 < tokens.size())
+        {
+            TokenType after{tokens.type(i + 1)};
+            if (after == TokenType::COMMA || after == TokenType::SEMICOLON || after == TokenType::LEFT_BRACKET)
+                function(i);
+        }
+    }
+}
+}
+
+std::unique_ptr<IncrementalMinifier::Unit> IncrementalMinifier::lexUnit(std::string_view source, std::size_t& at)
+{
+    // a unit ends after a ';' or '}' at brace depth 0, a # line there is a unit of its own
+    // so every unit starts with no declaration pending, which is what lets units be analysed one by one
+    const char* begin{source.data() + at};
+    const char* end{source.data() + source.length()};
+    const char* p{begin};
+    int line{1};
+    int depth{0};
+
+    TokenBuffer scratch{std::string_view{begin, static_cast<std::size_t>(end - begin)}};
+    for (;;)
+    {
+        const char* token{skipTrivia(p, end, line)};
+        if (token == end)
+        {
+            p = end;
+            break;
+        }
+
+        Lexeme lexeme{lexToken(token, end)};
+        p = token + lexeme.length;
+        if (lexeme.type == TokenType::ERROR)
+            continue;
+
+        scratch.push(lexeme.type, static_cast<uint32_t>(token - begin), lexeme.length, line);
+        if (lexeme.type == TokenType::LEFT_BRACE)
+            ++depth;
+        else if (lexeme.type == TokenType::RIGHT_BRACE)
+            depth = std::max(0, depth - 1);
+
+        if (depth == 0 && (lexeme.type == TokenType::SEMICOLON || lexeme.type == TokenType::RIGHT_BRACE ||
+            (lexeme.type == TokenType::PREPROCESSOR && scratch.size() == 1)))
+            break;
+    }
+
+    auto unit{std::make_unique<Unit>()};
+    unit->text.assign(begin, p);
+    // offsets (and the interned names) are relative to begin, so they are valid in the copied text
+    unit->tokens = TokenBuffer{unit->text};
+    unit->tokens.append(scratch, 0, scratch.size());
+
+    for (uint32_t id{0}; id < unit->tokens.identifierCount(); ++id)
+        unit->identifiers.push_back(unit->tokens.name(id));
+    for (std::size_t i{0}; i < unit->tokens.size(); ++i)
+        if (unit->tokens.type(i) == TokenType::PREPROCESSOR)
+            Minifier::forEachWord(unit->tokens.lexeme(i), [&](std::string_view word) { unit->words.push_back(word); });
+
+    at = static_cast<std::size_t>(p - source.data());
+    return unit;
+}
+
+bool IncrementalMinifier::protect(const std::string& name)
+{
+    // true if the name had a renaming that is now gone
+    m_ProtectedNames.insert(name);
+    auto it{m_Renamings.find(name)};
+    if (it == m_Renamings.end())
+        return false;
+
+    m_ShortNames.erase(it->second);
+    m_Renamings.erase(it);
+    return true;
+}
+
+bool IncrementalMinifier::collectProtected(const Unit& unit)
+{
+    // the protected names of Minifier::analyze(), uniforms, members and the words of # lines
+    bool dropped{false};
+    for (std::string_view word : unit.words)
+    {
+        m_PreprocessorWords.emplace(word);
+        dropped |= protect(std::string{word});
+    }
+
+    const TokenBuffer& tokens{unit.tokens};
+    bool afterUniform{false};
+    for (std::size_t i{0}; i < tokens.size(); ++i)
+    {
+        TokenType type{tokens.type(i)};
+
+        if (type == TokenType::UNIFORM)
+        {
+            afterUniform = true;
+            continue;
+        }
+
+        if (afterUniform && Minifier::isType(type))
+            continue;
+
+        if (afterUniform && type == TokenType::IDENTIFIER)
+        {
+            dropped |= protect(std::string{tokens.lexeme(i)});
+            afterUniform = false;
+        }
+
+        if (type == TokenType::SEMICOLON)
+            afterUniform = false;
+    }
+
+    // members are reached through '.' which is never renamed, so like Minifier::analyze() they keep their names
+    forEachMember(tokens, [&](std::size_t i) { dropped |= protect(std::string{tokens.lexeme(i)}); });
+    return dropped;
+}
+
+bool IncrementalMinifier::isFreeName(std::string_view name) const
+{
+    std::string key{name};
+    return m_IdentifierUnits.find(key) == m_IdentifierUnits.end() && m_ShortNames.find(key) == m_ShortNames.end() &&
+        m_ProtectedNames.find(key) == m_ProtectedNames.end() && m_PreprocessorWords.find(key) == m_PreprocessorWords.end();
+}
+
+void IncrementalMinifier::rename(const std::string& name)
+{
+    auto old{m_Renamings.find(name)};
+    if (old != m_Renamings.end())
+        m_ShortNames.erase(old->second);
+
+    std::string shortName{Minifier::nextFreeName(m_VarCounter, [&](std::string_view candidate)
+    {
+        return isFreeName(candidate);
+    })};
+    m_ShortNames[shortName] = name;
+    m_Renamings[name] = std::move(shortName);
+}
+
+void IncrementalMinifier::renameAll(const std::vector<std::unique_ptr<Unit>>& units)
+{
+    // the first update ranks names like Minifier::assignRenamings() ranks globals, the most used get the shortest
+    m_Renamings.clear();
+    m_ShortNames.clear();
+    m_VarCounter = 0;
+
+    std::vector<std::string_view> candidates;
+    std::unordered_map<std::string_view, uint32_t> uses;
+    std::unordered_set<std::string_view> declared;
+
+    for (const auto& unit : units)
+    {
+        const TokenBuffer& tokens{unit->tokens};
+        bool afterQualifierOrType{false};
+        for (std::size_t i{0}; i < tokens.size(); ++i)
+        {
+            TokenType type{tokens.type(i)};
+            if (Minifier::isTypeQualifier(type) || Minifier::isType(type))
+            {
+                afterQualifierOrType = true;
+                continue;
+            }
+
+            if (type == TokenType::IDENTIFIER)
+            {
+                std::string_view name{tokens.lexeme(i)};
+                if (i == 0 || tokens.type(i - 1) != TokenType::DOT)
+                    ++uses[name];
+
+                if (afterQualifierOrType && declared.insert(name).second && !Minifier::isBuiltin(name) &&
+                    m_ProtectedNames.find(std::string{name}) == m_ProtectedNames.end())
+                    candidates.push_back(name);
+                afterQualifierOrType = false;
+            }
+
+            if (type == TokenType::SEMICOLON || type == TokenType::LEFT_BRACE || type == TokenType::RIGHT_BRACE)
+                afterQualifierOrType = false;
+        }
+    }
+
+    std::stable_sort(candidates.begin(), candidates.end(),
+                     [&](std::string_view a, std::string_view b) { return uses[a] > uses[b]; });
+
+    // a generated name may be an identifier of the source only if that one gets renamed too
+    std::unordered_set<std::string_view> renamed{candidates.begin(), candidates.end()};
+    for (std::string_view name : candidates)
+    {
+        std::string shortName{Minifier::nextFreeName(m_VarCounter, [&](std::string_view candidate)
+        {
+            std::string key{candidate};
+            return (m_IdentifierUnits.find(key) == m_IdentifierUnits.end() || renamed.count(candidate) != 0) &&
+                m_PreprocessorWords.find(key) == m_PreprocessorWords.end();
+        })};
+        m_ShortNames[shortName] = std::string{name};
+        m_Renamings[std::string{name}] = std::move(shortName);
+    }
+}
+
+bool IncrementalMinifier::collectDeclarations(const Unit& unit,
+                                              const std::unordered_map<std::string_view, int>& freshUnits)
+{
+    // names declared after the first update, true if a new renaming hits a name that other units already use
+    const TokenBuffer& tokens{unit.tokens};
+    bool afterQualifierOrType{false};
+    bool renamedUsedName{false};
+
+    for (std::size_t i{0}; i < tokens.size(); ++i)
+    {
+        TokenType type{tokens.type(i)};
+        if (Minifier::isTypeQualifier(type) || Minifier::isType(type))
+        {
+            afterQualifierOrType = true;
+            continue;
+        }
+
+        if (type == TokenType::IDENTIFIER && afterQualifierOrType)
+        {
+            std::string_view name{tokens.lexeme(i)};
+            std::string key{name};
+            if (!Minifier::isBuiltin(name) && m_ProtectedNames.find(key) == m_ProtectedNames.end() &&
+                m_Renamings.find(key) == m_Renamings.end())
+            {
+                // the counts already include the new units
+                renamedUsedName |= m_IdentifierUnits.at(key) > freshUnits.at(name);
+                rename(key);
+            }
+            afterQualifierOrType = false;
+        }
+
+        if (type == TokenType::SEMICOLON || type == TokenType::LEFT_BRACE || type == TokenType::RIGHT_BRACE)
+            afterQualifierOrType = false;
+    }
+    return renamedUsedName;
+}
+
+bool IncrementalMinifier::resolveClashes(const Unit& unit)
+{
+    // a short name that now appears in the source as a name that is not renamed moves to a free one
+    bool moved{false};
+    auto check{
+        [&](std::string_view name)
+        {
+            auto it{m_ShortNames.find(std::string{name})};
+            if (it != m_ShortNames.end() && m_Renamings.find(it->first) == m_Renamings.end())
+            {
+                std::string original{it->second};
+                rename(original);
+                moved = true;
+            }
+        }
+    };
+
+    for (std::string_view name : unit.identifiers)
+        check(name);
+    for (std::string_view word : unit.words)
+        check(word);
+    return moved;
+}
+
+void IncrementalMinifier::countIdentifiers(const Unit& unit, int delta)
+{
+    for (std::string_view name : unit.identifiers)
+    {
+        auto it{m_IdentifierUnits.try_emplace(std::string{name}, 0).first};
+        it->second += delta;
+        if (it->second == 0)
+            m_IdentifierUnits.erase(it);
+    }
+}
+
+void IncrementalMinifier::emit(Unit& unit)
+{
+    // Minifier::generateOutput for the unit alone, join() puts the separator in front
+    const TokenBuffer& tokens{unit.tokens};
+    std::string& result{unit.output};
+    result.clear();
+    TokenType prevType{TokenType::END_OF_FILE};
+    char literal[MAX_LITERAL_LENGTH];
+
+    for (std::size_t i{0}; i < tokens.size(); ++i)
+    {
+        TokenType type{tokens.type(i)};
+        std::string_view lexeme{tokens.lexeme(i)};
+
+        if (type == TokenType::PREPROCESSOR)
+        {
+            if (!result.empty())
+                result += '\n';
+
+            result += lexeme;
+            result += '\n';
+            prevType = type;
+            continue;
+        }
+
+        if (!result.empty() && result.back() != '\n' && Minifier::needsSpaceBetween(prevType, type))
+            result += ' ';
+
+        auto it{m_Renamings.end()};
+        if (type == TokenType::IDENTIFIER && prevType != TokenType::DOT && !m_Renamings.empty())
+            it = m_Renamings.find(std::string{lexeme});
+
+        if (it != m_Renamings.end())
+            result += it->second;
+        else if (type == TokenType::NUMBER && m_Rename)
+            result += shortestLiteral(lexeme, m_LiteralRules, literal);
+        else
+            result += lexeme;
+
+        prevType = type;
+    }
+    ++m_EmittedUnits;
+}
+
+void IncrementalMinifier::join()
+{
+    m_Output.clear();
+    TokenType prevType{TokenType::END_OF_FILE};
+    for (const auto& unit : m_Units)
+    {
+        if (unit->output.empty())
+            continue;
+
+        TokenType first{unit->tokens.type(0)};
+        if (first == TokenType::PREPROCESSOR)
+        {
+            if (!m_Output.empty())
+                m_Output += '\n';
+        }
+        else if (!m_Output.empty() && m_Output.back() != '\n' && Minifier::needsSpaceBetween(prevType, first))
+            m_Output += ' ';
+
+        m_Output += unit->output;
+        prevType = unit->tokens.type(unit->tokens.size() - 1);
+    }
+}
+
+const std::string& IncrementalMinifier::update(std::string_view source)
+{
+    m_RelexedUnits = 0;
+    m_EmittedUnits = 0;
+    // the edit is whatever lies between the common prefix and the common suffix
+    std::size_t oldLength{m_Source.length()};
+    std::size_t newLength{source.length()};
+    std::size_t shorter{std::min(oldLength, newLength)};
+    std::size_t prefix{commonPrefix(source.data(), m_Source.data(), shorter)};
+    if (!m_Units.empty() && prefix == oldLength && prefix == newLength)
+        return m_Output;
+    std::size_t suffix{commonSuffix(source.data() + newLength, m_Source.data() + oldLength, shorter - prefix)};
+
+    // relexing starts at the unit holding the byte before the edit, its last token or # line could go on
+    std::size_t first{0};
+    std::size_t start{0};
+    while (first + 1 < m_Units.size() && start + m_Units[first]->text.length() < prefix)
+        start += m_Units[first++]->text.length();
+
+    // and stops once a new unit ends past the edit where an old unit ended, the rest lexes the same
+    std::vector<std::unique_ptr<Unit>> fresh;
+    std::size_t last{first};
+    std::size_t oldAt{start};
+    std::size_t at{start};
+    bool synced{false};
+    while (at < newLength && !synced)
+    {
+        fresh.push_back(lexUnit(source, at));
+        if (at < newLength - suffix)
+            continue;
+
+        std::size_t oldBoundary{at + oldLength - newLength};
+        while (last < m_Units.size() && oldAt < oldBoundary)
+            oldAt += m_Units[last++]->text.length();
+        synced = oldAt == oldBoundary;
+    }
+    if (!synced)
+        last = m_Units.size();
+
+    for (std::size_t i{first}; i < last; ++i)
+        countIdentifiers(*m_Units[i], -1);
+
+    std::unordered_map<std::string_view, int> freshUnits;
+    for (const auto& unit : fresh)
+    {
+        countIdentifiers(*unit, 1);
+        for (std::string_view name : unit->identifiers)
+            ++freshUnits[name];
+    }
+
+    // a renaming that other units depend on changed, those are not tracked so everything is emitted again
+    bool emitAll{false};
+    if (m_Rename)
+    {
+        for (const auto& unit : fresh)
+            emitAll |= collectProtected(*unit);
+
+        if (m_Units.empty())
+            renameAll(fresh);
+        else
+        {
+            for (const auto& unit : fresh)
+                emitAll |= collectDeclarations(*unit, freshUnits);
+            for (const auto& unit : fresh)
+                emitAll |= resolveClashes(*unit);
+        }
+    }
+
+    // the #version line is the first thing in the shader, so it is in the first unit or nowhere
+    LiteralRules literalRules;
+    const Unit* head{first > 0 ? m_Units[0].get() : fresh.empty() ? nullptr : fresh[0].get()};
+    if (head && !head->tokens.empty() && head->tokens.type(0) == TokenType::PREPROCESSOR)
+        literalRules.readDirective(head->tokens.lexeme(0));
+    if (!(literalRules == m_LiteralRules))
+    {
+        m_LiteralRules = literalRules;
+        emitAll = true;
+    }
+
+    if (!emitAll)
+        for (const auto& unit : fresh)
+            emit(*unit);
+    m_RelexedUnits = fresh.size();
+
+    m_Units.erase(m_Units.begin() + first, m_Units.begin() + last);
+    m_Units.insert(m_Units.begin() + first, std::make_move_iterator(fresh.begin()),
+                   std::make_move_iterator(fresh.end()));
+    if (emitAll)
+        for (auto& unit : m_Units)
+            emit(*unit);
+
+    m_Source.assign(source);
+    join();
+    return m_Output;
+}
@@ -0,0 +1,217 @@
+#include "Keywords.hpp"
+
+#include "PerfectHash.hpp"
+
+namespace
+{
+constexpr PerfectHashEntry<TokenType> KEYWORD_ENTRIES[]{
+    // types
+    {"void", TokenType::VOID}, {"float", TokenType::FLOAT}, {"int", TokenType::INT},
+    {"bool", TokenType::BOOL}, {"vec2", TokenType::VEC2}, {"vec3", TokenType::VEC3},
+    {"vec4", TokenType::VEC4}, {"ivec2", TokenType::IVEC2}, {"ivec3", TokenType::IVEC3},
+    {"ivec4", TokenType::IVEC4}, {"bvec2", TokenType::BVEC2}, {"bvec3", TokenType::BVEC3},
+    {"bvec4", TokenType::BVEC4}, {"mat2", TokenType::MAT2}, {"mat3", TokenType::MAT3},
+    {"mat4", TokenType::MAT4}, {"sampler2D", TokenType::SAMPLER2D}, {"samplerCube", TokenType::SAMPLER_CUBE},
+
+    // qualifiers
+    {"in", TokenType::IN}, {"out", TokenType::OUT}, {"inout", TokenType::INOUT},
+    {"uniform", TokenType::UNIFORM}, {"attribute", TokenType::ATTRIBUTE}, {"varying", TokenType::VARYING},
+    {"const", TokenType::CONST}, {"highp", TokenType::HIGHP}, {"mediump", TokenType::MEDIUMP},
+    {"lowp", TokenType::LOWP},
+
+    // control flow
+    {"if", TokenType::IF}, {"else", TokenType::ELSE}, {"for", TokenType::FOR}, {"while", TokenType::WHILE},
+    {"do", TokenType::DO}, {"break", TokenType::BREAK}, {"continue", TokenType::CONTINUE},
+    {"return", TokenType::RETURN}, {"discard", TokenType::DISCARD}, {"struct", TokenType::STRUCT},
+
+    // other builtin types
+    {"double", TokenType::TYPE}, {"uint", TokenType::TYPE}, {"atomic_uint", TokenType::TYPE},
+    {"uvec2", TokenType::TYPE}, {"uvec3", TokenType::TYPE}, {"uvec4", TokenType::TYPE},
+    {"dvec2", TokenType::TYPE}, {"dvec3", TokenType::TYPE}, {"dvec4", TokenType::TYPE},
+    {"mat2x2", TokenType::TYPE}, {"mat2x3", TokenType::TYPE}, {"mat2x4", TokenType::TYPE},
+    {"mat3x2", TokenType::TYPE}, {"mat3x3", TokenType::TYPE}, {"mat3x4", TokenType::TYPE},
+    {"mat4x2", TokenType::TYPE}, {"mat4x3", TokenType::TYPE}, {"mat4x4", TokenType::TYPE},
+    {"dmat2", TokenType::TYPE}, {"dmat3", TokenType::TYPE}, {"dmat4", TokenType::TYPE},
+    {"dmat2x2", TokenType::TYPE}, {"dmat2x3", TokenType::TYPE}, {"dmat2x4", TokenType::TYPE},
+    {"dmat3x2", TokenType::TYPE}, {"dmat3x3", TokenType::TYPE}, {"dmat3x4", TokenType::TYPE},
+    {"dmat4x2", TokenType::TYPE}, {"dmat4x3", TokenType::TYPE}, {"dmat4x4", TokenType::TYPE},
+    {"sampler1D", TokenType::TYPE}, {"sampler1DShadow", TokenType::TYPE}, {"sampler1DArray", TokenType::TYPE},
+    {"sampler1DArrayShadow", TokenType::TYPE}, {"isampler1D", TokenType::TYPE},
+    {"isampler1DArray", TokenType::TYPE}, {"usampler1D", TokenType::TYPE},
+    {"usampler1DArray", TokenType::TYPE}, {"sampler2DShadow", TokenType::TYPE},
+    {"sampler2DArray", TokenType::TYPE}, {"sampler2DArrayShadow", TokenType::TYPE},
+    {"isampler2D", TokenType::TYPE}, {"isampler2DArray", TokenType::TYPE}, {"usampler2D", TokenType::TYPE},
+    {"usampler2DArray", TokenType::TYPE}, {"sampler2DRect", TokenType::TYPE},
+    {"sampler2DRectShadow", TokenType::TYPE}, {"isampler2DRect", TokenType::TYPE},
+    {"usampler2DRect", TokenType::TYPE}, {"sampler2DMS", TokenType::TYPE}, {"isampler2DMS", TokenType::TYPE},
+    {"usampler2DMS", TokenType::TYPE}, {"sampler2DMSArray", TokenType::TYPE},
+    {"isampler2DMSArray", TokenType::TYPE}, {"usampler2DMSArray", TokenType::TYPE},
+    {"sampler3D", TokenType::TYPE}, {"isampler3D", TokenType::TYPE}, {"usampler3D", TokenType::TYPE},
+    {"samplerCubeShadow", TokenType::TYPE}, {"isamplerCube", TokenType::TYPE},
+    {"usamplerCube", TokenType::TYPE}, {"samplerCubeArray", TokenType::TYPE},
+    {"samplerCubeArrayShadow", TokenType::TYPE}, {"isamplerCubeArray", TokenType::TYPE},
+    {"usamplerCubeArray", TokenType::TYPE}, {"samplerBuffer", TokenType::TYPE},
+    {"isamplerBuffer", TokenType::TYPE}, {"usamplerBuffer", TokenType::TYPE},
+    {"samplerExternalOES", TokenType::TYPE}, {"image1D", TokenType::TYPE}, {"iimage1D", TokenType::TYPE},
+    {"uimage1D", TokenType::TYPE}, {"image1DArray", TokenType::TYPE}, {"iimage1DArray", TokenType::TYPE},
+    {"uimage1DArray", TokenType::TYPE}, {"image2D", TokenType::TYPE}, {"iimage2D", TokenType::TYPE},
+    {"uimage2D", TokenType::TYPE}, {"image2DArray", TokenType::TYPE}, {"iimage2DArray", TokenType::TYPE},
+    {"uimage2DArray", TokenType::TYPE}, {"image2DRect", TokenType::TYPE}, {"iimage2DRect", TokenType::TYPE},
+    {"uimage2DRect", TokenType::TYPE}, {"image2DMS", TokenType::TYPE}, {"iimage2DMS", TokenType::TYPE},
+    {"uimage2DMS", TokenType::TYPE}, {"image2DMSArray", TokenType::TYPE},
+    {"iimage2DMSArray", TokenType::TYPE}, {"uimage2DMSArray", TokenType::TYPE}, {"image3D", TokenType::TYPE},
+    {"iimage3D", TokenType::TYPE}, {"uimage3D", TokenType::TYPE}, {"imageCube", TokenType::TYPE},
+    {"iimageCube", TokenType::TYPE}, {"uimageCube", TokenType::TYPE}, {"imageCubeArray", TokenType::TYPE},
+    {"iimageCubeArray", TokenType::TYPE}, {"uimageCubeArray", TokenType::TYPE},
+    {"imageBuffer", TokenType::TYPE}, {"iimageBuffer", TokenType::TYPE}, {"uimageBuffer", TokenType::TYPE},
+
+    // other keywords
+    {"buffer", TokenType::KEYWORD}, {"shared", TokenType::KEYWORD}, {"coherent", TokenType::KEYWORD},
+    {"volatile", TokenType::KEYWORD}, {"restrict", TokenType::KEYWORD}, {"readonly", TokenType::KEYWORD},
+    {"writeonly", TokenType::KEYWORD}, {"layout", TokenType::KEYWORD}, {"centroid", TokenType::KEYWORD},
+    {"flat", TokenType::KEYWORD}, {"smooth", TokenType::KEYWORD}, {"noperspective", TokenType::KEYWORD},
+    {"patch", TokenType::KEYWORD}, {"sample", TokenType::KEYWORD}, {"invariant", TokenType::KEYWORD},
+    {"precise", TokenType::KEYWORD}, {"subroutine", TokenType::KEYWORD}, {"precision", TokenType::KEYWORD},
+    {"switch", TokenType::KEYWORD}, {"case", TokenType::KEYWORD}, {"default", TokenType::KEYWORD},
+    {"true", TokenType::KEYWORD}, {"false", TokenType::KEYWORD},
+
+    // reserved for future use, never valid identifiers
+    {"common", TokenType::KEYWORD}, {"partition", TokenType::KEYWORD}, {"active", TokenType::KEYWORD},
+    {"asm", TokenType::KEYWORD}, {"class", TokenType::KEYWORD}, {"union", TokenType::KEYWORD},
+    {"enum", TokenType::KEYWORD}, {"typedef", TokenType::KEYWORD}, {"template", TokenType::KEYWORD},
+    {"this", TokenType::KEYWORD}, {"resource", TokenType::KEYWORD}, {"goto", TokenType::KEYWORD},
+    {"inline", TokenType::KEYWORD}, {"noinline", TokenType::KEYWORD}, {"public", TokenType::KEYWORD},
+    {"static", TokenType::KEYWORD}, {"extern", TokenType::KEYWORD}, {"external", TokenType::KEYWORD},
+    {"interface", TokenType::KEYWORD}, {"long", TokenType::KEYWORD}, {"short", TokenType::KEYWORD},
+    {"half", TokenType::KEYWORD}, {"fixed", TokenType::KEYWORD}, {"unsigned", TokenType::KEYWORD},
+    {"superp", TokenType::KEYWORD}, {"input", TokenType::KEYWORD}, {"output", TokenType::KEYWORD},
+    {"hvec2", TokenType::KEYWORD}, {"hvec3", TokenType::KEYWORD}, {"hvec4", TokenType::KEYWORD},
+    {"fvec2", TokenType::KEYWORD}, {"fvec3", TokenType::KEYWORD}, {"fvec4", TokenType::KEYWORD},
+    {"sampler3DRect", TokenType::KEYWORD}, {"filter", TokenType::KEYWORD}, {"sizeof", TokenType::KEYWORD},
+    {"cast", TokenType::KEYWORD}, {"namespace", TokenType::KEYWORD}, {"using", TokenType::KEYWORD},
+};
+
+constexpr PerfectHashEntry<bool> BUILTIN_ENTRIES[]{
+    // angle and trigonometry
+    {"radians", true}, {"degrees", true}, {"sin", true}, {"cos", true}, {"tan", true}, {"asin", true},
+    {"acos", true}, {"atan", true}, {"sinh", true}, {"cosh", true}, {"tanh", true}, {"asinh", true},
+    {"acosh", true}, {"atanh", true},
+
+    // exponential
+    {"pow", true}, {"exp", true}, {"log", true}, {"exp2", true}, {"log2", true}, {"sqrt", true},
+    {"inversesqrt", true},
+
+    // common
+    {"abs", true}, {"sign", true}, {"floor", true}, {"trunc", true}, {"round", true}, {"roundEven", true},
+    {"ceil", true}, {"fract", true}, {"mod", true}, {"modf", true}, {"min", true}, {"max", true},
+    {"clamp", true}, {"mix", true}, {"step", true}, {"smoothstep", true}, {"isnan", true}, {"isinf", true},
+    {"floatBitsToInt", true}, {"floatBitsToUint", true}, {"intBitsToFloat", true}, {"uintBitsToFloat", true},
+    {"fma", true}, {"frexp", true}, {"ldexp", true},
+
+    // packing
+    {"packUnorm2x16", true}, {"packSnorm2x16", true}, {"packUnorm4x8", true}, {"packSnorm4x8", true},
+    {"unpackUnorm2x16", true}, {"unpackSnorm2x16", true}, {"unpackUnorm4x8", true}, {"unpackSnorm4x8", true},
+    {"packHalf2x16", true}, {"unpackHalf2x16", true}, {"packDouble2x32", true}, {"unpackDouble2x32", true},
+
+    // geometric
+    {"length", true}, {"distance", true}, {"dot", true}, {"cross", true}, {"normalize", true},
+    {"ftransform", true}, {"faceforward", true}, {"reflect", true}, {"refract", true},
+
+    // matrix
+    {"matrixCompMult", true}, {"outerProduct", true}, {"transpose", true}, {"determinant", true},
+    {"inverse", true},
+
+    // vector relational
+    {"lessThan", true}, {"lessThanEqual", true}, {"greaterThan", true}, {"greaterThanEqual", true},
+    {"equal", true}, {"notEqual", true}, {"any", true}, {"all", true}, {"not", true},
+
+    // integer
+    {"uaddCarry", true}, {"usubBorrow", true}, {"umulExtended", true}, {"imulExtended", true},
+    {"bitfieldExtract", true}, {"bitfieldInsert", true}, {"bitfieldReverse", true}, {"bitCount", true},
+    {"findLSB", true}, {"findMSB", true},
+
+    // texture
+    {"textureSize", true}, {"textureQueryLod", true}, {"textureQueryLevels", true}, {"textureSamples", true},
+    {"texture", true}, {"textureProj", true}, {"textureLod", true}, {"textureOffset", true},
+    {"texelFetch", true}, {"texelFetchOffset", true}, {"textureProjOffset", true}, {"textureLodOffset", true},
+    {"textureProjLod", true}, {"textureProjLodOffset", true}, {"textureGrad", true},
+    {"textureGradOffset", true}, {"textureProjGrad", true}, {"textureProjGradOffset", true},
+    {"textureGather", true}, {"textureGatherOffset", true}, {"textureGatherOffsets", true},
+
+    // compatibility and GLSL ES 1.00 texture
+    {"texture1D", true}, {"texture1DProj", true}, {"texture1DLod", true}, {"texture1DProjLod", true},
+    {"texture2D", true}, {"texture2DProj", true}, {"texture2DLod", true}, {"texture2DProjLod", true},
+    {"texture3D", true}, {"texture3DProj", true}, {"texture3DLod", true}, {"texture3DProjLod", true},
+    {"textureCube", true}, {"textureCubeLod", true}, {"shadow1D", true}, {"shadow2D", true},
+    {"shadow1DProj", true}, {"shadow2DProj", true}, {"shadow1DLod", true}, {"shadow2DLod", true},
+    {"shadow1DProjLod", true}, {"shadow2DProjLod", true}, {"texture2DLodEXT", true},
+    {"texture2DProjLodEXT", true}, {"textureCubeLodEXT", true}, {"texture2DGradEXT", true},
+    {"texture2DProjGradEXT", true}, {"textureCubeGradEXT", true},
+
+    // atomic counters
+    {"atomicCounterIncrement", true}, {"atomicCounterDecrement", true}, {"atomicCounter", true},
+    {"atomicCounterAdd", true}, {"atomicCounterSubtract", true}, {"atomicCounterMin", true},
+    {"atomicCounterMax", true}, {"atomicCounterAnd", true}, {"atomicCounterOr", true},
+    {"atomicCounterXor", true}, {"atomicCounterExchange", true}, {"atomicCounterCompSwap", true},
+
+    // atomic memory
+    {"atomicAdd", true}, {"atomicMin", true}, {"atomicMax", true}, {"atomicAnd", true}, {"atomicOr", true},
+    {"atomicXor", true}, {"atomicExchange", true}, {"atomicCompSwap", true},
+
+    // image
+    {"imageSize", true}, {"imageSamples", true}, {"imageLoad", true}, {"imageStore", true},
+    {"imageAtomicAdd", true}, {"imageAtomicMin", true}, {"imageAtomicMax", true}, {"imageAtomicAnd", true},
+    {"imageAtomicOr", true}, {"imageAtomicXor", true}, {"imageAtomicExchange", true},
+    {"imageAtomicCompSwap", true},
+
+    // geometry shader
+    {"EmitStreamVertex", true}, {"EndStreamPrimitive", true}, {"EmitVertex", true}, {"EndPrimitive", true},
+
+    // derivatives and interpolation
+    {"dFdx", true}, {"dFdy", true}, {"dFdxFine", true}, {"dFdyFine", true}, {"dFdxCoarse", true},
+    {"dFdyCoarse", true}, {"fwidth", true}, {"fwidthFine", true}, {"fwidthCoarse", true},
+    {"interpolateAtCentroid", true}, {"interpolateAtSample", true}, {"interpolateAtOffset", true},
+
+    // noise
+    {"noise1", true}, {"noise2", true}, {"noise3", true}, {"noise4", true},
+
+    // barriers and invocation
+    {"barrier", true}, {"memoryBarrier", true}, {"memoryBarrierAtomicCounter", true},
+    {"memoryBarrierBuffer", true}, {"memoryBarrierShared", true}, {"memoryBarrierImage", true},
+    {"groupMemoryBarrier", true}, {"subpassLoad", true}, {"anyInvocation", true}, {"allInvocations", true},
+    {"allInvocationsEqual", true},
+};
+
+constexpr auto KEYWORDS{makePerfectHashTable(KEYWORD_ENTRIES)};
+constexpr auto BUILTINS{makePerfectHashTable(BUILTIN_ENTRIES)};
+
+// every word TOKEN_TYPES spells out has to be a keyword of that type
+constexpr bool matchesTokenTypes()
+{
+    for (std::size_t i{0}; i < TOKEN_TYPE_COUNT; ++i)
+    {
+        std::string_view spelling{TOKEN_SPELLINGS[i]};
+        if (!hasTrait(static_cast<TokenType>(i), TRAIT_WORD) || spelling.empty())
+            continue;
+        const TokenType* type{KEYWORDS.find(spelling)};
+        if (!type || *type != static_cast<TokenType>(i))
+            return false;
+    }
+    return true;
+}
+
+static_assert(matchesTokenTypes());
+static_assert(KEYWORDS.find("samplerCube") && *KEYWORDS.find("samplerCube") == TokenType::SAMPLER_CUBE);
+static_assert(BUILTINS.contains("smoothstep") && !BUILTINS.contains("smoothstep_"));
+}
+
+TokenType lookupKeyword(std::string_view text)
+{
+    const TokenType* type{KEYWORDS.find(text)};
+    return type ? *type : TokenType::IDENTIFIER;
+}
+
+bool isBuiltinName(std::string_view name)
+{
+    return BUILTINS.contains(name);
+}
@@ -0,0 +1,230 @@
+#include "Lexer.hpp"
+#include "CharClass.hpp"
+#include "Keywords.hpp"
+#include "TextScan.hpp"
+
+namespace
+{
+// operators and delimiters, keyed by their first character
+// a rule is the single character token plus up to two longer tokens picked by the second character
+struct OperatorRule
+{
+    TokenType single{TokenType::ERROR};
+    uint8_t pairCount{0};
+    char second[2]{};
+    TokenType paired[2]{};
+};
+
+constexpr std::array<OperatorRule, 256> makeOperatorTable()
+{
+    // straight from the spellings of TOKEN_TYPES, the one character tokens first so the pairs find their rule
+    std::array<OperatorRule, 256> table{};
+    for (std::size_t i{0}; i < TOKEN_TYPE_COUNT; ++i)
+    {
+        std::string_view spelling{TOKEN_SPELLINGS[i]};
+        if (spelling.length() == 1)
+            table[static_cast<unsigned char>(spelling[0])].single = static_cast<TokenType>(i);
+    }
+    for (std::size_t i{0}; i < TOKEN_TYPE_COUNT; ++i)
+    {
+        std::string_view spelling{TOKEN_SPELLINGS[i]};
+        if (spelling.length() != 2 || hasTrait(static_cast<TokenType>(i), TRAIT_WORD))
+            continue;
+        OperatorRule& r{table[static_cast<unsigned char>(spelling[0])]};
+        r.second[r.pairCount] = spelling[1];
+        r.paired[r.pairCount] = static_cast<TokenType>(i);
+        ++r.pairCount;
+    }
+    return table;
+}
+
+constexpr std::array<OperatorRule, 256> OPERATORS{makeOperatorTable()};
+
+static_assert(OPERATORS['-'].single == TokenType::MINUS && OPERATORS['-'].pairCount == 2);
+
+// numeric literals: 12, 0x1F, 7u, 1.5, 1., .5, 2e-3, 1.e5, 1.0f, 3.0lf
+// a '.' starts one only when a digit follows, anything else is a DOT token
+enum NumberClass : uint8_t
+{
+    NC_DIGIT, NC_HEX_LETTER, NC_E, NC_LOWER_F, NC_UPPER_F, NC_X, NC_U, NC_LOWER_L, NC_UPPER_L, NC_SIGN, NC_DOT,
+    NC_OTHER, NC_COUNT
+};
+
+enum NumberState : uint8_t
+{
+    NS_ZERO, NS_INT, NS_DOT, NS_FRAC, NS_EXP, NS_EXP_SIGN, NS_EXP_DIGITS, NS_HEX_PREFIX, NS_HEX,
+    NS_FLOAT_SUFFIX, NS_UINT_SUFFIX, NS_LOWER_L, NS_UPPER_L, NS_DOUBLE_SUFFIX, NS_DEAD, NS_COUNT
+};
+
+constexpr std::array<uint8_t, 256> makeNumberClasses()
+{
+    std::array<uint8_t, 256> table{};
+    for (auto& entry : table)
+        entry = NC_OTHER;
+    for (int c{'0'}; c <= '9'; ++c)
+        table[c] = NC_DIGIT;
+    for (char c : {'a', 'b', 'c', 'd', 'A', 'B', 'C', 'D'})
+        table[static_cast<unsigned char>(c)] = NC_HEX_LETTER;
+    table['e'] = table['E'] = NC_E;
+    table['f'] = NC_LOWER_F;
+    table['F'] = NC_UPPER_F;
+    table['x'] = table['X'] = NC_X;
+    table['u'] = table['U'] = NC_U;
+    table['l'] = NC_LOWER_L;
+    table['L'] = NC_UPPER_L;
+    table['+'] = table['-'] = NC_SIGN;
+    table['.'] = NC_DOT;
+    return table;
+}
+
+struct NumberMachine
+{
+    std::array<std::array<uint8_t, NC_COUNT>, NS_COUNT> next{};
+    std::array<bool, NS_COUNT> accepting{};
+};
+
+constexpr NumberMachine makeNumberMachine()
+{
+    NumberMachine m{};
+    for (auto& row : m.next)
+        for (auto& state : row)
+            state = NS_DEAD;
+
+    auto floatTail{
+        [&m](uint8_t from)
+        {
+            m.next[from][NC_LOWER_F] = NS_FLOAT_SUFFIX;
+            m.next[from][NC_UPPER_F] = NS_FLOAT_SUFFIX;
+        }
+    };
+    auto doubleTail{
+        [&m](uint8_t from)
+        {
+            m.next[from][NC_LOWER_L] = NS_LOWER_L;
+            m.next[from][NC_UPPER_L] = NS_UPPER_L;
+        }
+    };
+
+    for (uint8_t from : {NS_ZERO, NS_INT})
+    {
+        m.next[from][NC_DIGIT] = NS_INT;
+        m.next[from][NC_DOT] = NS_DOT;
+        m.next[from][NC_E] = NS_EXP;
+        m.next[from][NC_U] = NS_UINT_SUFFIX;
+        floatTail(from);
+    }
+    m.next[NS_ZERO][NC_X] = NS_HEX_PREFIX;
+
+    // "1." is a float on its own, so is "1.e5"
+    m.next[NS_DOT][NC_DIGIT] = NS_FRAC;
+    m.next[NS_DOT][NC_E] = NS_EXP;
+    floatTail(NS_DOT);
+    doubleTail(NS_DOT);
+
+    m.next[NS_FRAC][NC_DIGIT] = NS_FRAC;
+    m.next[NS_FRAC][NC_E] = NS_EXP;
+    floatTail(NS_FRAC);
+    doubleTail(NS_FRAC);
+
+    // the exponent letter and sign are taken even without digits
+    m.next[NS_EXP][NC_SIGN] = NS_EXP_SIGN;
+    for (uint8_t from : {NS_EXP, NS_EXP_SIGN, NS_EXP_DIGITS})
+    {
+        m.next[from][NC_DIGIT] = NS_EXP_DIGITS;
+        floatTail(from);
+    }
+    doubleTail(NS_EXP_DIGITS);
+
+    for (uint8_t from : {NS_HEX_PREFIX, NS_HEX})
+        for (uint8_t cls : {NC_DIGIT, NC_HEX_LETTER, NC_E, NC_LOWER_F, NC_UPPER_F})
+            m.next[from][cls] = NS_HEX;
+    m.next[NS_HEX][NC_U] = NS_UINT_SUFFIX;
+
+    m.next[NS_LOWER_L][NC_LOWER_F] = NS_DOUBLE_SUFFIX;
+    m.next[NS_UPPER_L][NC_UPPER_F] = NS_DOUBLE_SUFFIX;
+
+    for (uint8_t state : {NS_ZERO, NS_INT, NS_DOT, NS_FRAC, NS_EXP, NS_EXP_SIGN, NS_EXP_DIGITS, NS_HEX, NS_FLOAT_SUFFIX,
+                          NS_UINT_SUFFIX, NS_DOUBLE_SUFFIX})
+        m.accepting[state] = true;
+    return m;
+}
+
+constexpr std::array<uint8_t, 256> NUMBER_CLASSES{makeNumberClasses()};
+constexpr NumberMachine NUMBER_MACHINE{makeNumberMachine()};
+
+// longest accepted prefix, p is on a digit or on a '.' before one
+uint32_t lexNumber(const char* p, const char* end)
+{
+    uint8_t state{*p == '0' ? NS_ZERO : *p == '.' ? NS_DOT : NS_INT};
+    const char* q{p + 1};
+    const char* accepted{q};
+
+    while (q < end)
+    {
+        state = NUMBER_MACHINE.next[state][NUMBER_CLASSES[static_cast<unsigned char>(*q)]];
+        if (state == NS_DEAD)
+            break;
+        ++q;
+        if (NUMBER_MACHINE.accepting[state])
+            accepted = q;
+    }
+    return static_cast<uint32_t>(accepted - p);
+}
+}
+
+const char* skipTrivia(const char* p, const char* end, int& lines)
+{
+    // whitespace and comment bodies are skipped in blocks, see TextScan
+    while (p < end)
+    {
+        char c{*p};
+        if (c == ' ' || c == '\r' || c == '\t' || c == '\n')
+            p = skipBlanks(p, end, lines);
+        else if (c == '/' && p + 1 < end && p[1] == '/') // this is a comment, go to end of the line
+            p = findNewline(p + 2, end);
+        else if (c == '/' && p + 1 < end && p[1] == '*') //multiline comment
+        {
+            p = findBlockCommentEnd(p + 2, end, lines);
+            if (p < end)
+                p += 2;
+        }
+        else
+            break;
+    }
+    return p;
+}
+
+Lexeme lexToken(const char* p, const char* end)
+{
+    char c{*p};
+    uint8_t cls{CHAR_CLASSES[static_cast<unsigned char>(c)]};
+
+    if (cls & CHAR_IDENT_START)
+    {
+        const char* q{p + 1};
+        while (q < end && isIdentChar(*q))
+            ++q;
+        auto length{static_cast<uint32_t>(q - p)};
+        return {lookupKeyword({p, length}), length};
+    }
+
+    if ((cls & CHAR_DIGIT) || (c == '.' && p + 1 < end && isDigitChar(p[1])))
+        return {TokenType::NUMBER, lexNumber(p, end)};
+
+    if (cls & CHAR_OPERATOR)
+    {
+        const OperatorRule& rule{OPERATORS[static_cast<unsigned char>(c)]};
+        if (p + 1 < end)
+        {
+            for (uint8_t i{0}; i < rule.pairCount; ++i)
+                if (p[1] == rule.second[i])
+                    return {rule.paired[i], 2};
+        }
+        return {rule.single, 1};
+    }
+
+    if (c == '#')
+        return {TokenType::PREPROCESSOR, static_cast<uint32_t>(findNewline(p, end) - p)};
+
+    return {TokenType::ERROR, 1};
+}
@@ -0,0 +1,36 @@
+#include "LineIndex.hpp"
+#include "TextScan.hpp"
+
+#include <algorithm>
+
+LineIndex::LineIndex(std::string_view source)
+    : m_Source{source}
+{
+    const char* begin{source.data()};
+    const char* end{begin + source.length()};
+
+    m_LineStarts.push_back(0);
+    for (const char* p{findNewline(begin, end)}; p < end; p = findNewline(p + 1, end))
+        m_LineStarts.push_back(static_cast<std::size_t>(p + 1 - begin));
+}
+
+int LineIndex::lineOf(std::size_t offset) const
+{
+    auto it{std::upper_bound(m_LineStarts.begin(), m_LineStarts.end(), offset)};
+    return static_cast<int>(it - m_LineStarts.begin());
+}
+
+int LineIndex::columnOf(std::size_t offset) const
+{
+    return static_cast<int>(offset - m_LineStarts[lineOf(offset) - 1]) + 1;
+}
+
+std::string_view LineIndex::lineText(int line) const
+{
+    if (line < 1 || static_cast<std::size_t>(line) > m_LineStarts.size())
+        return {};
+
+    std::size_t start{m_LineStarts[line - 1]};
+    std::size_t end{static_cast<std::size_t>(line) < m_LineStarts.size() ? m_LineStarts[line] - 1 : m_Source.length()};
+    return m_Source.substr(start, end - start);
+}
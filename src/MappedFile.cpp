@@ -0,0 +1,101 @@
+#include "MappedFile.hpp"
+
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+
+void MappedFile::release()
+{
+    if (m_Mapped)
+        ::munmap(const_cast<char*>(m_Data), m_Size);
+    m_Data = nullptr;
+    m_Size = 0;
+    m_Mapped = false;
+    m_Buffer.clear();
+}
+
+bool MappedFile::open(const std::string& path)
+{
+    release();
+
+    int fd{::open(path.c_str(), O_RDONLY)};
+    if (fd < 0)
+        return false;
+
+    struct stat info{};
+    bool regular{::fstat(fd, &info) == 0 && S_ISREG(info.st_mode)};
+    if (regular && static_cast<std::size_t>(info.st_size) >= MIN_MAPPED_SIZE)
+    {
+        void* data{::mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0)};
+        if (data != MAP_FAILED)
+        {
+            // the scanner reads front to back once
+            ::madvise(data, static_cast<std::size_t>(info.st_size), MADV_SEQUENTIAL);
+            m_Data = static_cast<const char*>(data);
+            m_Size = static_cast<std::size_t>(info.st_size);
+            m_Mapped = true;
+            ::close(fd);
+            return true;
+        }
+    }
+
+    // pipes, small, empty or unmappable files, sized up front when the size is known
+    m_Buffer.resize(regular && info.st_size > 0 ? static_cast<std::size_t>(info.st_size) : 64 * 1024);
+    std::size_t used{0};
+    for (;;)
+    {
+        if (used == m_Buffer.size())
+            m_Buffer.resize(m_Buffer.size() * 2);
+
+        ssize_t n{::read(fd, m_Buffer.data() + used, m_Buffer.size() - used)};
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0)
+        {
+            ::close(fd);
+            m_Buffer.clear();
+            return false;
+        }
+        if (n == 0)
+            break;
+        used += static_cast<std::size_t>(n);
+    }
+    ::close(fd);
+
+    m_Buffer.resize(used);
+    m_Data = m_Buffer.data();
+    m_Size = used;
+    return true;
+}
+
+MappedFile::~MappedFile()
+{
+    release();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+{
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+    if (this != &other)
+    {
+        release();
+        m_Mapped = other.m_Mapped;
+        m_Size = other.m_Size;
+        m_Buffer = std::move(other.m_Buffer);
+        // a moved short string does not keep its address
+        m_Data = m_Mapped ? other.m_Data : m_Buffer.data();
+
+        other.m_Data = nullptr;
+        other.m_Size = 0;
+        other.m_Mapped = false;
+        other.m_Buffer.clear();
+    }
+    return *this;
+}
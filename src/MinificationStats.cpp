@@ -11,17 +11,37 @@ void MinificationStats::stopTiming()
     m_ProcessingTimeMs = std::chrono::duration<double, std::milli>{endTime - m_StartTime}.count();
 }
 
-void MinificationStats::print()
+void MinificationStats::add(const MinificationStats& other)
+{
+    m_OriginalSize += other.m_OriginalSize;
+    m_MinifiedSize += other.m_MinifiedSize;
+    m_DeflatedSize += other.m_DeflatedSize;
+    m_VariablesRenamed += other.m_VariablesRenamed;
+    m_FunctionsFound += other.m_FunctionsFound;
+    m_UniformsFound += other.m_UniformsFound;
+    m_DeadCodeRemoved += other.m_DeadCodeRemoved;
+    m_DeadCodeBytes += other.m_DeadCodeBytes;
+    m_FoldedNodes += other.m_FoldedNodes;
+    m_FoldedBytes += other.m_FoldedBytes;
+}
+
+void MinificationStats::print() const
 {
     std::cout << "\nOriginal size:\t\t" << m_OriginalSize << " bytes\n";
     std::cout << "\nMinified size:\t\t" << m_MinifiedSize << " bytes\n";
     std::cout << "\nBytes reduced:\t\t" << getBytesReduced() << " bytes\n";
     std::cout << "\nCompression ratio:\t\t" << getCompressionRatio() << " %\n";
+    if (m_DeflatedSize != 0)
+        std::cout << "\nDeflated size:\t\t" << m_DeflatedSize << " bytes (estimate)\n";
 
     std::cout << "\nVariables renamed:\t\t" << m_VariablesRenamed << " bytes\n";
     std::cout << "\nFunctions found:\t\t" << m_FunctionsFound << " bytes\n";
     std::cout << "\nUniforms found:\t\t" << m_UniformsFound << " bytes\n";
     std::cout << "\nDead code remove:\t\t" << m_DeadCodeRemoved << " bytes\n";
+    if (m_DeadCodeBytes != 0)
+        std::cout << "\nDead code source:\t\t" << m_DeadCodeBytes << " bytes\n";
+    if (m_FoldedNodes != 0)
+        std::cout << "\nConstants folded:\t\t" << m_FoldedNodes << " nodes, " << m_FoldedBytes << " bytes\n";
 
     std::cout << "\nProcessing time:\t\t" << m_ProcessingTimeMs << " ms\n";
 
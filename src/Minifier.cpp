@@ -1,335 +1,797 @@
 #include "Minifier.hpp"
+#include "DeflateEstimator.hpp"
+#include "Keywords.hpp"
+#include "OutputSink.hpp"
+#include "Parser.hpp"
 
+#include <array>
+#include <chrono>
 #include <iostream>
+#include <iterator>
+#include <numeric>
+#include <random>
 
-void Minifier::initBuiltins()
+namespace
 {
-    //builtin variables
-    m_Builtins.insert("gl_Position");
-    m_Builtins.insert("gl_FragColor");
-    m_Builtins.insert("gl_FragCoord");
-    m_Builtins.insert("gl_FragDepth");
-    m_Builtins.insert("gl_PointSize");
-    m_Builtins.insert("gl_VertexID");
-    m_Builtins.insert("gl_InstanceID");
-    m_Builtins.insert("gl_FrontFacing");
-
-    // builtin functions
-    m_Builtins.insert("texture");
-    m_Builtins.insert("texture2D");
-    m_Builtins.insert("textureCube");
-    m_Builtins.insert("sin");
-    m_Builtins.insert("cos");
-    m_Builtins.insert("tan");
-    m_Builtins.insert("asin");
-    m_Builtins.insert("acos");
-    m_Builtins.insert("atan");
-    m_Builtins.insert("pow");
-    m_Builtins.insert("exp");
-    m_Builtins.insert("exp2");
-    m_Builtins.insert("log");
-    m_Builtins.insert("log2");
-    m_Builtins.insert("sqrt");
-    m_Builtins.insert("inversesqrt");
-    m_Builtins.insert("abs");
-    m_Builtins.insert("sign");
-    m_Builtins.insert("floor");
-    m_Builtins.insert("ceil");
-    m_Builtins.insert("fract");
-    m_Builtins.insert("mod");
-    m_Builtins.insert("min");
-    m_Builtins.insert("max");
-    m_Builtins.insert("clamp");
-    m_Builtins.insert("mix");
-    m_Builtins.insert("step");
-    m_Builtins.insert("smoothstep");
-    m_Builtins.insert("length");
-    m_Builtins.insert("distance");
-    m_Builtins.insert("dot");
-    m_Builtins.insert("cross");
-    m_Builtins.insert("normalize");
-    m_Builtins.insert("reflect");
-    m_Builtins.insert("refract");
-    m_Builtins.insert("faceforward");
-    m_Builtins.insert("matrixCompMult");
-    m_Builtins.insert("lessThan");
-    m_Builtins.insert("lessThanEqual");
-    m_Builtins.insert("greaterThan");
-    m_Builtins.insert("greaterThanEqual");
-    m_Builtins.insert("equal");
-    m_Builtins.insert("notEqual");
-    m_Builtins.insert("any");
-    m_Builtins.insert("all");
-    m_Builtins.insert("not");
-    m_Builtins.insert("dFdx");
-    m_Builtins.insert("dFdy");
-    m_Builtins.insert("fwidth");
+    constexpr bool separates(TokenType prev, TokenType curr)
+    {
+        // "structLight" or "return1" would lex as one name
+        if (hasTrait(prev, TRAIT_WORD) && hasTrait(curr, TRAIT_WORD))
+            return true;
+
+        // "1 .x" and ". 5" would lex as one number
+        if ((prev == TokenType::NUMBER && curr == TokenType::DOT) ||
+            (prev == TokenType::DOT && curr == TokenType::NUMBER))
+            return true;
+
+        // "- -x" and "+ ++x" would lex as one operator, "/ /" as a comment
+        std::string_view first{TOKEN_SPELLINGS[static_cast<std::size_t>(prev)]};
+        std::string_view second{TOKEN_SPELLINGS[static_cast<std::size_t>(curr)]};
+        if (first.length() != 1 || second.empty())
+            return false;
+        if (first[0] == '/' && (second[0] == '/' || second[0] == '*'))
+            return true;
+        for (std::string_view spelling : TOKEN_SPELLINGS)
+        {
+            if (spelling.length() == 2 && spelling[0] == first[0] && spelling[1] == second[0])
+                return true;
+        }
+        return false;
+    }
+
+    // by prev * TOKEN_TYPE_COUNT + curr
+    constexpr std::array<bool, TOKEN_TYPE_COUNT * TOKEN_TYPE_COUNT> makeSeparatorTable()
+    {
+        std::array<bool, TOKEN_TYPE_COUNT * TOKEN_TYPE_COUNT> table{};
+        for (std::size_t prev{0}; prev < TOKEN_TYPE_COUNT; ++prev)
+        {
+            for (std::size_t curr{0}; curr < TOKEN_TYPE_COUNT; ++curr)
+                table[prev * TOKEN_TYPE_COUNT + curr] = separates(static_cast<TokenType>(prev),
+                                                                  static_cast<TokenType>(curr));
+        }
+        return table;
+    }
+
+    constexpr std::array<bool, TOKEN_TYPE_COUNT * TOKEN_TYPE_COUNT> SEPARATORS{makeSeparatorTable()};
+
+    static_assert(SEPARATORS[static_cast<std::size_t>(TokenType::MINUS) * TOKEN_TYPE_COUNT +
+                             static_cast<std::size_t>(TokenType::MINUS_MINUS)]);
+    static_assert(!SEPARATORS[static_cast<std::size_t>(TokenType::AMPERSAND) * TOKEN_TYPE_COUNT +
+                              static_cast<std::size_t>(TokenType::EQUAL)]);
 }
 
-bool Minifier::isBuiltin(const std::string& name) const
+bool Minifier::isBuiltin(std::string_view name)
 {
     if (name.length() >= 3 && name[0] == 'g' && name[1] == 'l' && name[2] == '_')
         return true;
 
-    if (name.find("__") != std::string::npos)
+    if (name.find("__") != std::string_view::npos)
         return true;
 
-    return m_Builtins.find(name) != m_Builtins.end();
+    return isBuiltinName(name);
 }
 
-bool Minifier::isTypeQualifier(TokenType type) const
+bool Minifier::isReservedName(std::string_view name)
 {
-    return type == TokenType::IN || type == TokenType::OUT ||
-        type == TokenType::UNIFORM || type == TokenType::ATTRIBUTE ||
-        type == TokenType::VARYING || type == TokenType::CONST ||
-        type == TokenType::HIGHP || type == TokenType::MEDIUMP ||
-        type == TokenType::LOWP || type == TokenType::INOUT;
+    return lookupKeyword(name) != TokenType::IDENTIFIER || isBuiltin(name);
 }
 
-bool Minifier::isType(TokenType type) const
+std::string Minifier::makeVarName(int index)
 {
-    return type == TokenType::VOID || type == TokenType::FLOAT ||
-        type == TokenType::INT || type == TokenType::BOOL ||
-        type == TokenType::VEC2 || type == TokenType::VEC3 ||
-        type == TokenType::VEC4 || type == TokenType::IVEC2 ||
-        type == TokenType::IVEC3 || type == TokenType::IVEC4 ||
-        type == TokenType::BVEC2 || type == TokenType::BVEC3 ||
-        type == TokenType::BVEC4 || type == TokenType::MAT2 ||
-        type == TokenType::MAT3 || type == TokenType::MAT4 ||
-        type == TokenType::SAMPLER2D || type == TokenType::SAMPLER_CUBE;
+    // a-z A-Z first, then longer names with digits allowed after the first character
+    static constexpr std::string_view LETTERS{"abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ"};
+    static constexpr std::string_view CHARACTERS{"abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789"};
+
+    long long num{index};
+    long long count{static_cast<long long>(LETTERS.length())};
+    std::size_t length{1};
+    while (num >= count)
+    {
+        num -= count;
+        count *= static_cast<long long>(CHARACTERS.length());
+        ++length;
+    }
+
+    std::string result(length, ' ');
+    for (std::size_t i{length - 1}; i > 0; --i)
+    {
+        result[i] = CHARACTERS[static_cast<std::size_t>(num % static_cast<long long>(CHARACTERS.length()))];
+        num /= static_cast<long long>(CHARACTERS.length());
+    }
+    result[0] = LETTERS[static_cast<std::size_t>(num)];
+    return result;
 }
 
-std::string Minifier::getNextVarName()
+void Minifier::rewrite()
 {
-    int num = m_VarCounter++;
-    std::string result;
-    num++;
+    Parser parser{m_Tokens, m_Ast};
+    uint32_t root{parser.parse()};
+    m_Keep.assign(m_Tokens.size(), true);
 
-    while (num > 0)
+    // folded first, a call in a pruned branch does not keep its function
+    if (m_FoldConstants)
     {
-        num--;
-        result = char('a' + (num % 26)) + result;
-        num /= 26;
+        m_Folder.run(m_Tokens, m_Ast, root, m_Keep);
+        m_Stats.setFoldedNodes(m_Folder.getRemovedNodes());
+        m_Stats.setFoldedBytes(m_Folder.getRemovedBytes());
+        if (m_Verbose)
+        {
+            std::cout << "Constant folding: removed " << m_Folder.getRemovedNodes() << " nodes, "
+                << m_Folder.getRemovedBytes() << " bytes of tokens\n";
+        }
     }
 
-    return result;
+    if (m_RemoveDeadCode)
+    {
+        if (m_DeadCode.run(m_Tokens, m_Ast, root, m_Keep, m_ReservedNames))
+        {
+            m_Stats.setDeadCodeRemoved(m_DeadCode.getRemovedFunctions() + m_DeadCode.getRemovedDeclarations());
+            m_Stats.setDeadCodeBytes(m_DeadCode.getRemovedBytes());
+            if (m_Verbose)
+            {
+                std::cout << "Dead code: removed " << m_DeadCode.getRemovedFunctions() << " functions and "
+                    << m_DeadCode.getRemovedDeclarations() << " declarations, " << m_DeadCode.getRemovedBytes()
+                    << " bytes of source\n";
+            }
+        }
+        else if (m_Verbose)
+            std::cout << "Dead code: not removed, the shader has no main or does not parse\n";
+    }
+
+    // the replacements move with their tokens, those of dropped ranges go
+    m_Replacements.clear();
+    if (m_FoldConstants)
+    {
+        uint32_t kept{0};
+        std::size_t next{0};
+        const std::vector<ConstantFolder::Replacement>& replacements{m_Folder.getReplacements()};
+        for (uint32_t i{0}; i < m_Keep.size() && next < replacements.size(); ++i)
+        {
+            if (replacements[next].token == i)
+            {
+                if (m_Keep[i])
+                {
+                    m_Replacements.push_back(replacements[next]);
+                    m_Replacements.back().token = kept;
+                }
+                ++next;
+            }
+            kept += m_Keep[i] != 0;
+        }
+    }
+    m_Tokens.compact(m_Keep);
 }
 
-void Minifier::collectIdentifiers()
+void Minifier::analyze()
 {
-    bool afterQualifierOrType{false};
+    // protected names, symbol table, scopes and rename candidates in one walk
+    // the uniform tracking of the protected names is separate state, it only resets at ';'
+    // a symbol is an identifier id for a global name, or identifierCount + index into m_Locals for a local
+    std::size_t identifierCount{m_Tokens.identifierCount()};
+    m_Protected.assign(identifierCount, false);
+    m_SymbolTable.resize(identifierCount);
+    m_Symbols.assign(m_Tokens.size(), IdentifierTable::NO_ID);
+    m_Locals.clear();
+    m_Functions.clear();
+    m_GlobalOrder.clear(); // globally declared ids in first declaration order
+
+    uint32_t mainId{m_Tokens.findId("main")};
+    if (mainId != IdentifierTable::NO_ID)
+        m_Protected[mainId] = true;
+
     bool afterUniform{false};
+    bool afterQualifierOrType{false};
+    TokenType lastQualifier{TokenType::ERROR};
+    // the scratch below comes from the arena, it is gone with the next reset()
+    std::pmr::vector<char> declared(identifierCount, false, &m_Arena);
+    std::pmr::vector<uint32_t> uses(identifierCount, 0, &m_Arena); // of the global names
+
+    // a function's parameters and its body share one scope, the other braces in a body open one each
+    // braces at the top level that are not a function body belong to a struct or an interface block
+    // a for opens one at its '(' for the loop variables, closed with the end of the loop body
+    enum class Context
+    {
+        GLOBAL, PARAMETERS, AFTER_PARAMETERS, BODY, AGGREGATE
+    };
+    struct Loop
+    {
+        int depth; // brace and paren depth around the for, the body ends back at both
+        int parenDepth;
+        int ifs; // unbraced ifs in the body still waiting for an else
+    };
+    Context context{Context::GLOBAL};
+    int depth{0};
+    int parenDepth{0};
+    int structDepth{0}; // inside the braces of a struct declared in a body while depth is at least this, 0 if not
+    bool functionNext{false}; // a function name was just declared, its '(' opens the scope
+    std::pmr::vector<Loop> loops{&m_Arena};
+    std::pmr::vector<uint32_t> active(identifierCount, IdentifierTable::NO_ID, &m_Arena); // innermost local per name
+    std::pmr::vector<uint32_t> scopeLocals{&m_Arena}; // locals of the open scopes
+    std::pmr::vector<std::size_t> scopeStarts{&m_Arena};
+    // a local is only visible after its initializer, float x = x * 2.0; reads the x around it
+    // it takes over its name at the ',' ';' or ')' ending its declarator, or at a brace
+    uint32_t pendingLocal{IdentifierTable::NO_ID};
+    int pendingDepth{0};
+    int pendingParenDepth{0};
+
+    auto openScope{[&]() { scopeStarts.push_back(scopeLocals.size()); }};
+    auto closeScope{
+        [&](uint32_t end)
+        {
+            if (scopeStarts.empty())
+                return;
+            for (std::size_t k{scopeLocals.size()}; k > scopeStarts.back(); --k)
+            {
+                Local& local{m_Locals[scopeLocals[k - 1]]};
+                local.end = end;
+                active[local.name] = local.shadowed;
+            }
+            scopeLocals.resize(scopeStarts.back());
+            scopeStarts.pop_back();
+        }
+    };
+    // at the ';' or '}' ending a statement, the loops whose body it was end too
+    // an else that follows still belongs to the loop body if an unbraced if in the body is waiting for it
+    auto closeLoops{
+        [&](std::size_t i)
+        {
+            bool elseNext{i + 1 < m_Tokens.size() && m_Tokens.type(i + 1) == TokenType::ELSE};
+            while (!loops.empty() && loops.back().depth == depth && loops.back().parenDepth == parenDepth)
+            {
+                if (elseNext && loops.back().ifs > 0)
+                {
+                    --loops.back().ifs;
+                    break;
+                }
+                closeScope(static_cast<uint32_t>(i));
+                loops.pop_back();
+            }
+        }
+    };
+    auto closeFunction{
+        [&](uint32_t end)
+        {
+            loops.clear();
+            structDepth = 0;
+            while (!scopeStarts.empty())
+                closeScope(end);
+            m_Functions.back().end = end;
+            m_Functions.back().lastLocal = static_cast<uint32_t>(m_Locals.size());
+            context = Context::GLOBAL;
+        }
+    };
 
     for (std::size_t i{0}; i < m_Tokens.size(); ++i)
     {
-        const Token& token{m_Tokens[i]};
-        if (isTypeQualifier(token.type))
+        TokenType type{m_Tokens.type(i)};
+        uint32_t at{static_cast<uint32_t>(i)};
+
+        if (pendingLocal != IdentifierTable::NO_ID &&
+            (((type == TokenType::COMMA || type == TokenType::SEMICOLON) && depth == pendingDepth &&
+                parenDepth == pendingParenDepth) ||
+            (type == TokenType::RIGHT_PAREN && parenDepth == pendingParenDepth) ||
+            type == TokenType::LEFT_BRACE || type == TokenType::RIGHT_BRACE))
+        {
+            Local& local{m_Locals[pendingLocal]};
+            local.shadowed = active[local.name];
+            active[local.name] = static_cast<uint32_t>(identifierCount) + pendingLocal;
+            pendingLocal = IdentifierTable::NO_ID;
+        }
+
+        switch (type)
+        {
+        case TokenType::LEFT_PAREN:
+            if (functionNext && depth == 0 && parenDepth == 0)
+            {
+                openScope();
+                context = Context::PARAMETERS;
+                m_Functions.push_back({at - 1, at, static_cast<uint32_t>(m_Locals.size()), 0});
+            }
+            else if (context == Context::BODY && m_Tokens.type(i - 1) == TokenType::FOR)
+            {
+                openScope();
+                loops.push_back({depth, parenDepth, 0});
+            }
+            ++parenDepth;
+            break;
+        case TokenType::RIGHT_PAREN:
+            parenDepth = std::max(parenDepth - 1, 0);
+            if (context == Context::PARAMETERS && parenDepth == 0)
+                context = Context::AFTER_PARAMETERS;
+            break;
+        case TokenType::LEFT_BRACE:
+            if (context == Context::PARAMETERS || context == Context::AFTER_PARAMETERS)
+                context = Context::BODY;
+            else if (context == Context::BODY)
+            {
+                openScope();
+                // struct S { or struct {, its members are no locals
+                if (m_Tokens.type(i - 1) == TokenType::STRUCT ||
+                    (m_Tokens.type(i - 1) == TokenType::IDENTIFIER && m_Tokens.type(i - 2) == TokenType::STRUCT))
+                    structDepth = depth + 1;
+            }
+            else if (depth == 0)
+                context = Context::AGGREGATE;
+            ++depth;
+            break;
+        case TokenType::RIGHT_BRACE:
+            if (depth == 0)
+                break;
+            --depth;
+            if (depth < structDepth)
+                structDepth = 0;
+            if (context == Context::BODY && depth == 0)
+                closeFunction(at);
+            else if (context == Context::BODY)
+            {
+                closeScope(at);
+                closeLoops(i);
+            }
+            else if (depth == 0)
+                context = Context::GLOBAL;
+            break;
+        default:
+            // a prototype
+            if (context == Context::AFTER_PARAMETERS && type != TokenType::PREPROCESSOR)
+                closeFunction(at);
+            else if (context == Context::BODY && type == TokenType::SEMICOLON)
+                closeLoops(i);
+            else if (type == TokenType::IF && !loops.empty() && loops.back().depth == depth &&
+                loops.back().parenDepth == parenDepth)
+                ++loops.back().ifs;
+            break;
+        }
+        functionNext = false;
+
+        if (type == TokenType::UNIFORM)
+            afterUniform = true;
+        else if (afterUniform && type == TokenType::IDENTIFIER)
+        {
+            m_Protected[m_Tokens.id(i)] = true;
+            if (m_Verbose)
+                std::cout << "Protecting uniform: " << m_Tokens.lexeme(i) << '\n';
+            afterUniform = false;
+        }
+        else if (type == TokenType::SEMICOLON)
+            afterUniform = false;
+
+        // # lines go out as they are, so every word in them keeps its meaning
+        if (type == TokenType::PREPROCESSOR)
+        {
+            forEachWord(m_Tokens.lexeme(i), [&](std::string_view word) { m_PreprocessorWords.insert(word); });
+            m_LiteralRules.readDirective(m_Tokens.lexeme(i));
+        }
+
+        if (isTypeQualifier(type))
         {
             afterQualifierOrType = true;
-            afterUniform = (token.type == TokenType::UNIFORM);
+            lastQualifier = type;
             continue;
         }
 
-        if (isType(token.type))
+        if (isType(type))
         {
             afterQualifierOrType = true;
             continue;
         }
 
-        // identifier after a type/qualifier
-        if (token.type == TokenType::IDENTIFIER && afterQualifierOrType)
+        if (type == TokenType::IDENTIFIER)
         {
-            const std::string& name{token.lexeme};
-            // do not rename builtins or uniforms or main
+            uint32_t id{m_Tokens.id(i)};
+            bool member{i > 0 && m_Tokens.type(i - 1) == TokenType::DOT};
+            bool declaration{false}; // the name itself, not the vec3(a) kind of name after a type
+            uint32_t symbol{active[id] != IdentifierTable::NO_ID ? active[id] : id};
+
+            // declaration
+            if (afterQualifierOrType)
+            {
+                SymbolKind kind{SymbolKind::VARIABLE};
+                if (lastQualifier == TokenType::UNIFORM)
+                {
+                    kind = SymbolKind::UNIFORM;
+                    m_Stats.setUniformsFound(m_Stats.getUniformsFound() + 1);
+                }
 
-            bool mustPreserve{
-                isBuiltin(name) ||
-                m_ProtectedNames.find(name) != m_ProtectedNames.end()
-            };
+                // check if it is function
+                if (i + 1 < m_Tokens.size() && m_Tokens.type(i + 1) == TokenType::LEFT_PAREN)
+                {
+                    kind = SymbolKind::FUNCTION;
+                    m_Stats.setFunctionsFound(m_Stats.getFunctionsFound() + 1);
+                    functionNext = depth == 0;
+                }
+                TokenType before{m_Tokens.type(i - 1)};
+                declaration = isType(before) || before == TokenType::IDENTIFIER || before == TokenType::RIGHT_BRACKET;
+                // members are only reached through '.', which is no use of the name
+                bool aggregate{context == Context::AGGREGATE || (structDepth != 0 && depth >= structDepth)};
+                if (declaration && !aggregate)
+                    m_SymbolTable.declareSymbol(id, m_Tokens.lexeme(i), kind, m_Tokens.line(i));
 
-            if (!mustPreserve)
+                bool inFunction{context == Context::PARAMETERS || context == Context::BODY};
+                if (aggregate)
+                {
+                    // members are reached through '.' or, in a block without an instance name, directly
+                    m_Protected[id] = true;
+                }
+                else if (inFunction && isType(m_Tokens.type(i - 1)))
+                {
+                    // shadows the name from the end of its declarator until its scope closes
+                    uint32_t local{static_cast<uint32_t>(m_Locals.size())};
+                    m_Locals.push_back({id, at, at, 0, active[id]});
+                    scopeLocals.push_back(local);
+                    pendingLocal = local;
+                    pendingDepth = depth;
+                    pendingParenDepth = parenDepth;
+                    symbol = static_cast<uint32_t>(identifierCount) + local;
+                }
+                // uniforms further down are not known yet, protected names are dropped in assignRenamings
+                // anything else after a type in a function, like the arguments of vec3(...), is a use
+                else if (!inFunction && m_Rename && !declared[id])
+                {
+                    declared[id] = true;
+                    if (!isBuiltin(m_Tokens.name(id)))
+                        m_GlobalOrder.push_back(id);
+                }
+
+                afterQualifierOrType = false;
+                lastQualifier = TokenType::ERROR;
+            }
+
+            // dont rename swizzle components, a declaration counts as a use too
+            if (!member)
             {
-                if (m_Renamings.find(name) == m_Renamings.end())
-                    m_Renamings[name] = getNextVarName();
+                m_Symbols[i] = symbol;
+                if (symbol < identifierCount)
+                    ++uses[id];
+                else
+                    ++m_Locals[symbol - identifierCount].uses;
             }
-            afterQualifierOrType = false;
-            afterUniform = false;
+
+            // usage found
+            if (!member && !declaration)
+                m_SymbolTable.useSymbol(id, m_Tokens.line(i));
         }
-        if (token.type == TokenType::SEMICOLON ||
-            token.type == TokenType::LEFT_BRACE ||
-            token.type == TokenType::RIGHT_BRACE)
+
+        if (type == TokenType::SEMICOLON ||
+            type == TokenType::LEFT_BRACE ||
+            type == TokenType::RIGHT_BRACE)
         {
             afterQualifierOrType = false;
-            afterUniform = false;
+            lastQualifier = TokenType::ERROR;
         }
     }
-    m_Stats.setVariablesRenamed(m_Renamings.size());
+
+    if (context == Context::PARAMETERS || context == Context::AFTER_PARAMETERS || context == Context::BODY)
+        closeFunction(static_cast<uint32_t>(m_Tokens.size()));
+
+    assignRenamings(uses);
 }
 
-void Minifier::collectProtectedIdentifiers()
+void Minifier::assignRenamings(const std::pmr::vector<uint32_t>& uses)
 {
-    m_ProtectedNames.insert("main");
+    std::size_t identifierCount{m_Tokens.identifierCount()};
 
-    bool afterUniform{false};
-    for (std::size_t i{0}; i < m_Tokens.size(); ++i)
+    // a declared name that a # line mentions is kept like a uniform, and so is a reserved one
+    for (std::string_view word : m_PreprocessorWords)
+    {
+        uint32_t id{m_Tokens.findId(word)};
+        if (id != IdentifierTable::NO_ID)
+            m_Protected[id] = true;
+    }
+    for (const std::string& name : m_ReservedNames)
     {
-        const Token& token{m_Tokens[i]};
+        uint32_t id{m_Tokens.findId(name)};
+        if (id != IdentifierTable::NO_ID)
+            m_Protected[id] = true;
+    }
 
-        if (token.type == TokenType::UNIFORM)
-        {
-            afterUniform = true;
-            continue;
-        }
+    m_GlobalOrder.erase(std::remove_if(m_GlobalOrder.begin(), m_GlobalOrder.end(),
+                                       [&](uint32_t id) { return m_Protected[id]; }), m_GlobalOrder.end());
 
-        if (afterUniform && isType(token.type))
-            continue;
+    // the most used names get the shortest names, ties keep declaration order
+    std::stable_sort(m_GlobalOrder.begin(), m_GlobalOrder.end(),
+                     [&](uint32_t a, uint32_t b) { return uses[a] > uses[b]; });
 
-        if (afterUniform && token.type == TokenType::IDENTIFIER)
+    m_Renamed.assign(identifierCount + m_Locals.size(), false);
+    for (uint32_t id : m_GlobalOrder)
+        m_Renamed[id] = true;
+    int localsRenamed{0};
+    for (std::size_t k{0}; k < m_Locals.size() && m_Rename; ++k)
+    {
+        uint32_t name{m_Locals[k].name};
+        if (!m_Protected[name] && !isBuiltin(m_Tokens.name(name)))
         {
-            m_ProtectedNames.insert(token.lexeme);
-            std::cout << "Protecting uniform: " << token.lexeme << '\n';
-            afterUniform = false;
+            m_Renamed[identifierCount + k] = true;
+            ++localsRenamed;
         }
-
-        if (token.type == TokenType::SEMICOLON)
-            afterUniform = false;
     }
-}
-
-void Minifier::collectOriginalIdentifiers()
-{
-    for (const Token& token : m_Tokens)
-        if (token.type == TokenType::IDENTIFIER)
-            m_OriginalIdentifiers.insert(token.lexeme);
-}
+    m_Stats.setVariablesRenamed(static_cast<int>(m_GlobalOrder.size()) + localsRenamed);
 
-bool Minifier::needsSpaceBetween(const Token& prev, const Token& curr)
-{
-    if ((prev.type == TokenType::IDENTIFIER || isType(prev.type) || isTypeQualifier(prev.type))
-        && (curr.type == TokenType::IDENTIFIER || isType(curr.type) || isTypeQualifier(curr.type)))
-        return true;
+    // same for the locals of each function
+    m_LocalOrder.resize(m_Locals.size());
+    for (const Function& function : m_Functions)
+    {
+        auto begin{m_LocalOrder.begin() + function.firstLocal};
+        auto end{m_LocalOrder.begin() + function.lastLocal};
+        std::iota(begin, end, function.firstLocal);
+        // ties by declaration, spelled out since stable_sort takes a buffer from the heap for every function
+        std::sort(begin, end, [&](uint32_t a, uint32_t b)
+        {
+            return m_Locals[a].uses != m_Locals[b].uses ? m_Locals[a].uses > m_Locals[b].uses : a < b;
+        });
+    }
 
-    if (prev.type == TokenType::RETURN && curr.type != TokenType::SEMICOLON)
-        return true;
+    // a generated name must not be a name that stays somewhere in the output or a word of a # line
+    m_Kept.assign(identifierCount, false);
+    for (uint32_t symbol : m_Symbols)
+    {
+        if (symbol != IdentifierTable::NO_ID && !m_Renamed[symbol])
+            m_Kept[symbol < identifierCount ? symbol : m_Locals[symbol - identifierCount].name] = true;
+    }
+    m_FreeNames.clear();
 
-    return false;
+    nameSymbols();
 }
 
-void Minifier::buildSymbolTable()
+void Minifier::nameSymbols()
 {
-    bool afterQualifierOrType{false};
-    bool afterUniform{false};
-    TokenType lastQualifier{TokenType::ERROR};
+    std::size_t identifierCount{m_Tokens.identifierCount()};
+    m_Renamings.assign(identifierCount + m_Locals.size(), std::string{});
 
-    for (std::size_t i{0}; i < m_Tokens.size(); ++i)
+    auto isFree{
+        [&](uint32_t index)
+        {
+            if (index >= m_FreeNames.size())
+                m_FreeNames.resize(index + 1, -1);
+            if (m_FreeNames[index] < 0)
+            {
+                std::string name{makeVarName(static_cast<int>(index))};
+                uint32_t existing{m_Tokens.findId(name)};
+                m_FreeNames[index] = !isReservedName(name) &&
+                    (existing == IdentifierTable::NO_ID || !m_Kept[existing]) &&
+                    m_PreprocessorWords.find(name) == m_PreprocessorWords.end() &&
+                    m_ReservedNames.find(name) == m_ReservedNames.end();
+            }
+            return m_FreeNames[index] != 0;
+        }
+    };
+
+    // globals share the name space of every function, they take one generated name each
+    m_GlobalIndex.assign(identifierCount, IdentifierTable::NO_ID);
+    uint32_t next{0};
+    for (uint32_t id : m_GlobalOrder)
     {
-        const Token& token{m_Tokens[i]};
+        while (!isFree(next))
+            ++next;
+        m_GlobalIndex[id] = next;
+        m_Renamings[id] = makeVarName(static_cast<int>(next++));
+    }
 
-        if (isTypeQualifier(token.type))
+    // locals reuse names across functions and across blocks of one function whose lifetimes do not overlap,
+    // the globals a function uses are off limits in it, so is a local whose lifetime overlaps in the same function
+    // both are all clear between functions, so they carry over from the last call as they are
+    auto grow{
+        [&](uint32_t index)
         {
-            afterQualifierOrType = true;
-            lastQualifier = token.type;
-            afterUniform = (token.type == TokenType::UNIFORM);
-            continue;
+            if (index >= m_Blocked.size())
+            {
+                m_Blocked.resize(index + 1, false);
+                m_Taken.resize(index + 1);
+            }
         }
+    };
 
-        if (isType(token.type))
+    for (const Function& function : m_Functions)
+    {
+        for (uint32_t i{function.begin}; i < function.end; ++i)
         {
-            afterQualifierOrType = true;
-            continue;
+            uint32_t symbol{m_Symbols[i]};
+            if (symbol < identifierCount && m_GlobalIndex[symbol] != IdentifierTable::NO_ID)
+            {
+                uint32_t index{m_GlobalIndex[symbol]};
+                grow(index);
+                m_Blocked[index] = true;
+                m_Touched.push_back(index);
+            }
         }
 
-        // declaration
-        if (token.type == TokenType::IDENTIFIER && afterQualifierOrType)
+        for (uint32_t n{function.firstLocal}; n < function.lastLocal; ++n)
         {
-            // std::cout << "DECLARING: " << token.lexeme << " at line " << token.line << "\n";
+            uint32_t k{m_LocalOrder[n]};
+            if (!m_Renamed[identifierCount + k])
+                continue;
 
-            SymbolKind kind{SymbolKind::VARIABLE};
-            if (lastQualifier == TokenType::UNIFORM)
+            const Local& local{m_Locals[k]};
+            for (uint32_t index{0};; ++index)
             {
-                kind = SymbolKind::UNIFORM;
-                m_Stats.setUniformsFound(m_Stats.getUniformsFound() + 1);
-            }
+                grow(index);
+                if (m_Blocked[index] || !isFree(index))
+                    continue;
 
-            // check if it is function
-            if (i + 1 < m_Tokens.size() && m_Tokens[i + 1].type == TokenType::LEFT_PAREN)
-            {
-                kind = SymbolKind::FUNCTION;
-                m_Stats.setFunctionsFound(m_Stats.getFunctionsFound() + 1);
+                bool overlaps{false};
+                for (const Local* other : m_Taken[index])
+                    overlaps = overlaps || (other->begin <= local.end && local.begin <= other->end);
+                if (overlaps)
+                    continue;
+
+                m_Taken[index].push_back(&local);
+                m_Touched.push_back(index);
+                m_Renamings[identifierCount + k] = makeVarName(static_cast<int>(index));
+                break;
             }
-            m_SymbolTable.declareSymbol(token.lexeme, kind, token.line);
+        }
 
-            afterQualifierOrType = false;
-            afterUniform = false;
-            lastQualifier = TokenType::ERROR;
+        for (uint32_t index : m_Touched)
+        {
+            m_Blocked[index] = false;
+            m_Taken[index].clear();
         }
+        m_Touched.clear();
+    }
+}
+
+std::string Minifier::search(std::string output, std::size_t deflatedSize)
+{
+    // hill climbing on the estimated deflate size, every candidate changes one choice and is kept if it
+    // compresses better. the choices are the naming order of the globals, the naming order of the locals
+    // of each function and the whitespace that separates two words. the candidates come from the seed
+    // alone, so the output depends only on the seed and the number of candidates tried
+    auto start{std::chrono::steady_clock::now()};
+    std::size_t rawSize{output.size()};
+    std::size_t initialSize{deflatedSize};
+    std::mt19937 random{m_SearchSeed};
+    auto pick{[&](std::size_t count) { return static_cast<std::size_t>(random() % count); }};
 
-        // usage found, identifier not after a type
-        if (token.type == TokenType::IDENTIFIER && !afterQualifierOrType)
+    std::vector<std::size_t> functions; // with two or more locals to order
+    for (std::size_t f{0}; f < m_Functions.size(); ++f)
+    {
+        if (m_Functions[f].lastLocal - m_Functions[f].firstLocal >= 2)
+            functions.push_back(f);
+    }
+    const TokenType WORDS[]{TokenType::IDENTIFIER, TokenType::KEYWORD, TokenType::RETURN, TokenType::FLOAT,
+                            TokenType::INT, TokenType::VEC2, TokenType::VEC3, TokenType::VEC4, TokenType::TYPE,
+                            TokenType::IN, TokenType::OUT, TokenType::INOUT, TokenType::UNIFORM, TokenType::CONST};
+
+    int steps{0};
+    for (; m_SearchSteps == 0 || steps < m_SearchSteps; ++steps)
+    {
+        double elapsed{std::chrono::duration<double, std::milli>{std::chrono::steady_clock::now() - start}.count()};
+        if (m_SearchBudgetMs > 0 && elapsed >= m_SearchBudgetMs)
+            break;
+
+        std::vector<uint32_t> globalOrder{m_GlobalOrder};
+        std::vector<uint32_t> localOrder{m_LocalOrder};
+        std::vector<char> separators{m_Separators};
+
+        // the first candidate names the locals of every function in declaration order, which lines up
+        // functions with similar parameter lists, after that one random change at a time
+        std::size_t move{steps == 0 ? 0 : 1 + pick(4)};
+        if (move == 0)
         {
-            // dont count if swizzle
-            if (i > 0 && m_Tokens[i - 1].type != TokenType::DOT)
-            {
-                // std::cout << "USING: " << token.lexeme << " at line " << token.line << "\n";
-                m_SymbolTable.useSymbol(token.lexeme, token.line);
-            }
+            for (const Function& function : m_Functions)
+                std::iota(m_LocalOrder.begin() + function.firstLocal, m_LocalOrder.begin() + function.lastLocal,
+                          function.firstLocal);
+        }
+        else if (move == 1 && m_GlobalOrder.size() >= 2)
+        {
+            // mostly neighbours, a far swap wastes short names
+            std::size_t a{pick(m_GlobalOrder.size() - 1)};
+            std::size_t b{a + 1 + pick(std::min<std::size_t>(8, m_GlobalOrder.size() - a - 1))};
+            std::swap(m_GlobalOrder[a], m_GlobalOrder[b]);
+        }
+        else if (move == 2 && !functions.empty())
+        {
+            const Function& function{m_Functions[functions[pick(functions.size())]]};
+            std::size_t count{function.lastLocal - function.firstLocal};
+            std::size_t a{function.firstLocal + pick(count)};
+            std::size_t b{function.firstLocal + pick(count)};
+            std::swap(m_LocalOrder[a], m_LocalOrder[b]);
+        }
+        else if (move == 3 && !functions.empty())
+        {
+            // one function back to most used first
+            const Function& function{m_Functions[functions[pick(functions.size())]]};
+            std::stable_sort(m_LocalOrder.begin() + function.firstLocal, m_LocalOrder.begin() + function.lastLocal,
+                             [&](uint32_t a, uint32_t b) { return m_Locals[a].uses > m_Locals[b].uses; });
+        }
+        else
+        {
+            char& separator{m_Separators[static_cast<std::size_t>(WORDS[pick(std::size(WORDS))])]};
+            separator = separator == ' ' ? '\n' : ' ';
         }
 
-        if (token.type == TokenType::SEMICOLON ||
-            token.type == TokenType::LEFT_BRACE ||
-            token.type == TokenType::RIGHT_BRACE)
+        nameSymbols();
+        std::string candidate{generateOutput()};
+        std::size_t candidateSize{estimateDeflateSize(candidate)};
+        if (candidateSize < deflatedSize || (candidateSize == deflatedSize && candidate.size() < output.size()))
         {
-            afterQualifierOrType = false;
-            afterUniform = false;
-            lastQualifier = TokenType::ERROR;
+            output = std::move(candidate);
+            deflatedSize = candidateSize;
+        }
+        else
+        {
+            m_GlobalOrder = std::move(globalOrder);
+            m_LocalOrder = std::move(localOrder);
+            m_Separators = std::move(separators);
         }
     }
+
+    // the renamings of the output that was kept
+    nameSymbols();
+
+    if (m_Verbose)
+    {
+        std::cout << "Search: " << steps << " candidates, seed " << m_SearchSeed << ", " << rawSize << " -> "
+            << output.size() << " bytes, deflated " << initialSize << " -> " << deflatedSize << " bytes\n";
+    }
+    return output;
 }
 
-std::string Minifier::generateOutput()
+bool Minifier::needsSpaceBetween(TokenType prev, TokenType curr)
 {
-    std::string result;
-    Token prevToken{TokenType::END_OF_FILE, "", 0};
+    return SEPARATORS[static_cast<std::size_t>(prev) * TOKEN_TYPE_COUNT + static_cast<std::size_t>(curr)];
+}
+
+void Minifier::generateOutput(Emitter& out)
+{
+    TokenType prevType{TokenType::END_OF_FILE};
+    char literal[MAX_LITERAL_LENGTH];
+    std::size_t replacement{0};
 
-    for (const Token& token : m_Tokens)
+    for (std::size_t i{0}; i < m_Tokens.size(); ++i)
     {
-        if (token.type == TokenType::END_OF_FILE)
+        TokenType type{m_Tokens.type(i)};
+        std::string_view lexeme{m_Tokens.lexeme(i)};
+
+        if (type == TokenType::END_OF_FILE)
             break;
 
-        if (token.type == TokenType::PREPROCESSOR)
+        // a folded constant, the token only holds its place
+        if (replacement < m_Replacements.size() && m_Replacements[replacement].token == i)
         {
-            if (!result.empty())
-                result += '\n';
-
-            result += token.lexeme;
-            result += '\n';
-            prevToken = token;
+            const ConstantFolder::Replacement& r{m_Replacements[replacement++]};
+            if (!out.empty() && out.last() != '\n' && needsSpaceBetween(prevType, r.first))
+                out.emit(m_Separators[static_cast<std::size_t>(prevType)]);
+            out.emit(std::string_view{m_Folder.getText()}.substr(r.offset, r.length));
+            prevType = r.last;
             continue;
         }
 
-        if (!result.empty() && result.back() != '\n' && needsSpaceBetween(prevToken, token))
-            result += ' ';
-
-        if (token.type == TokenType::IDENTIFIER)
+        if (type == TokenType::PREPROCESSOR)
         {
-            // dont rename swizzle components
-            if (prevToken.type == TokenType::DOT)
-                result += token.lexeme;
-            else
-            {
-                auto it{m_Renamings.find(token.lexeme)};
-                if (it != m_Renamings.end())
-                    result += it->second;
-                else
-                    result += token.lexeme;
-            }
+            if (!out.empty())
+                out.emit('\n');
+
+            out.emit(lexeme);
+            out.emit('\n');
+            prevType = type;
+            continue;
         }
+
+        if (!out.empty() && out.last() != '\n' && needsSpaceBetween(prevType, type))
+            out.emit(m_Separators[static_cast<std::size_t>(prevType)]);
+
+        // swizzle components have no symbol
+        if (type == TokenType::IDENTIFIER && m_Symbols[i] != IdentifierTable::NO_ID &&
+            !m_Renamings[m_Symbols[i]].empty())
+            out.emit(m_Renamings[m_Symbols[i]]);
+        else if (type == TokenType::NUMBER && m_Rename)
+            out.emit(shortestLiteral(lexeme, m_LiteralRules, literal));
         else
-            result += token.lexeme;
+            out.emit(lexeme);
 
-        prevToken = token;
+        prevType = type;
     }
+}
 
+std::string Minifier::generateOutput()
+{
+    // minified output is hardly ever longer than the source
+    std::string result;
+    result.reserve(m_Tokens.source().size() + 1);
+    MemorySink sink{result};
+    Emitter emitter{sink, &m_Arena};
+    generateOutput(emitter);
+    emitter.flush();
     return result;
 }
 
@@ -343,33 +805,296 @@ void Minifier::printDeadCode()
     m_SymbolTable.print();
 }
 
+Minifier::Minifier(TokenBuffer tokens)
+    : m_Tokens{std::move(tokens)}
+{
+}
+
+
 Minifier::Minifier(const std::vector<Token>& tokens)
-    : m_Tokens{tokens}
+    : Minifier{TokenBuffer{tokens}}
 {
-    initBuiltins();
+}
+
+TokenBuffer Minifier::reset(TokenBuffer tokens)
+{
+    std::swap(m_Tokens, tokens);
+
+    // cleared, not freed, the arena's containers are dropped before it is reset
+    m_Symbols.clear();
+    m_Locals.clear();
+    m_Functions.clear();
+    m_Protected.clear();
+    m_PreprocessorWords = std::pmr::unordered_set<std::string_view>{&m_Arena};
+    m_Renamings.clear();
+    m_GlobalOrder.clear();
+    m_LocalOrder.clear();
+    m_Renamed.clear();
+    m_Kept.clear();
+    m_FreeNames.clear();
+    std::fill(m_Separators.begin(), m_Separators.end(), ' ');
+    m_SymbolTable.reset();
+    m_Arena.reset();
+
+    m_Replacements.clear();
+    m_Stats = MinificationStats{};
+    m_LiteralRules = LiteralRules{};
+    return tokens;
 }
 
 std::string Minifier::minify()
 {
-    m_Stats.startTiming();
+    std::string result;
+    result.reserve(m_Tokens.source().size() + 1);
+    MemorySink sink{result};
+    minify(sink);
+    return result;
+}
 
-    collectProtectedIdentifiers();
-    collectOriginalIdentifiers();
+void Minifier::minify(OutputSink& sink)
+{
+    m_Stats.startTiming();
 
-    buildSymbolTable();
-    collectIdentifiers();
-    std::string result{generateOutput()};
+    if (m_RemoveDeadCode || m_FoldConstants)
+        rewrite();
+    analyze();
+    std::size_t size{0};
+    if (m_SearchBudgetMs > 0 || m_SearchSteps > 0)
+    {
+        // the search compares whole outputs, only the one it keeps goes to the sink
+        std::string result{generateOutput()};
+        result = search(std::move(result), estimateDeflateSize(result));
+        sink.write(result);
+        size = result.length();
+    }
+    else
+    {
+        Emitter emitter{sink, &m_Arena};
+        generateOutput(emitter);
+        emitter.flush();
+        size = emitter.size();
+    }
 
     m_Stats.stopTiming();
-    m_Stats.setMinifiedSize(result.length());
-    m_Stats.setDeadCodeRemoved(m_SymbolTable.getUnusedCount());
+    m_Stats.setMinifiedSize(size);
+    // with the dead code gone the count is of what went, otherwise of what could go
+    if (!m_RemoveDeadCode)
+        m_Stats.setDeadCodeRemoved(m_SymbolTable.getUnusedCount());
+}
 
-    return result;
+MinificationStats Minifier::minifyStream(StreamScanner& scanner, std::ostream& out, bool rename,
+                                         ErrorReporter* reporter)
+{
+    // flushed to out in blocks, keys own their names since stream lexemes do not outlive the next token
+    MinificationStats stats;
+    stats.startTiming();
+
+    struct Renaming
+    {
+        std::string name;
+        int line; // of the declaration that picked the name
+        bool global;
+        bool stale{false}; // the name went out as it is since, the next declaration picks another one
+        bool warned{false};
+    };
+    std::unordered_map<std::string, Renaming> renamings;
+    std::unordered_map<std::string, std::string> generatedNames; // of the renamings that are not stale, to the original
+    std::unordered_set<std::string> protectedNames{"main"};
+    std::unordered_set<std::string> seenNames; // identifiers and # line words so far, generated names avoid them
+    int varCounter{0};
+    int uniformsFound{0};
+
+    StreamSink sink{out};
+    Emitter emitter{sink};
+
+    bool afterQualifierOrType{false};
+    bool afterUniform{false};
+    TokenType prevType{TokenType::END_OF_FILE};
+    TokenType beforePrevType{TokenType::END_OF_FILE};
+    int depth{0};
+    int aggregateDepth{0}; // inside the braces of a struct or an interface block while depth is at least this
+    bool interfaceBlock{false}; // its members are reached without '.', so they keep their names like uniforms
+    LiteralRules literalRules;
+    char literal[MAX_LITERAL_LENGTH];
+
+    // a name going out as it is that was already handed out can not be undone, there is no look-ahead. the
+    // renaming that has it turns stale, a later declaration of that name picks a new one. its uses until
+    // then keep the old name, they clash only if both are visible there, which is reported
+    auto keptName{
+        [&](std::string_view name, int line)
+        {
+            auto it{generatedNames.find(std::string{name})};
+            if (it == generatedNames.end())
+                return;
+            Renaming& owner{renamings.at(it->second)};
+            owner.stale = true;
+            if (owner.global && reporter)
+                reporter->reportError(ErrorSeverity::WARNING, "'" + std::string{name} + "' is also the name given to "
+                                      "the global '" + it->second + "' on line " + std::to_string(owner.line) +
+                                      ", minify without --stream", line, 0);
+            owner.warned = owner.global;
+            generatedNames.erase(it);
+        }
+    };
+
+    for (StreamToken token{scanner.nextToken()}; token.type != TokenType::END_OF_FILE; token = scanner.nextToken())
+    {
+        TokenType type{token.type};
+        std::string_view lexeme{token.lexeme};
+
+        if (type == TokenType::PREPROCESSOR)
+        {
+            if (rename)
+            {
+                forEachWord(lexeme, [&](std::string_view word)
+                {
+                    seenNames.emplace(word);
+                    keptName(word, token.line);
+                });
+            }
+            literalRules.readDirective(lexeme);
+
+            if (!emitter.empty())
+                emitter.emit('\n');
+            emitter.emit(lexeme);
+            emitter.emit('\n');
+            beforePrevType = prevType;
+            prevType = type;
+            continue;
+        }
+
+        // same declaration tracking as analyze(), renamed from the declaration on
+        bool keep{false}; // a member, it goes out as it is like every '.member'
+        if (rename)
+        {
+            if (type == TokenType::UNIFORM)
+                afterUniform = true;
+
+            if (type == TokenType::IDENTIFIER)
+                seenNames.emplace(lexeme);
+
+            // braces at the top level that are no function body, and struct S { in one
+            if (type == TokenType::LEFT_BRACE)
+            {
+                bool structBraces{prevType == TokenType::STRUCT ||
+                    (prevType == TokenType::IDENTIFIER && beforePrevType == TokenType::STRUCT)};
+                if (aggregateDepth == 0 && (structBraces || (depth == 0 && prevType != TokenType::RIGHT_PAREN)))
+                {
+                    aggregateDepth = depth + 1;
+                    interfaceBlock = !structBraces;
+                }
+                ++depth;
+            }
+            else if (type == TokenType::RIGHT_BRACE)
+            {
+                depth = std::max(depth - 1, 0);
+                if (depth < aggregateDepth)
+                    aggregateDepth = 0;
+            }
+
+            if (isTypeQualifier(type) || isType(type))
+                afterQualifierOrType = true;
+            else if (type == TokenType::IDENTIFIER && afterQualifierOrType)
+            {
+                std::string name{lexeme};
+                bool member{aggregateDepth != 0};
+                // the name itself, not the vec3(a) kind of name after a type, which is a use
+                bool declaration{isType(prevType) || prevType == TokenType::IDENTIFIER ||
+                    prevType == TokenType::RIGHT_BRACKET};
+                if (afterUniform || (member && interfaceBlock))
+                {
+                    // a later shader in the stream can turn an already renamed name into a uniform
+                    auto it{renamings.find(name)};
+                    if (it != renamings.end())
+                    {
+                        generatedNames.erase(it->second.name);
+                        renamings.erase(it);
+                    }
+                    protectedNames.insert(name);
+                    if (afterUniform)
+                        ++uniformsFound;
+                }
+                else if (member)
+                    keep = true;
+                else if (declaration && !isBuiltin(lexeme) && protectedNames.find(name) == protectedNames.end())
+                {
+                    auto it{renamings.find(name)};
+                    if (it == renamings.end() || it->second.stale)
+                    {
+                        std::string shortName{nextFreeName(varCounter, [&](std::string_view candidate)
+                        {
+                            return seenNames.find(std::string{candidate}) == seenNames.end();
+                        })};
+                        generatedNames.emplace(shortName, name);
+                        renamings.insert_or_assign(std::move(name), Renaming{std::move(shortName), token.line,
+                                                                             depth == 0});
+                    }
+                }
+
+                afterQualifierOrType = false;
+                afterUniform = false;
+            }
+
+            if (type == TokenType::SEMICOLON || type == TokenType::LEFT_BRACE || type == TokenType::RIGHT_BRACE)
+            {
+                afterQualifierOrType = false;
+                afterUniform = false;
+            }
+        }
+
+        if (!emitter.empty() && emitter.last() != '\n' && needsSpaceBetween(prevType, type))
+            emitter.emit(' ');
+
+        if (rename && type == TokenType::IDENTIFIER && prevType != TokenType::DOT && !keep)
+        {
+            auto it{renamings.find(std::string{lexeme})};
+            if (it == renamings.end())
+            {
+                emitter.emit(lexeme);
+                keptName(lexeme, token.line);
+            }
+            else
+            {
+                Renaming& renaming{it->second};
+                if (renaming.stale && !renaming.warned && reporter)
+                {
+                    reporter->reportError(ErrorSeverity::WARNING, "'" + it->first + "' still goes out as '" +
+                                          renaming.name + "', which is also kept as it is since, minify without "
+                                          "--stream", token.line, 0);
+                    renaming.warned = true;
+                }
+                emitter.emit(renaming.name);
+            }
+        }
+        else if (rename && type == TokenType::NUMBER)
+            emitter.emit(shortestLiteral(lexeme, literalRules, literal));
+        else
+            emitter.emit(lexeme);
+
+        beforePrevType = prevType;
+        prevType = type;
+    }
+
+    emitter.flush();
+
+    stats.stopTiming();
+    stats.setOriginalSize(scanner.getBytesRead());
+    stats.setMinifiedSize(emitter.size());
+    stats.setVariablesRenamed(static_cast<int>(renamings.size()));
+    stats.setUniformsFound(uniformsFound);
+    return stats;
 }
 
 void Minifier::printRenamings()
 {
     std::cout << "Variable renamings:\n";
-    for (const auto& pair : m_Renamings)
-        std::cout << "\t" << pair.first << " -> " << pair.second << '\n';
+    std::size_t identifierCount{m_Tokens.identifierCount()};
+    for (uint32_t id{0}; id < identifierCount; ++id)
+        if (!m_Renamings[id].empty())
+            std::cout << "\t" << m_Tokens.name(id) << " -> " << m_Renamings[id] << '\n';
+
+    for (std::size_t k{0}; k < m_Locals.size(); ++k)
+        if (!m_Renamings[identifierCount + k].empty())
+            std::cout << "\t" << m_Tokens.name(m_Locals[k].name) << " -> " << m_Renamings[identifierCount + k]
+                << " (local, line " << m_Tokens.line(m_Locals[k].begin) << ")\n";
 }
@@ -0,0 +1,35 @@
+#include "MinifyResult.hpp"
+#include "DeflateEstimator.hpp"
+#include "Minifier.hpp"
+#include "ParallelScanner.hpp"
+
+#include <utility>
+
+MinifyResult::MinifyResult(std::string output, const MinificationStats& stats, ErrorReporter errors)
+    : m_Output{std::move(output)}, m_Stats{stats}, m_Errors{std::move(errors)}
+{
+}
+
+MinifyResult minifyShader(std::string_view source, const MinifyOptions& options)
+{
+    ErrorReporter errors;
+    errors.setMaxErrors(options.maxErrors);
+
+    ParallelScanner scanner{source, options.threads, &errors};
+    TokenBuffer tokens{scanner.scan()};
+    if (errors.hasFatalErrors())
+        return MinifyResult{std::string{}, MinificationStats{}, std::move(errors)};
+
+    Minifier minifier{std::move(tokens)};
+    minifier.setVerbose(false);
+    minifier.setRename(options.rename);
+    minifier.setRemoveDeadCode(options.removeDeadCode);
+    minifier.setFoldConstants(options.foldConstants);
+    minifier.setSearch(options.searchMs, options.searchSteps, options.seed);
+    minifier.setOriginalSize(source.size());
+    std::string output{minifier.minify()};
+    if (options.deflatedSize)
+        minifier.setDeflatedSize(estimateDeflateSize(output));
+
+    return MinifyResult{std::move(output), minifier.getStats(), std::move(errors)};
+}
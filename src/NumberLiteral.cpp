@@ -0,0 +1,249 @@
+#include "NumberLiteral.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace
+{
+// value = digits * 10^exponent, no trailing zeros in digits unless it is "0"
+struct Decimal
+{
+    char digits[24];
+    int count;
+    int exponent;
+};
+
+template <typename T>
+bool shortestDecimal(T value, Decimal& decimal)
+{
+    // to_chars picks the fewest digits that read back as value, as d.ddde+xx
+    char text[48];
+    auto [end, error]{std::to_chars(text, text + sizeof(text), value, std::chars_format::scientific)};
+    if (error != std::errc{})
+        return false;
+
+    const char* p{text};
+    decimal.count = 0;
+    for (; p < end && *p != 'e'; ++p)
+    {
+        if (*p != '.')
+            decimal.digits[decimal.count++] = *p;
+    }
+    if (p == end)
+        return false;
+    ++p;
+    if (p < end && *p == '+')
+        ++p;
+    int exponent{0};
+    std::from_chars(p, end, exponent);
+
+    decimal.exponent = exponent - (decimal.count - 1);
+    while (decimal.count > 1 && decimal.digits[decimal.count - 1] == '0')
+    {
+        --decimal.count;
+        ++decimal.exponent;
+    }
+    return true;
+}
+
+std::size_t decimalLength(int value)
+{
+    char text[16];
+    return static_cast<std::size_t>(std::to_chars(text, text + sizeof(text), value).ptr - text);
+}
+
+// 1. 12.5 .001, every digit written out
+std::size_t fixedLength(const Decimal& decimal)
+{
+    int point{decimal.count + decimal.exponent}; // digits before the '.'
+    if (decimal.exponent >= 0)
+        return static_cast<std::size_t>(point + 1);
+    if (point > 0)
+        return static_cast<std::size_t>(decimal.count + 1);
+    return static_cast<std::size_t>(1 - point + decimal.count);
+}
+
+std::size_t writeFixed(const Decimal& decimal, char* out)
+{
+    int point{decimal.count + decimal.exponent};
+    char* p{out};
+    if (point <= 0)
+    {
+        *p++ = '.';
+        for (int i{point}; i < 0; ++i)
+            *p++ = '0';
+        std::memcpy(p, decimal.digits, static_cast<std::size_t>(decimal.count));
+        return static_cast<std::size_t>(p - out) + static_cast<std::size_t>(decimal.count);
+    }
+    for (int i{0}; i < point; ++i)
+        *p++ = i < decimal.count ? decimal.digits[i] : '0';
+    *p++ = '.';
+    for (int i{point}; i < decimal.count; ++i)
+        *p++ = decimal.digits[i];
+    return static_cast<std::size_t>(p - out);
+}
+
+// 1e5 125e-3, the digits as an integer
+std::size_t writeExponent(const Decimal& decimal, char* out)
+{
+    std::memcpy(out, decimal.digits, static_cast<std::size_t>(decimal.count));
+    char* p{out + decimal.count};
+    *p++ = 'e';
+    p = std::to_chars(p, out + MAX_LITERAL_LENGTH, decimal.exponent).ptr;
+    return static_cast<std::size_t>(p - out);
+}
+
+// 0 if value has no literal or it would not fit with room chars left for a suffix
+template <typename T>
+std::size_t writeShortest(T value, std::size_t room, char* buffer)
+{
+    if (!(value >= 0) || (value != 0 && !std::isnormal(value)))
+        return 0;
+
+    Decimal decimal{};
+    if (!shortestDecimal(value, decimal))
+        return 0;
+
+    std::size_t fixed{fixedLength(decimal)};
+    std::size_t scientific{static_cast<std::size_t>(decimal.count) + 1 + decimalLength(decimal.exponent)};
+    if (std::min(fixed, scientific) + room > MAX_LITERAL_LENGTH)
+        return 0;
+
+    // ties go to the fixed form, "1." over "1e0"
+    std::size_t length{fixed <= scientific ? writeFixed(decimal, buffer) : writeExponent(decimal, buffer)};
+
+    // what goes out has to read back as the same bits
+    T check{};
+    std::from_chars(buffer, buffer + length, check);
+    return check == value ? length : 0;
+}
+
+template <typename T>
+std::string_view shortestFloat(std::string_view lexeme, std::string_view number, std::string_view suffix,
+                               char* buffer)
+{
+    T value{};
+    auto [end, error]{std::from_chars(number.data(), number.data() + number.length(), value)};
+    if (error != std::errc{} || end != number.data() + number.length())
+        return lexeme;
+
+    // a literal that underflows is left to the compiler, it may flush or keep denormals
+    if (value == 0)
+    {
+        for (char c : number)
+        {
+            if (c == 'e' || c == 'E')
+                break;
+            if (c >= '1' && c <= '9')
+                return lexeme;
+        }
+    }
+
+    std::size_t length{writeShortest(value, suffix.length(), buffer)};
+    if (length == 0)
+        return lexeme;
+
+    std::memcpy(buffer + length, suffix.data(), suffix.length());
+    length += suffix.length();
+    return length < lexeme.length() ? std::string_view{buffer, length} : lexeme;
+}
+
+std::string_view shortestInteger(std::string_view lexeme, const LiteralRules& rules, char* buffer)
+{
+    bool isUnsigned{lexeme.back() == 'u' || lexeme.back() == 'U'};
+    if (isUnsigned && !rules.unsignedInts)
+        return lexeme;
+
+    std::string_view digits{lexeme.substr(0, lexeme.length() - isUnsigned)};
+    int base{10};
+    if (digits.length() > 2 && digits[0] == '0' && (digits[1] == 'x' || digits[1] == 'X'))
+    {
+        base = 16;
+        digits.remove_prefix(2);
+    }
+    else if (digits.length() > 1 && digits[0] == '0')
+        base = 8;
+    if (base == 10)
+        return lexeme;
+
+    uint64_t value{0};
+    auto [end, error]{std::from_chars(digits.data(), digits.data() + digits.length(), value, base)};
+    if (error != std::errc{} || end != digits.data() + digits.length() || value > UINT32_MAX)
+        return lexeme;
+    // 0xFFFFFFFF is an int with all bits set, in decimal it would be out of range
+    if (!isUnsigned && value > INT32_MAX)
+        return lexeme;
+
+    char* p{std::to_chars(buffer, buffer + MAX_LITERAL_LENGTH, value).ptr};
+    if (isUnsigned)
+        *p++ = 'u';
+    auto length{static_cast<std::size_t>(p - buffer)};
+    return length < lexeme.length() ? std::string_view{buffer, length} : lexeme;
+}
+}
+
+void LiteralRules::readDirective(std::string_view line)
+{
+    auto skipBlanks{
+        [&]()
+        {
+            while (!line.empty() && (line[0] == ' ' || line[0] == '\t'))
+                line.remove_prefix(1);
+        }
+    };
+
+    if (line.empty() || line[0] != '#')
+        return;
+    line.remove_prefix(1);
+    skipBlanks();
+    if (line.substr(0, 7) != "version")
+        return;
+    line.remove_prefix(7);
+    skipBlanks();
+
+    int version{0};
+    auto [end, error]{std::from_chars(line.data(), line.data() + line.length(), version)};
+    if (error != std::errc{})
+        return;
+    line.remove_prefix(static_cast<std::size_t>(end - line.data()));
+    skipBlanks();
+
+    // 100 is ES without saying so
+    bool es{version == 100 || line.substr(0, 2) == "es"};
+    unsignedInts = es ? version >= 300 : version >= 130;
+    doubles = !es && version >= 400;
+}
+
+std::string_view shortestLiteral(std::string_view lexeme, const LiteralRules& rules, char* buffer)
+{
+    if (lexeme.empty() || lexeme.length() >= MAX_LITERAL_LENGTH)
+        return lexeme;
+
+    bool hex{lexeme.length() > 1 && lexeme[0] == '0' && (lexeme[1] == 'x' || lexeme[1] == 'X')};
+    bool isFloat{!hex && lexeme.find_first_of(".eEfF") != std::string_view::npos};
+    if (!isFloat)
+        return shortestInteger(lexeme, rules, buffer);
+
+    std::size_t length{lexeme.length()};
+    if (length > 2 && (lexeme.substr(length - 2) == "lf" || lexeme.substr(length - 2) == "LF"))
+    {
+        if (!rules.doubles)
+            return lexeme;
+        return shortestFloat<double>(lexeme, lexeme.substr(0, length - 2), lexeme.substr(length - 2), buffer);
+    }
+
+    // the f suffix changes nothing, a literal without one is a float too
+    if (lexeme.back() == 'f' || lexeme.back() == 'F')
+        --length;
+    return shortestFloat<float>(lexeme, lexeme.substr(0, length), {}, buffer);
+}
+
+std::size_t writeFloatLiteral(float value, char* buffer)
+{
+    if (std::signbit(value))
+        return 0;
+    return writeShortest(value, 0, buffer);
+}
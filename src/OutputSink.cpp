@@ -0,0 +1,117 @@
+#include "OutputSink.hpp"
+
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+
+FdSink::FdSink(int fd)
+    : m_Fd{fd}
+{
+}
+
+void FdSink::write(std::string_view data)
+{
+    while (!data.empty() && !m_Failed)
+    {
+        ssize_t written{::write(m_Fd, data.data(), data.size())};
+        if (written < 0)
+        {
+            if (errno != EINTR)
+                m_Failed = true;
+            continue;
+        }
+        data.remove_prefix(static_cast<std::size_t>(written));
+    }
+}
+
+MemorySink::MemorySink(std::string& buffer)
+    : m_Buffer{buffer}
+{
+}
+
+void MemorySink::write(std::string_view data)
+{
+    m_Buffer += data;
+}
+
+CallbackSink::CallbackSink(std::function<void(std::string_view)> callback)
+    : m_Callback{std::move(callback)}
+{
+}
+
+void CallbackSink::write(std::string_view data)
+{
+    m_Callback(data);
+}
+
+StreamSink::StreamSink(std::ostream& stream)
+    : m_Stream{stream}
+{
+}
+
+void StreamSink::write(std::string_view data)
+{
+    m_Stream.write(data.data(), static_cast<std::streamsize>(data.size()));
+}
+
+bool ReplacementFile::open(const std::string& path)
+{
+    discard();
+    m_Path = path;
+
+    // unique across the threads of a batch and across processes writing next to each other
+    static std::atomic<unsigned> counter{0};
+    for (int attempt{0}; attempt < 100 && m_Fd < 0; ++attempt)
+    {
+        m_TempPath = path + ".tmp" + std::to_string(::getpid()) + '.' + std::to_string(counter++);
+        m_Fd = ::open(m_TempPath.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0644);
+        if (m_Fd < 0 && errno != EEXIST)
+            break;
+    }
+    if (m_Fd < 0)
+    {
+        m_TempPath.clear();
+        return false;
+    }
+
+    // a target that already exists keeps its permissions
+    struct stat info{};
+    if (::stat(path.c_str(), &info) == 0)
+        ::fchmod(m_Fd, info.st_mode & 07777);
+    return true;
+}
+
+bool ReplacementFile::commit()
+{
+    if (m_Fd < 0)
+        return false;
+
+    bool closed{::close(m_Fd) == 0};
+    m_Fd = -1;
+    if (!closed || std::rename(m_TempPath.c_str(), m_Path.c_str()) != 0)
+    {
+        discard();
+        return false;
+    }
+    m_TempPath.clear();
+    return true;
+}
+
+void ReplacementFile::discard()
+{
+    if (m_Fd >= 0)
+        ::close(m_Fd);
+    m_Fd = -1;
+    if (!m_TempPath.empty())
+        ::unlink(m_TempPath.c_str());
+    m_TempPath.clear();
+}
+
+ReplacementFile::~ReplacementFile()
+{
+    discard();
+}
@@ -0,0 +1,174 @@
+#include "ParallelScanner.hpp"
+#include "Scanner.hpp"
+#include "TextScan.hpp"
+
+#include <algorithm>
+#include <thread>
+
+namespace
+{
+// whether [p, end) ends inside a block comment when it starts inside one (inBlock) or in code
+// chunks start right after a newline, so line comments and preprocessor lines never carry over
+bool endsInBlockComment(const char* p, const char* end, bool inBlock)
+{
+    int lines{0};
+    if (inBlock)
+    {
+        p = findBlockCommentEnd(p, end, lines);
+        if (p == end)
+            return true;
+        p += 2;
+    }
+
+    while (p < end)
+    {
+        char c{*p};
+        if (c == '#')
+            p = findNewline(p, end);
+        else if (c == '/' && p + 1 < end && p[1] == '/')
+            p = findNewline(p + 2, end);
+        else if (c == '/' && p + 1 < end && p[1] == '*')
+        {
+            p = findBlockCommentEnd(p + 2, end, lines);
+            if (p == end)
+                return true;
+            p += 2;
+        }
+        else
+            ++p;
+    }
+    return false;
+}
+
+// function(0) runs on the calling thread
+template <typename Function>
+void runParallel(std::size_t count, Function function)
+{
+    std::vector<std::thread> threads;
+    threads.reserve(count);
+    for (std::size_t i{1}; i < count; ++i)
+        threads.emplace_back(function, i);
+    function(0);
+    for (auto& thread : threads)
+        thread.join();
+}
+}
+
+std::vector<std::size_t> ParallelScanner::findChunkStarts() const
+{
+    const char* begin{m_Source.data()};
+    const char* end{begin + m_Source.length()};
+    std::size_t length{m_Source.length()};
+    std::size_t count{std::max<std::size_t>(1, std::min<std::size_t>(m_Threads, length / MIN_CHUNK_SIZE))};
+
+    // candidate splits right after the first newline past every 1/count of the source
+    std::vector<std::size_t> splits{0};
+    for (std::size_t i{1}; i < count; ++i)
+    {
+        const char* newline{findNewline(begin + length * i / count, end)};
+        if (newline == end)
+            break;
+        std::size_t split{static_cast<std::size_t>(newline + 1 - begin)};
+        if (split > splits.back() && split < length)
+            splits.push_back(split);
+    }
+
+    // pre-pass, every chunk's end state for both start states in parallel, then chained in order
+    std::size_t splitCount{splits.size()};
+    std::vector<char> fromCode(splitCount);
+    std::vector<char> fromComment(splitCount);
+    runParallel(splitCount, [&](std::size_t i)
+    {
+        const char* chunkEnd{i + 1 < splitCount ? begin + splits[i + 1] : end};
+        fromCode[i] = endsInBlockComment(begin + splits[i], chunkEnd, false);
+        fromComment[i] = endsInBlockComment(begin + splits[i], chunkEnd, true);
+    });
+
+    std::vector<std::size_t> starts{0};
+    bool inBlock{false};
+    for (std::size_t i{1}; i < splitCount; ++i)
+    {
+        inBlock = inBlock ? fromComment[i - 1] : fromCode[i - 1];
+
+        // a split inside a block comment moves past its end, the previous chunk scans the rest of it
+        std::size_t start{splits[i]};
+        if (inBlock)
+        {
+            int lines{0};
+            const char* close{findBlockCommentEnd(begin + start, end, lines)};
+            start = close == end ? length : static_cast<std::size_t>(close + 2 - begin);
+        }
+
+        if (start > starts.back() && start < length)
+            starts.push_back(start);
+    }
+    return starts;
+}
+
+ParallelScanner::ParallelScanner(std::string_view src, unsigned threads, ErrorReporter* reporter)
+    : m_Source{src}, m_ErrorReporter{reporter}, m_Threads{std::max(1u, threads)}
+{
+}
+
+TokenBuffer ParallelScanner::scan()
+{
+    if (m_Threads == 1 || m_Source.length() < 2 * MIN_CHUNK_SIZE || m_Source.length() > UINT32_MAX)
+    {
+        Scanner scanner{m_Source, m_ErrorReporter};
+        return scanner.scan();
+    }
+
+    std::vector<std::size_t> starts{findChunkStarts()};
+    std::size_t count{starts.size()};
+
+    // errors are collected per chunk and reported in source order afterwards
+    std::vector<TokenBuffer> parts(count);
+    std::vector<ErrorReporter> reporters(count);
+    if (m_ErrorReporter)
+        for (auto& reporter : reporters)
+            reporter.setMaxErrors(m_ErrorReporter->getMaxErrors());
+    std::vector<int> newlines(count);
+    runParallel(count, [&](std::size_t i)
+    {
+        std::size_t end{i + 1 < count ? starts[i + 1] : m_Source.length()};
+        Scanner scanner{m_Source, &reporters[i]};
+        parts[i] = scanner.scanChunk(starts[i], end);
+        newlines[i] = scanner.getLine() - 1;
+    });
+
+    // where every chunk lands and its line offset, prefix sums over the chunks before it
+    std::vector<std::size_t> positions(count);
+    std::vector<int> lineOffsets(count);
+    std::size_t total{0};
+    int line{0};
+    for (std::size_t i{0}; i < count; ++i)
+    {
+        positions[i] = total;
+        lineOffsets[i] = line;
+        total += parts[i].size();
+        line += newlines[i];
+    }
+
+    // identifier ids are merged in chunk order, so they come out in order of first appearance like Scanner's
+    TokenBuffer tokens{m_Source};
+    std::vector<std::vector<uint32_t>> idMaps(count);
+    for (std::size_t i{0}; i < count; ++i)
+        idMaps[i] = tokens.mergeIdentifiers(parts[i]);
+
+    tokens.reserve(total + 1);
+    tokens.resize(total);
+    runParallel(count, [&](std::size_t i)
+    {
+        tokens.copyFrom(parts[i], positions[i], lineOffsets[i], idMaps[i]);
+        parts[i] = TokenBuffer{};
+    });
+    tokens.push(TokenType::END_OF_FILE, static_cast<uint32_t>(m_Source.length()), 0, line + 1);
+
+    if (m_ErrorReporter)
+    {
+        m_ErrorReporter->setSource(m_Source);
+        for (std::size_t i{0}; i < count; ++i)
+            m_ErrorReporter->merge(reporters[i], lineOffsets[i]);
+    }
+    return tokens;
+}
@@ -0,0 +1,961 @@
+#include "Parser.hpp"
+#include "Minifier.hpp"
+
+#include <algorithm>
+
+namespace
+{
+    // binary operators from the loosest to the tightest, 0 for anything else
+    int binaryPrecedence(TokenType type)
+    {
+        switch (type)
+        {
+        case TokenType::PIPE_PIPE:
+            return 1;
+        // ^^ is 2, it is two CARET tokens
+        case TokenType::AMPERSAND_AMPERSAND:
+            return 3;
+        case TokenType::PIPE:
+            return 4;
+        case TokenType::CARET:
+            return 5;
+        case TokenType::AMPERSAND:
+            return 6;
+        case TokenType::EQUAL_EQUAL:
+        case TokenType::BANG_EQUAL:
+            return 7;
+        case TokenType::LESS:
+        case TokenType::LESS_EQUAL:
+        case TokenType::GREATER:
+        case TokenType::GREATER_EQUAL:
+            return 8;
+        case TokenType::LESS_LESS:
+        case TokenType::GREATER_GREATER:
+            return 9;
+        case TokenType::PLUS:
+        case TokenType::MINUS:
+            return 10;
+        case TokenType::STAR:
+        case TokenType::SLASH:
+        case TokenType::PERCENT:
+            return 11;
+        default:
+            return 0;
+        }
+    }
+
+    constexpr int XOR_PRECEDENCE{2};
+
+    bool isAssignment(TokenType type)
+    {
+        return hasTrait(type, TRAIT_ASSIGNMENT);
+    }
+
+    // the lexer has no token for %= &= |= ^= <<= >>=, they come as the operator and an EQUAL
+    bool isSplitAssignment(TokenType type)
+    {
+        return type == TokenType::PERCENT || type == TokenType::AMPERSAND || type == TokenType::PIPE ||
+            type == TokenType::CARET || type == TokenType::LESS_LESS || type == TokenType::GREATER_GREATER;
+    }
+
+    struct DepthGuard
+    {
+        int& depth;
+
+        explicit DepthGuard(int& d) : depth{++d}
+        {
+        }
+
+        ~DepthGuard() { --depth; }
+    };
+}
+
+Parser::Parser(const TokenBuffer& tokens, Ast& ast, ErrorReporter* reporter)
+    : m_Tokens{tokens}, m_Ast{ast}, m_ErrorReporter{reporter}
+{
+    m_End = static_cast<uint32_t>(tokens.size());
+    if (m_End > 0 && tokens.type(m_End - 1) == TokenType::END_OF_FILE)
+        --m_End;
+}
+
+TokenType Parser::typeAt(uint32_t at) const
+{
+    while (at < m_End && m_Tokens.type(at) == TokenType::PREPROCESSOR)
+        ++at;
+    return at < m_End ? m_Tokens.type(at) : TokenType::END_OF_FILE;
+}
+
+uint32_t Parser::after(uint32_t at) const
+{
+    ++at;
+    while (at < m_End && m_Tokens.type(at) == TokenType::PREPROCESSOR)
+        ++at;
+    return at;
+}
+
+bool Parser::checkWord(std::string_view word) const
+{
+    return check(TokenType::KEYWORD) && m_Tokens.lexeme(m_Current) == word;
+}
+
+void Parser::skipDirectives()
+{
+    while (m_Current < m_End && m_Tokens.type(m_Current) == TokenType::PREPROCESSOR)
+        ++m_Current;
+}
+
+uint32_t Parser::advance()
+{
+    uint32_t taken{m_Current};
+    if (!atEnd())
+    {
+        m_Taken = ++m_Current;
+        skipDirectives();
+    }
+    return taken;
+}
+
+bool Parser::match(TokenType t)
+{
+    if (!check(t))
+        return false;
+    advance();
+    return true;
+}
+
+bool Parser::expect(TokenType t, const char* what)
+{
+    if (match(t))
+        return true;
+    error(std::string{"Expected "} + what);
+    return false;
+}
+
+void Parser::error(const std::string& message)
+{
+    // one error per statement, the rest would only be fallout
+    if (!m_Panic && m_ErrorReporter)
+    {
+        if (atEnd())
+            m_ErrorReporter->reportErrorAt(ErrorSeverity::ERROR, message + " at the end of the input",
+                                           m_End > 0 ? m_Tokens.line(m_End - 1) : 1, m_Tokens.source().size());
+        else
+            m_ErrorReporter->reportErrorAt(ErrorSeverity::ERROR,
+                                           message + ", got '" + std::string{m_Tokens.lexeme(m_Current)} + "'",
+                                           m_Tokens.line(m_Current), m_Tokens.offset(m_Current));
+    }
+    m_Panic = true;
+}
+
+uint16_t Parser::qualifierFlag() const
+{
+    switch (type())
+    {
+    case TokenType::CONST:
+        return FLAG_CONST;
+    case TokenType::UNIFORM:
+        return FLAG_UNIFORM;
+    case TokenType::IN:
+        return FLAG_IN;
+    case TokenType::OUT:
+        return FLAG_OUT;
+    case TokenType::INOUT:
+        return FLAG_IN | FLAG_OUT;
+    case TokenType::ATTRIBUTE:
+        return FLAG_ATTRIBUTE;
+    case TokenType::VARYING:
+        return FLAG_VARYING;
+    case TokenType::HIGHP:
+    case TokenType::MEDIUMP:
+    case TokenType::LOWP:
+        return FLAG_PRECISION;
+    case TokenType::KEYWORD:
+        break;
+    default:
+        return 0;
+    }
+
+    std::string_view word{m_Tokens.lexeme(m_Current)};
+    if (word == "layout")
+        return FLAG_LAYOUT;
+    if (word == "buffer")
+        return FLAG_BUFFER;
+    if (word == "shared")
+        return FLAG_SHARED;
+    for (std::string_view other : {"invariant", "precise", "flat", "smooth", "noperspective", "centroid", "sample",
+                                   "patch", "coherent", "volatile", "restrict", "readonly", "writeonly", "subroutine"})
+    {
+        if (word == other)
+            return FLAG_OTHER_QUALIFIER;
+    }
+    return 0;
+}
+
+bool Parser::isTypeStart() const
+{
+    TokenType t{type()};
+    return Minifier::isType(t) || t == TokenType::STRUCT ||
+        (t == TokenType::IDENTIFIER && m_StructNames[m_Tokens.id(m_Current)]);
+}
+
+bool Parser::startsDeclaration() const
+{
+    if (qualifierFlag() != 0 || check(TokenType::STRUCT) || checkWord("precision"))
+        return true;
+    if (!Minifier::isType(type()) && !check(TokenType::IDENTIFIER))
+        return false;
+
+    // a type, or a name that could be one, followed by a name, float[2] a; included
+    return typeAt(skipBrackets(after(m_Current))) == TokenType::IDENTIFIER;
+}
+
+uint32_t Parser::skipBrackets(uint32_t at) const
+{
+    while (typeAt(at) == TokenType::LEFT_BRACKET)
+    {
+        int depth{0};
+        do
+        {
+            TokenType t{typeAt(at)};
+            if (t == TokenType::LEFT_BRACKET)
+                ++depth;
+            else if (t == TokenType::RIGHT_BRACKET)
+                --depth;
+            else if (t == TokenType::END_OF_FILE)
+                return at;
+            at = after(at);
+        }
+        while (depth > 0);
+    }
+    return at;
+}
+
+void Parser::addDirectives(uint32_t parent)
+{
+    // the # lines advance() skipped since the last token taken
+    for (uint32_t k{std::max(m_Taken, m_LastDirective)}; k < m_Current; ++k)
+    {
+        uint32_t node{m_Ast.add(NodeKind::PREPROCESSOR, k, k)};
+        m_Ast.setEnd(node, k + 1);
+        m_Ast.addChild(parent, node);
+    }
+    m_LastDirective = std::max(m_LastDirective, m_Current);
+}
+
+void Parser::finish(uint32_t node)
+{
+    m_Ast.setEnd(node, std::max(m_Ast.begin(node), m_Taken));
+}
+
+uint32_t Parser::recover(uint32_t node)
+{
+    // on to a ';' or past a { } block at the same nesting, or up to the '}' that closes the one around
+    int depth{0};
+    while (!atEnd())
+    {
+        TokenType t{type()};
+        if (t == TokenType::RIGHT_BRACE && depth == 0)
+            break;
+        advance();
+        if (t == TokenType::LEFT_BRACE)
+            ++depth;
+        else if (t == TokenType::RIGHT_BRACE && --depth == 0)
+            break;
+        else if (t == TokenType::SEMICOLON && depth == 0)
+            break;
+    }
+
+    m_Ast.setKind(node, NodeKind::ERROR);
+    m_Ast.setToken(node, Ast::NO_TOKEN);
+    m_Ast.setType(node, Ast::NO_TOKEN);
+    m_Ast.setFlags(node, 0);
+    m_Ast.dropChildren(node);
+    finish(node);
+    m_Panic = false;
+    return node;
+}
+
+uint32_t Parser::parse()
+{
+    m_Ast.clear();
+    // real shaders have 0.4 to 0.6 nodes per token, growing all the arrays once more costs more than the slack
+    m_Ast.reserve(m_Tokens.size() * 2 / 3 + 16);
+    m_StructNames.assign(m_Tokens.identifierCount(), false);
+    m_Current = 0;
+    m_Taken = 0;
+    m_LastDirective = 0;
+    m_Panic = false;
+    m_Depth = 0;
+    skipDirectives();
+
+    uint32_t root{m_Ast.add(NodeKind::TRANSLATION_UNIT, Ast::NO_TOKEN, 0)};
+    while (!atEnd())
+    {
+        addDirectives(root);
+        uint32_t before{m_Current};
+        uint32_t item{parseExternal()};
+        if (m_Panic)
+            item = recover(item);
+        if (m_Current == before)
+        {
+            // a stray '}'
+            advance();
+            m_Ast.setKind(item, NodeKind::ERROR);
+            finish(item);
+        }
+        m_Ast.addChild(root, item);
+    }
+    addDirectives(root);
+    m_Ast.setEnd(root, m_End);
+    return root;
+}
+
+uint32_t Parser::parseExternal()
+{
+    if (check(TokenType::SEMICOLON))
+    {
+        uint32_t node{m_Ast.add(NodeKind::EMPTY, Ast::NO_TOKEN, advance())};
+        finish(node);
+        return node;
+    }
+    return parseDeclaration(true);
+}
+
+uint16_t Parser::parseQualifiers()
+{
+    uint16_t flags{0};
+    for (uint16_t flag{qualifierFlag()}; flag != 0; flag = qualifierFlag())
+    {
+        flags |= flag;
+        advance();
+
+        // layout(..) is kept as tokens
+        if (flag == FLAG_LAYOUT && check(TokenType::LEFT_PAREN))
+        {
+            int depth{0};
+            do
+            {
+                if (check(TokenType::LEFT_PAREN))
+                    ++depth;
+                else if (check(TokenType::RIGHT_PAREN))
+                    --depth;
+                advance();
+            }
+            while (depth > 0 && !atEnd());
+        }
+    }
+    return flags;
+}
+
+uint32_t Parser::parseTypeSpecifier(uint32_t declaration)
+{
+    if (check(TokenType::STRUCT))
+    {
+        uint32_t keyword{advance()};
+        uint32_t name{Ast::NO_TOKEN};
+        if (check(TokenType::IDENTIFIER))
+        {
+            name = advance();
+            m_StructNames[m_Tokens.id(name)] = true;
+        }
+        m_Ast.addChild(declaration, parseStruct(keyword, name));
+        // an anonymous struct has the keyword as its type
+        return name != Ast::NO_TOKEN ? name : keyword;
+    }
+
+    if (Minifier::isType(type()) || check(TokenType::IDENTIFIER))
+        return advance();
+
+    error("Expected a type");
+    return Ast::NO_TOKEN;
+}
+
+uint32_t Parser::parseStruct(uint32_t begin, uint32_t name)
+{
+    uint32_t node{m_Ast.add(NodeKind::STRUCT, name, begin)};
+    if (!expect(TokenType::LEFT_BRACE, "'{'"))
+        return node;
+
+    while (!check(TokenType::RIGHT_BRACE) && !atEnd())
+    {
+        addDirectives(node);
+        uint32_t before{m_Current};
+        uint32_t member{parseDeclaration(false)};
+        if (m_Panic)
+            member = recover(member);
+        if (m_Current == before)
+            break;
+        m_Ast.addChild(node, member);
+    }
+    addDirectives(node);
+    expect(TokenType::RIGHT_BRACE, "'}' after the members");
+    finish(node);
+    return node;
+}
+
+uint32_t Parser::parsePrecision()
+{
+    uint32_t node{m_Ast.add(NodeKind::PRECISION, m_Current, m_Current)};
+    advance();
+    while (!check(TokenType::SEMICOLON) && !check(TokenType::RIGHT_BRACE) && !atEnd())
+        m_Ast.setType(node, advance());
+    expect(TokenType::SEMICOLON, "';' after the precision statement");
+    finish(node);
+    return node;
+}
+
+uint32_t Parser::parseDeclaration(bool topLevel)
+{
+    if (checkWord("precision"))
+        return parsePrecision();
+
+    uint32_t begin{m_Current};
+    uint32_t node{m_Ast.add(NodeKind::DECLARATION, Ast::NO_TOKEN, begin)};
+    uint16_t flags{parseQualifiers()};
+    m_Ast.setFlags(node, flags);
+
+    bool blockName{flags != 0 && check(TokenType::IDENTIFIER) && typeAt(after(m_Current)) == TokenType::LEFT_BRACE};
+    if (blockName)
+    {
+        // an interface block, uniform Name { .. } instance;
+        uint32_t name{advance()};
+        m_Ast.setType(node, name);
+        m_Ast.addChild(node, parseStruct(name, name));
+        if (!m_Panic && !check(TokenType::SEMICOLON))
+            parseDeclarators(node);
+    }
+    else if (flags != 0 && (check(TokenType::SEMICOLON) || (check(TokenType::IDENTIFIER) && !isTypeStart() &&
+        (typeAt(after(m_Current)) == TokenType::SEMICOLON || typeAt(after(m_Current)) == TokenType::COMMA))))
+    {
+        // no type, layout(..) in; or invariant gl_Position;
+        if (check(TokenType::IDENTIFIER))
+            parseDeclarators(node);
+    }
+    else
+    {
+        uint32_t typeToken{parseTypeSpecifier(node)};
+        if (m_Panic)
+            return node;
+        m_Ast.setType(node, typeToken);
+        parseArraySizes(node);
+
+        if (topLevel && check(TokenType::IDENTIFIER) && typeAt(after(m_Current)) == TokenType::LEFT_PAREN)
+        {
+            parseFunction(node);
+            return node;
+        }
+        if (!m_Panic && !check(TokenType::SEMICOLON))
+            parseDeclarators(node);
+    }
+
+    if (!m_Panic)
+        expect(TokenType::SEMICOLON, "';' after a declaration");
+    finish(node);
+    return node;
+}
+
+void Parser::parseFunction(uint32_t function)
+{
+    m_Ast.setKind(function, NodeKind::FUNCTION);
+    m_Ast.setToken(function, advance());
+    advance();
+
+    if (check(TokenType::VOID) && typeAt(after(m_Current)) == TokenType::RIGHT_PAREN)
+        advance();
+    else if (!check(TokenType::RIGHT_PAREN))
+    {
+        do
+            m_Ast.addChild(function, parseParameter());
+        while (!m_Panic && match(TokenType::COMMA));
+    }
+
+    if (!m_Panic && expect(TokenType::RIGHT_PAREN, "')' after the parameters"))
+    {
+        if (check(TokenType::LEFT_BRACE))
+            m_Ast.addChild(function, parseBlock());
+        else
+            expect(TokenType::SEMICOLON, "a body or ';' after a function header");
+    }
+    finish(function);
+}
+
+uint32_t Parser::parseParameter()
+{
+    uint32_t node{m_Ast.add(NodeKind::PARAMETER, Ast::NO_TOKEN, m_Current)};
+    m_Ast.setFlags(node, parseQualifiers());
+    m_Ast.setType(node, parseTypeSpecifier(node));
+    if (!m_Panic)
+        parseArraySizes(node);
+    if (!m_Panic && check(TokenType::IDENTIFIER))
+    {
+        m_Ast.setToken(node, advance());
+        parseArraySizes(node);
+    }
+    finish(node);
+    return node;
+}
+
+void Parser::parseDeclarators(uint32_t declaration)
+{
+    do
+    {
+        uint32_t name{m_Current};
+        if (!expect(TokenType::IDENTIFIER, "a name"))
+            return;
+
+        uint32_t declarator{m_Ast.add(NodeKind::DECLARATOR, name, name)};
+        parseArraySizes(declarator);
+        if (!m_Panic && match(TokenType::EQUAL))
+            m_Ast.addChild(declarator, parseInitializer());
+        finish(declarator);
+        m_Ast.addChild(declaration, declarator);
+    }
+    while (!m_Panic && match(TokenType::COMMA));
+}
+
+void Parser::parseArraySizes(uint32_t node)
+{
+    while (!m_Panic && check(TokenType::LEFT_BRACKET))
+    {
+        uint32_t size{m_Ast.add(NodeKind::ARRAY_SIZE, Ast::NO_TOKEN, advance())};
+        if (!check(TokenType::RIGHT_BRACKET))
+            m_Ast.addChild(size, parseExpression());
+        if (!m_Panic)
+            expect(TokenType::RIGHT_BRACKET, "']'");
+        finish(size);
+        m_Ast.addChild(node, size);
+    }
+}
+
+uint32_t Parser::parseInitializer()
+{
+    if (!check(TokenType::LEFT_BRACE))
+        return parseAssignment();
+
+    uint32_t list{m_Ast.add(NodeKind::INITIALIZER_LIST, Ast::NO_TOKEN, advance())};
+    do
+    {
+        // a trailing comma is allowed
+        if (check(TokenType::RIGHT_BRACE))
+            break;
+        m_Ast.addChild(list, parseInitializer());
+    }
+    while (!m_Panic && match(TokenType::COMMA));
+
+    if (!m_Panic)
+        expect(TokenType::RIGHT_BRACE, "'}' after the initializers");
+    finish(list);
+    return list;
+}
+
+uint32_t Parser::parseStatement()
+{
+    DepthGuard guard{m_Depth};
+    if (m_Depth > MAX_DEPTH)
+    {
+        error("Statements nested too deep");
+        return m_Ast.add(NodeKind::ERROR, Ast::NO_TOKEN, m_Current);
+    }
+
+    switch (type())
+    {
+    case TokenType::LEFT_BRACE:
+        return parseBlock();
+    case TokenType::IF:
+        return parseIf();
+    case TokenType::FOR:
+        return parseFor();
+    case TokenType::WHILE:
+        return parseWhile();
+    case TokenType::DO:
+        return parseDo();
+    case TokenType::RETURN:
+        return parseSimple(NodeKind::RETURN);
+    case TokenType::BREAK:
+        return parseSimple(NodeKind::BREAK);
+    case TokenType::CONTINUE:
+        return parseSimple(NodeKind::CONTINUE);
+    case TokenType::DISCARD:
+        return parseSimple(NodeKind::DISCARD);
+    case TokenType::SEMICOLON:
+        return parseSimple(NodeKind::EMPTY);
+    case TokenType::KEYWORD:
+        if (checkWord("switch"))
+            return parseSwitch();
+        if (checkWord("case"))
+            return parseSimple(NodeKind::CASE);
+        if (checkWord("default"))
+            return parseSimple(NodeKind::DEFAULT);
+        break;
+    default:
+        break;
+    }
+
+    if (startsDeclaration())
+        return parseDeclaration(false);
+
+    uint32_t node{m_Ast.add(NodeKind::EXPRESSION_STATEMENT, Ast::NO_TOKEN, m_Current)};
+    m_Ast.addChild(node, parseExpression());
+    if (!m_Panic)
+        expect(TokenType::SEMICOLON, "';' after an expression");
+    finish(node);
+    return node;
+}
+
+uint32_t Parser::parseBlock()
+{
+    uint32_t node{m_Ast.add(NodeKind::BLOCK, Ast::NO_TOKEN, advance())};
+    while (!check(TokenType::RIGHT_BRACE) && !atEnd())
+    {
+        addDirectives(node);
+        uint32_t statement{parseStatement()};
+        if (m_Panic)
+            statement = recover(statement);
+        m_Ast.addChild(node, statement);
+    }
+    addDirectives(node);
+    expect(TokenType::RIGHT_BRACE, "'}'");
+    finish(node);
+    return node;
+}
+
+uint32_t Parser::parseIf()
+{
+    uint32_t node{m_Ast.add(NodeKind::IF, Ast::NO_TOKEN, advance())};
+    if (expect(TokenType::LEFT_PAREN, "'(' after if"))
+    {
+        m_Ast.addChild(node, parseExpression());
+        if (!m_Panic && expect(TokenType::RIGHT_PAREN, "')' after the condition"))
+        {
+            m_Ast.addChild(node, parseStatement());
+            if (!m_Panic && match(TokenType::ELSE))
+                m_Ast.addChild(node, parseStatement());
+        }
+    }
+    finish(node);
+    return node;
+}
+
+uint32_t Parser::parseFor()
+{
+    uint32_t node{m_Ast.add(NodeKind::FOR, Ast::NO_TOKEN, advance())};
+    if (!expect(TokenType::LEFT_PAREN, "'(' after for"))
+        return node;
+
+    // the init statement brings its ';', the condition and the step can be left out
+    m_Ast.addChild(node, parseStatement());
+    if (m_Panic)
+        return node;
+
+    if (check(TokenType::SEMICOLON))
+        m_Ast.addChild(node, m_Ast.add(NodeKind::EMPTY, Ast::NO_TOKEN, m_Current));
+    else
+        m_Ast.addChild(node, parseExpression());
+    if (m_Panic || !expect(TokenType::SEMICOLON, "';' after the loop condition"))
+        return node;
+
+    if (check(TokenType::RIGHT_PAREN))
+        m_Ast.addChild(node, m_Ast.add(NodeKind::EMPTY, Ast::NO_TOKEN, m_Current));
+    else
+        m_Ast.addChild(node, parseExpression());
+    if (m_Panic || !expect(TokenType::RIGHT_PAREN, "')' after the loop header"))
+        return node;
+
+    m_Ast.addChild(node, parseStatement());
+    finish(node);
+    return node;
+}
+
+uint32_t Parser::parseWhile()
+{
+    uint32_t node{m_Ast.add(NodeKind::WHILE, Ast::NO_TOKEN, advance())};
+    if (expect(TokenType::LEFT_PAREN, "'(' after while"))
+    {
+        m_Ast.addChild(node, parseExpression());
+        if (!m_Panic && expect(TokenType::RIGHT_PAREN, "')' after the condition"))
+            m_Ast.addChild(node, parseStatement());
+    }
+    finish(node);
+    return node;
+}
+
+uint32_t Parser::parseDo()
+{
+    uint32_t node{m_Ast.add(NodeKind::DO, Ast::NO_TOKEN, advance())};
+    m_Ast.addChild(node, parseStatement());
+    if (!m_Panic && expect(TokenType::WHILE, "while after the body") &&
+        expect(TokenType::LEFT_PAREN, "'(' after while"))
+    {
+        m_Ast.addChild(node, parseExpression());
+        if (!m_Panic && expect(TokenType::RIGHT_PAREN, "')' after the condition"))
+            expect(TokenType::SEMICOLON, "';' after do-while");
+    }
+    finish(node);
+    return node;
+}
+
+uint32_t Parser::parseSwitch()
+{
+    uint32_t node{m_Ast.add(NodeKind::SWITCH, Ast::NO_TOKEN, advance())};
+    if (expect(TokenType::LEFT_PAREN, "'(' after switch"))
+    {
+        m_Ast.addChild(node, parseExpression());
+        if (!m_Panic && expect(TokenType::RIGHT_PAREN, "')' after the switch expression"))
+        {
+            if (check(TokenType::LEFT_BRACE))
+                m_Ast.addChild(node, parseBlock());
+            else
+                error("Expected '{' after switch");
+        }
+    }
+    finish(node);
+    return node;
+}
+
+uint32_t Parser::parseSimple(NodeKind kind)
+{
+    uint32_t node{m_Ast.add(kind, Ast::NO_TOKEN, advance())};
+    bool label{kind == NodeKind::CASE || kind == NodeKind::DEFAULT};
+    if (kind == NodeKind::EMPTY)
+    {
+        finish(node);
+        return node;
+    }
+
+    if (kind == NodeKind::CASE || (kind == NodeKind::RETURN && !check(TokenType::SEMICOLON)))
+        m_Ast.addChild(node, parseExpression());
+    if (!m_Panic)
+        expect(label ? TokenType::COLON : TokenType::SEMICOLON, label ? "':' after the label" : "';'");
+    finish(node);
+    return node;
+}
+
+uint32_t Parser::parseExpression()
+{
+    uint32_t node{parseAssignment()};
+    while (!m_Panic && check(TokenType::COMMA))
+    {
+        uint32_t sequence{m_Ast.add(NodeKind::SEQUENCE, advance(), m_Ast.begin(node))};
+        m_Ast.addChild(sequence, node);
+        m_Ast.addChild(sequence, parseAssignment());
+        finish(sequence);
+        node = sequence;
+    }
+    return node;
+}
+
+uint32_t Parser::parseAssignment()
+{
+    DepthGuard guard{m_Depth};
+    if (m_Depth > MAX_DEPTH)
+    {
+        error("Expression nested too deep");
+        return m_Ast.add(NodeKind::ERROR, Ast::NO_TOKEN, m_Current);
+    }
+
+    uint32_t target{parseTernary()};
+    TokenType t{type()};
+    bool split{isSplitAssignment(t) && typeAt(after(m_Current)) == TokenType::EQUAL};
+    if (m_Panic || !(isAssignment(t) || split))
+        return target;
+
+    uint32_t node{m_Ast.add(NodeKind::ASSIGNMENT, advance(), m_Ast.begin(target))};
+    if (split)
+        advance();
+    m_Ast.addChild(node, target);
+    m_Ast.addChild(node, parseAssignment());
+    finish(node);
+    return node;
+}
+
+uint32_t Parser::parseTernary()
+{
+    uint32_t condition{parseBinary(1)};
+    if (m_Panic || !check(TokenType::QUESTION))
+        return condition;
+
+    uint32_t node{m_Ast.add(NodeKind::TERNARY, advance(), m_Ast.begin(condition))};
+    m_Ast.addChild(node, condition);
+    m_Ast.addChild(node, parseExpression());
+    if (!m_Panic && expect(TokenType::COLON, "':' in ?:"))
+        m_Ast.addChild(node, parseAssignment());
+    finish(node);
+    return node;
+}
+
+uint32_t Parser::parseBinary(int precedence)
+{
+    // precedence climbing, operators of one level are left associative
+    uint32_t left{parseUnary()};
+    while (!m_Panic)
+    {
+        TokenType t{type()};
+        int level{binaryPrecedence(t)};
+        if (level == 0)
+            return left;
+
+        bool logicalXor{false};
+        if (t == TokenType::CARET || isSplitAssignment(t))
+        {
+            TokenType next{typeAt(after(m_Current))};
+            if (t == TokenType::CARET && next == TokenType::CARET)
+            {
+                logicalXor = true;
+                level = XOR_PRECEDENCE;
+            }
+            else if (next == TokenType::EQUAL)
+                return left;
+        }
+        if (level < precedence)
+            return left;
+
+        uint32_t node{m_Ast.add(NodeKind::BINARY, advance(), m_Ast.begin(left))};
+        if (logicalXor)
+            advance();
+        m_Ast.addChild(node, left);
+        m_Ast.addChild(node, parseBinary(level + 1));
+        finish(node);
+        left = node;
+    }
+    return left;
+}
+
+uint32_t Parser::parseUnary()
+{
+    DepthGuard guard{m_Depth};
+    if (m_Depth > MAX_DEPTH)
+    {
+        error("Expression nested too deep");
+        return m_Ast.add(NodeKind::ERROR, Ast::NO_TOKEN, m_Current);
+    }
+
+    TokenType t{type()};
+    if (t == TokenType::PLUS || t == TokenType::MINUS || t == TokenType::BANG || t == TokenType::TILDE ||
+        t == TokenType::PLUS_PLUS || t == TokenType::MINUS_MINUS)
+    {
+        uint32_t at{advance()};
+        uint32_t node{m_Ast.add(NodeKind::UNARY, at, at)};
+        m_Ast.addChild(node, parseUnary());
+        finish(node);
+        return node;
+    }
+    return parsePostfix(parsePrimary());
+}
+
+uint32_t Parser::parsePostfix(uint32_t node)
+{
+    while (!m_Panic)
+    {
+        switch (type())
+        {
+        case TokenType::LEFT_BRACKET:
+            {
+                uint32_t index{m_Ast.add(NodeKind::INDEX, advance(), m_Ast.begin(node))};
+                m_Ast.addChild(index, node);
+                m_Ast.addChild(index, parseExpression());
+                if (!m_Panic)
+                    expect(TokenType::RIGHT_BRACKET, "']'");
+                finish(index);
+                node = index;
+                break;
+            }
+        case TokenType::DOT:
+            {
+                advance();
+                uint32_t name{m_Current};
+                if (!expect(TokenType::IDENTIFIER, "a field name after '.'"))
+                    return node;
+
+                uint32_t member{m_Ast.add(check(TokenType::LEFT_PAREN) ? NodeKind::CALL : NodeKind::MEMBER, name,
+                                          m_Ast.begin(node))};
+                m_Ast.addChild(member, node);
+                if (m_Ast.kind(member) == NodeKind::CALL)
+                {
+                    m_Ast.setFlags(member, FLAG_METHOD);
+                    parseArguments(member);
+                }
+                finish(member);
+                node = member;
+                break;
+            }
+        case TokenType::PLUS_PLUS:
+        case TokenType::MINUS_MINUS:
+            {
+                uint32_t postfix{m_Ast.add(NodeKind::POSTFIX, advance(), m_Ast.begin(node))};
+                m_Ast.addChild(postfix, node);
+                finish(postfix);
+                node = postfix;
+                break;
+            }
+        default:
+            return node;
+        }
+    }
+    return node;
+}
+
+uint32_t Parser::parsePrimary()
+{
+    TokenType t{type()};
+    if (t == TokenType::NUMBER || checkWord("true") || checkWord("false"))
+    {
+        uint32_t at{advance()};
+        uint32_t node{m_Ast.add(NodeKind::LITERAL, at, at)};
+        finish(node);
+        return node;
+    }
+
+    if (t == TokenType::LEFT_PAREN)
+    {
+        uint32_t node{m_Ast.add(NodeKind::GROUP, Ast::NO_TOKEN, advance())};
+        m_Ast.addChild(node, parseExpression());
+        if (!m_Panic)
+            expect(TokenType::RIGHT_PAREN, "')'");
+        finish(node);
+        return node;
+    }
+
+    if (t == TokenType::IDENTIFIER || Minifier::isType(t))
+    {
+        TokenType next{typeAt(after(m_Current))};
+        bool typeName{t != TokenType::IDENTIFIER || m_StructNames[m_Tokens.id(m_Current)]};
+        if (next == TokenType::LEFT_PAREN || (typeName && next == TokenType::LEFT_BRACKET))
+        {
+            // a call or a constructor, float[2](..) has its sizes first
+            uint32_t at{advance()};
+            uint32_t call{m_Ast.add(NodeKind::CALL, at, at)};
+            parseArraySizes(call);
+            if (!m_Panic)
+                parseArguments(call);
+            finish(call);
+            return call;
+        }
+        if (t == TokenType::IDENTIFIER)
+        {
+            uint32_t at{advance()};
+            uint32_t node{m_Ast.add(NodeKind::NAME, at, at)};
+            finish(node);
+            return node;
+        }
+    }
+
+    error("Expected an expression");
+    return m_Ast.add(NodeKind::ERROR, Ast::NO_TOKEN, m_Current);
+}
+
+void Parser::parseArguments(uint32_t call)
+{
+    if (!expect(TokenType::LEFT_PAREN, "'('"))
+        return;
+
+    if (check(TokenType::VOID) && typeAt(after(m_Current)) == TokenType::RIGHT_PAREN)
+        advance();
+    else if (!check(TokenType::RIGHT_PAREN))
+    {
+        do
+            m_Ast.addChild(call, parseAssignment());
+        while (!m_Panic && match(TokenType::COMMA));
+    }
+    if (!m_Panic)
+        expect(TokenType::RIGHT_PAREN, "')' after the arguments");
+}
@@ -0,0 +1,524 @@
+#include "Preprocessor.hpp"
+#include "CharClass.hpp"
+
+#include <algorithm>
+
+namespace
+{
+// macros that expand to themselves would never end
+constexpr int MAX_EXPANSION_DEPTH{32};
+
+std::string_view trim(std::string_view text)
+{
+    while (!text.empty() && hasCharClass(text.front(), CHAR_BLANK))
+        text.remove_prefix(1);
+    while (!text.empty() && hasCharClass(text.back(), CHAR_BLANK))
+        text.remove_suffix(1);
+    return text;
+}
+
+// leading identifier of text, text is advanced past it
+std::string_view takeIdentifier(std::string_view& text)
+{
+    text = trim(text);
+    std::size_t length{0};
+    if (!text.empty() && isIdentStartChar(text[0]))
+        while (length < text.length() && isIdentChar(text[length]))
+            ++length;
+
+    std::string_view name{text.substr(0, length)};
+    text.remove_prefix(length);
+    return name;
+}
+
+bool isVersionLine(std::string_view line)
+{
+    line.remove_prefix(1); // the '#'
+    return takeIdentifier(line) == "version";
+}
+
+// precedence climbing over the text of one #if/#elif line
+class ConditionParser
+{
+private:
+    std::string_view m_Text;
+    std::size_t m_Pos{0};
+    const DefineSet& m_Defines;
+    int m_Depth;
+
+    void skipSpace()
+    {
+        while (m_Pos < m_Text.length())
+        {
+            char c{m_Text[m_Pos]};
+            if (hasCharClass(c, CHAR_BLANK))
+                ++m_Pos;
+            else if (c == '/' && m_Pos + 1 < m_Text.length() && m_Text[m_Pos + 1] == '/')
+                m_Pos = m_Text.length();
+            else if (c == '/' && m_Pos + 1 < m_Text.length() && m_Text[m_Pos + 1] == '*')
+            {
+                std::size_t close{m_Text.find("*/", m_Pos + 2)};
+                m_Pos = close == std::string_view::npos ? m_Text.length() : close + 2;
+            }
+            else
+                break;
+        }
+    }
+
+    bool match(std::string_view op)
+    {
+        skipSpace();
+        if (m_Text.substr(m_Pos, op.length()) != op)
+            return false;
+        m_Pos += op.length();
+        return true;
+    }
+
+    std::string_view identifier()
+    {
+        skipSpace();
+        std::size_t start{m_Pos};
+        if (m_Pos < m_Text.length() && isIdentStartChar(m_Text[m_Pos]))
+            while (m_Pos < m_Text.length() && isIdentChar(m_Text[m_Pos]))
+                ++m_Pos;
+        return m_Text.substr(start, m_Pos - start);
+    }
+
+    long long number()
+    {
+        std::size_t start{m_Pos};
+        int base{10};
+        bool hexPrefix{m_Pos + 1 < m_Text.length() && (m_Text[m_Pos + 1] == 'x' || m_Text[m_Pos + 1] == 'X')};
+        if (m_Text[m_Pos] == '0' && hexPrefix)
+        {
+            base = 16;
+            m_Pos += 2;
+        }
+        else if (m_Text[m_Pos] == '0')
+            base = 8;
+
+        long long value{0};
+        for (; m_Pos < m_Text.length() && hasCharClass(m_Text[m_Pos], CHAR_HEX_DIGIT); ++m_Pos)
+        {
+            char c{m_Text[m_Pos]};
+            int digit{isDigitChar(c) ? c - '0' : (c | 0x20) - 'a' + 10};
+            if (digit >= base)
+                break;
+            value = value * base + digit;
+        }
+        while (m_Pos < m_Text.length() && (m_Text[m_Pos] == 'u' || m_Text[m_Pos] == 'U'))
+            ++m_Pos;
+        if (m_Pos == start)
+            ++m_Pos; // not a number after all, skip it
+        return value;
+    }
+
+    long long primary()
+    {
+        skipSpace();
+        if (m_Pos >= m_Text.length())
+            return 0;
+
+        if (match("("))
+        {
+            long long value{conditional()};
+            match(")");
+            return value;
+        }
+        if (isDigitChar(m_Text[m_Pos]))
+            return number();
+
+        std::string_view name{identifier()};
+        if (name.empty())
+        {
+            ++m_Pos; // stray character
+            return 0;
+        }
+
+        if (name == "defined")
+        {
+            bool parenthesized{match("(")};
+            std::string_view macro{identifier()};
+            if (parenthesized)
+                match(")");
+            return m_Defines.find(std::string{macro}) != m_Defines.end();
+        }
+
+        auto it{m_Defines.find(std::string{name})};
+        if (it == m_Defines.end() || m_Depth >= MAX_EXPANSION_DEPTH)
+            return 0;
+        return ConditionParser{it->second, m_Defines, m_Depth + 1}.conditional();
+    }
+
+    long long unary()
+    {
+        if (match("!"))
+            return !unary();
+        if (match("~"))
+            return ~unary();
+        if (match("-"))
+            return -unary();
+        if (match("+"))
+            return unary();
+        return primary();
+    }
+
+    // binary operator at m_Pos with its precedence, 0 if there is none
+    int peekBinary(std::string_view& op)
+    {
+        static constexpr struct
+        {
+            std::string_view op;
+            int precedence;
+        } OPERATORS[]{
+            {"||", 1}, {"&&", 2}, {"==", 6}, {"!=", 6}, {"<=", 7}, {">=", 7}, {"<<", 8}, {">>", 8},
+            {"|", 3}, {"^", 4}, {"&", 5}, {"<", 7}, {">", 7}, {"+", 9}, {"-", 9}, {"*", 10}, {"/", 10}, {"%", 10},
+        };
+
+        skipSpace();
+        for (const auto& entry : OPERATORS)
+        {
+            if (m_Text.substr(m_Pos, entry.op.length()) == entry.op)
+            {
+                op = entry.op;
+                return entry.precedence;
+            }
+        }
+        return 0;
+    }
+
+    static long long apply(std::string_view op, long long lhs, long long rhs)
+    {
+        switch (op[0])
+        {
+        case '|':
+            return op.length() == 2 ? (lhs || rhs) : (lhs | rhs);
+        case '&':
+            return op.length() == 2 ? (lhs && rhs) : (lhs & rhs);
+        case '^':
+            return lhs ^ rhs;
+        case '=':
+            return lhs == rhs;
+        case '!':
+            return lhs != rhs;
+        case '<':
+            return op == "<<" ? (rhs >= 0 && rhs < 64 ? lhs << rhs : 0) : op == "<=" ? lhs <= rhs : lhs < rhs;
+        case '>':
+            return op == ">>" ? (rhs >= 0 && rhs < 64 ? lhs >> rhs : 0) : op == ">=" ? lhs >= rhs : lhs > rhs;
+        case '+':
+            return lhs + rhs;
+        case '-':
+            return lhs - rhs;
+        case '*':
+            return lhs * rhs;
+        case '/':
+            return rhs == 0 ? 0 : lhs / rhs;
+        case '%':
+            return rhs == 0 ? 0 : lhs % rhs;
+        }
+        return 0;
+    }
+
+    long long binary(int minPrecedence)
+    {
+        long long lhs{unary()};
+        std::string_view op;
+        for (int precedence{peekBinary(op)}; precedence >= minPrecedence && precedence > 0;
+             precedence = peekBinary(op))
+        {
+            m_Pos += op.length();
+            long long rhs{binary(precedence + 1)};
+            lhs = apply(op, lhs, rhs);
+        }
+        return lhs;
+    }
+
+public:
+    ConditionParser(std::string_view text, const DefineSet& defines, int depth)
+        : m_Text{text}, m_Defines{defines}, m_Depth{depth}
+    {
+    }
+
+    long long conditional()
+    {
+        long long condition{binary(1)};
+        if (!match("?"))
+            return condition;
+
+        long long whenTrue{conditional()};
+        match(":");
+        long long whenFalse{conditional()};
+        return condition ? whenTrue : whenFalse;
+    }
+};
+}
+
+Preprocessor::Preprocessor(const TokenBuffer& tokens)
+    : m_Tokens{tokens}
+{
+    for (std::size_t i{0}; i < tokens.size(); ++i)
+    {
+        if (tokens.type(i) != TokenType::PREPROCESSOR)
+            continue;
+
+        std::string_view text{tokens.lexeme(i).substr(1)}; // past the '#'
+        std::string_view word{takeIdentifier(text)};
+
+        Directive directive{DirectiveKind::IF, static_cast<uint32_t>(i), {}, {}};
+        if (word == "if" || word == "elif")
+        {
+            directive.kind = word == "if" ? DirectiveKind::IF : DirectiveKind::ELIF;
+            directive.argument = trim(text);
+        }
+        else if (word == "ifdef" || word == "ifndef" || word == "undef")
+        {
+            directive.kind = word == "ifdef" ? DirectiveKind::IFDEF : word == "ifndef" ? DirectiveKind::IFNDEF
+                                 : DirectiveKind::UNDEF;
+            directive.name = takeIdentifier(text);
+        }
+        else if (word == "define")
+        {
+            directive.kind = DirectiveKind::DEFINE;
+            directive.name = takeIdentifier(text);
+            // function-like macros count as defined, their value is not evaluated
+            directive.argument = !text.empty() && text[0] == '(' ? std::string_view{} : trim(text);
+        }
+        else if (word == "else")
+            directive.kind = DirectiveKind::ELSE;
+        else if (word == "endif")
+            directive.kind = DirectiveKind::ENDIF;
+        else
+            continue; // #version, #extension, #pragma... are ordinary tokens here
+
+        m_Directives.push_back(directive);
+    }
+}
+
+std::vector<TokenRange> Preprocessor::select(const DefineSet& defines) const
+{
+    struct Frame
+    {
+        bool parentActive;
+        bool taken; // some branch of this #if already survived
+    };
+
+    std::vector<TokenRange> ranges;
+    std::vector<Frame> frames;
+    DefineSet current{defines};
+    bool active{true};
+    uint32_t runStart{0};
+
+    auto closeRun{
+        [&](uint32_t end)
+        {
+            if (active && end > runStart)
+                ranges.push_back({runStart, end});
+        }
+    };
+
+    for (const Directive& directive : m_Directives)
+    {
+        switch (directive.kind)
+        {
+        case DirectiveKind::DEFINE:
+            if (active)
+                current[std::string{directive.name}] = std::string{directive.argument};
+            continue; // the line itself stays in the output
+        case DirectiveKind::UNDEF:
+            if (active)
+                current.erase(std::string{directive.name});
+            continue;
+        default:
+            break;
+        }
+
+        closeRun(directive.token);
+        runStart = directive.token + 1;
+
+        switch (directive.kind)
+        {
+        case DirectiveKind::IF:
+        case DirectiveKind::IFDEF:
+        case DirectiveKind::IFNDEF:
+        {
+            bool condition{false};
+            if (active)
+            {
+                if (directive.kind == DirectiveKind::IF)
+                    condition = evaluate(directive.argument, current) != 0;
+                else
+                    condition = (current.find(std::string{directive.name}) != current.end()) ==
+                        (directive.kind == DirectiveKind::IFDEF);
+            }
+            frames.push_back({active, condition});
+            active = condition;
+            break;
+        }
+        case DirectiveKind::ELIF:
+            if (frames.empty())
+                break;
+            active = frames.back().parentActive && !frames.back().taken &&
+                evaluate(directive.argument, current) != 0;
+            frames.back().taken = frames.back().taken || active;
+            break;
+        case DirectiveKind::ELSE:
+            if (frames.empty())
+                break;
+            active = frames.back().parentActive && !frames.back().taken;
+            frames.back().taken = true;
+            break;
+        case DirectiveKind::ENDIF:
+            if (frames.empty())
+                break;
+            active = frames.back().parentActive;
+            frames.pop_back();
+            break;
+        default:
+            break;
+        }
+    }
+
+    // END_OF_FILE survives even an unterminated #if
+    auto last{static_cast<uint32_t>(m_Tokens.size())};
+    closeRun(last);
+    if (last > 0 && (ranges.empty() || ranges.back().end != last))
+        ranges.push_back({last - 1, last});
+    return ranges;
+}
+
+TokenBuffer Preprocessor::filter(const std::vector<TokenRange>& ranges) const
+{
+    std::size_t count{0};
+    for (const TokenRange& range : ranges)
+        count += range.end - range.begin;
+
+    TokenBuffer tokens{m_Tokens.source()};
+    tokens.reserve(count);
+    for (const TokenRange& range : ranges)
+        tokens.append(m_Tokens, range.begin, range.end);
+    return tokens;
+}
+
+std::vector<uint32_t> Preprocessor::occurrences(std::string_view name) const
+{
+    std::vector<uint32_t> tokens;
+    uint32_t id{m_Tokens.findId(name)};
+    for (std::size_t i{0}; i < m_Tokens.size(); ++i)
+    {
+        TokenType type{m_Tokens.type(i)};
+        if (type == TokenType::IDENTIFIER && id != IdentifierTable::NO_ID && m_Tokens.id(i) == id)
+            tokens.push_back(static_cast<uint32_t>(i));
+        else if (type == TokenType::PREPROCESSOR)
+        {
+            std::string_view text{m_Tokens.lexeme(i)};
+            // words as Minifier::forEachWord finds them, 1e5 has none
+            while (!text.empty())
+            {
+                std::size_t length{0};
+                while (length < text.length() && isIdentChar(text[length]))
+                    ++length;
+                if (length == 0)
+                {
+                    text.remove_prefix(1);
+                    continue;
+                }
+                if (isIdentStartChar(text[0]) && text.substr(0, length) == name)
+                {
+                    tokens.push_back(static_cast<uint32_t>(i));
+                    break;
+                }
+                text.remove_prefix(length);
+            }
+        }
+    }
+    return tokens;
+}
+
+bool Preprocessor::covers(const std::vector<TokenRange>& ranges, const std::vector<uint32_t>& tokens)
+{
+    // both in order, one walk over the two
+    auto range{ranges.begin()};
+    for (uint32_t token : tokens)
+    {
+        while (range != ranges.end() && range->end <= token)
+            ++range;
+        if (range == ranges.end())
+            return false;
+        if (range->begin <= token)
+            return true;
+    }
+    return false;
+}
+
+std::string Preprocessor::insertDefines(std::string_view text, const DefineSet& defines)
+{
+    // #version has to stay the first line
+    std::size_t at{0};
+    if (!text.empty() && text[0] == '#' && isVersionLine(text.substr(0, text.find('\n'))))
+        at = text.find('\n') == std::string_view::npos ? text.length() : text.find('\n') + 1;
+
+    std::string lines{defineLines(defines)};
+    std::string result;
+    result.reserve(text.length() + lines.length() + 1);
+    result.append(text.substr(0, at));
+    if (at != 0 && result.back() != '\n')
+        result += '\n';
+    result += lines;
+    result.append(text.substr(at));
+    return result;
+}
+
+std::string Preprocessor::defineLines(const DefineSet& defines)
+{
+    std::vector<const DefineSet::value_type*> sorted;
+    sorted.reserve(defines.size());
+    for (const auto& define : defines)
+        sorted.push_back(&define);
+    std::sort(sorted.begin(), sorted.end(), [](const auto* a, const auto* b) { return a->first < b->first; });
+
+    std::string lines;
+    for (const auto* define : sorted)
+    {
+        lines += "#define ";
+        lines += define->first;
+        if (!define->second.empty())
+        {
+            lines += ' ';
+            lines += define->second;
+        }
+        lines += '\n';
+    }
+    return lines;
+}
+
+long long Preprocessor::evaluate(std::string_view expression, const DefineSet& defines)
+{
+    return ConditionParser{expression, defines, 0}.conditional();
+}
+
+DefineSet Preprocessor::parseDefines(std::string_view line)
+{
+    DefineSet defines;
+    std::size_t pos{0};
+    while (pos < line.length())
+    {
+        while (pos < line.length() && hasCharClass(line[pos], CHAR_BLANK))
+            ++pos;
+        std::size_t start{pos};
+        while (pos < line.length() && !hasCharClass(line[pos], CHAR_BLANK))
+            ++pos;
+
+        std::string_view word{line.substr(start, pos - start)};
+        if (word.substr(0, 2) == "-D")
+            word.remove_prefix(2);
+        if (word.empty())
+            continue;
+
+        std::size_t equals{word.find('=')};
+        if (equals == std::string_view::npos)
+            defines[std::string{word}] = "1"; // same as -DNAME on a compiler command line
+        else
+            defines[std::string{word.substr(0, equals)}] = std::string{word.substr(equals + 1)};
+    }
+    return defines;
+}
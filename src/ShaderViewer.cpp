@@ -0,0 +1,93 @@
+#include "ShaderViewer.hpp"
+
+#include <SFML/Graphics.hpp>
+#include <iostream>
+#include <optional>
+#include <utility>
+
+ShaderViewer::ShaderViewer(std::function<std::string()> load)
+    : m_Load{std::move(load)}
+{
+}
+
+void ShaderViewer::run()
+{
+    sf::RenderWindow window{sf::VideoMode({WIDTH, HEIGHT}), "GLSL Shader Viewer"};
+    window.setFramerateLimit(60);
+
+    std::string fragmentSource{m_Load()};
+
+    std::string vertexSource{
+        R"(
+        #version 330 core
+
+        layout(location = 0) in vec2 position;
+        layout(location = 1) in vec2 texCoord;
+
+        out vec2 fragTexCoord;
+
+        void main() {
+            gl_Position = vec4(position, 0.0, 1.0);
+            fragTexCoord = texCoord;
+        }
+    )"
+    };
+
+    sf::Shader shader;
+    if (!shader.loadFromMemory(vertexSource, fragmentSource))
+    {
+        std::cerr << "Error: Failed to compile shader" << std::endl;
+        return;
+    }
+
+    std::cout << "Shader compiled successfully!" << std::endl;
+    std::cout << "Controls: ESC to exit, R to reload shader" << std::endl;
+
+    sf::VertexArray vertices{sf::PrimitiveType::TriangleStrip, 4};
+    vertices[0].position = sf::Vector2f(-1.f, -1.f);
+    vertices[1].position = sf::Vector2f(1.f, -1.f);
+    vertices[2].position = sf::Vector2f(-1.f, 1.f);
+    vertices[3].position = sf::Vector2f(1.f, 1.f);
+
+    vertices[0].texCoords = sf::Vector2f(0.f, 0.f);
+    vertices[1].texCoords = sf::Vector2f(1.f, 0.f);
+    vertices[2].texCoords = sf::Vector2f(0.f, 1.f);
+    vertices[3].texCoords = sf::Vector2f(1.f, 1.f);
+
+    sf::Clock clock;
+    while (window.isOpen())
+    {
+        while (const std::optional event = window.pollEvent())
+        {
+            if (event->is<sf::Event::Closed>())
+                window.close();
+
+            if (sf::Keyboard::isKeyPressed(sf::Keyboard::Scancode::Escape))
+                window.close();
+
+            if (sf::Keyboard::isKeyPressed(sf::Keyboard::Scancode::R))
+            {
+                std::cout << "Reloading shader..." << std::endl;
+                fragmentSource = m_Load();
+                if (shader.loadFromMemory(vertexSource, fragmentSource))
+                {
+                    std::cout << "Shader reloaded successfully!" << std::endl;
+                    clock.restart();
+                }
+                else
+                    std::cerr << "Failed to reload shader!" << std::endl;
+            }
+        }
+
+        float time{clock.getElapsedTime().asSeconds()};
+
+        shader.setUniform("time", time);
+        shader.setUniform("resolution", sf::Vector2f(WIDTH, HEIGHT));
+        shader.setUniform("iTime", time);
+        shader.setUniform("iResolution", sf::Vector3f(WIDTH, HEIGHT, 0.0f));
+
+        window.clear(sf::Color::Black);
+        window.draw(vertices, &shader);
+        window.display();
+    }
+}
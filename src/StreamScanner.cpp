@@ -0,0 +1,171 @@
+#include "StreamScanner.hpp"
+#include "Lexer.hpp"
+#include "TextScan.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+
+std::size_t StreamScanner::readSome(char* dst, std::size_t count)
+{
+    if (m_Stream)
+    {
+        m_Stream->read(dst, static_cast<std::streamsize>(count));
+        return static_cast<std::size_t>(m_Stream->gcount());
+    }
+
+    for (;;)
+    {
+        ssize_t n{::read(m_Fd, dst, count)};
+        if (n >= 0)
+            return static_cast<std::size_t>(n);
+        if (errno == EINTR)
+            continue;
+
+        if (m_ErrorReporter)
+            m_ErrorReporter->reportError(ErrorSeverity::FATAL, std::string{"Read failed: "} + std::strerror(errno),
+                                         m_Line, 0);
+        return 0;
+    }
+}
+
+void StreamScanner::refill()
+{
+    // keep the unconsumed tail, it is at most one partial token
+    if (m_Begin > 0)
+    {
+        std::memmove(m_Buffer.data(), m_Buffer.data() + m_Begin, m_End - m_Begin);
+        m_End -= m_Begin;
+        m_Begin = 0;
+    }
+
+    // a single token longer than the whole buffer
+    if (m_End == m_Buffer.size())
+        m_Buffer.resize(m_Buffer.size() * 2);
+
+    std::size_t n{readSome(m_Buffer.data() + m_End, m_Buffer.size() - m_End)};
+    if (n == 0)
+        m_Eof = true;
+    m_End += n;
+    m_BytesRead += n;
+}
+
+void StreamScanner::reportError(const char* at, const std::string& message)
+{
+    if (!m_ErrorReporter)
+        return;
+
+    // context is the part of the line still in the buffer, at most CONTEXT_RADIUS bytes either side so
+    // garbage without newlines stays linear, the column is relative to that context
+    const std::size_t CONTEXT_RADIUS{60};
+    const char* bufferStart{m_Buffer.data()};
+    const char* bufferEnd{m_Buffer.data() + m_End};
+
+    const char* lineStart{at};
+    while (lineStart > bufferStart && lineStart[-1] != '\n' &&
+        static_cast<std::size_t>(at - lineStart) < CONTEXT_RADIUS)
+        lineStart--;
+
+    const char* lineEnd{std::find(at, at + std::min<std::size_t>(CONTEXT_RADIUS, bufferEnd - at), '\n')};
+    int column{static_cast<int>(at - lineStart) + 1};
+    m_ErrorReporter->reportError(ErrorSeverity::ERROR, message, m_Line, column,
+                                 std::string{lineStart, static_cast<std::size_t>(lineEnd - lineStart)});
+}
+
+StreamScanner::StreamScanner(int fd, ErrorReporter* reporter, std::size_t chunkSize)
+    : m_Fd{fd}, m_ErrorReporter{reporter}, m_Buffer(std::max<std::size_t>(chunkSize, 2 * LEXER_LOOKAHEAD))
+{
+}
+
+StreamScanner::StreamScanner(std::istream& stream, ErrorReporter* reporter, std::size_t chunkSize)
+    : m_Stream{&stream}, m_ErrorReporter{reporter}, m_Buffer(std::max<std::size_t>(chunkSize, 2 * LEXER_LOOKAHEAD))
+{
+}
+
+StreamToken StreamScanner::nextToken()
+{
+    for (;;)
+    {
+        // every decision below looks at most LEXER_LOOKAHEAD bytes past what it consumes
+        if (m_End - m_Begin <= LEXER_LOOKAHEAD && !m_Eof)
+        {
+            refill();
+            continue;
+        }
+
+        if (m_Begin == m_End)
+            return {TokenType::END_OF_FILE, {}, m_Line};
+
+        const char* begin{m_Buffer.data() + m_Begin};
+        const char* end{m_Buffer.data() + m_End};
+        const char* p{begin};
+
+        // comments carry over chunk boundaries as state
+        if (m_Comment == CommentState::LINE)
+        {
+            p = findNewline(p, end);
+            if (p == end)
+            {
+                m_Begin = m_End;
+                continue;
+            }
+            m_Comment = CommentState::NONE;
+        }
+        else if (m_Comment == CommentState::BLOCK)
+        {
+            p = findBlockCommentEnd(p, end, m_Line);
+            if (p == end)
+            {
+                // a trailing '*' might be closed by a '/' in the next chunk
+                if (end[-1] == '*' && !m_Eof)
+                {
+                    m_Begin = m_End - 1;
+                    refill();
+                }
+                else
+                    m_Begin = m_End;
+                continue;
+            }
+            p += 2;
+            m_Comment = CommentState::NONE;
+        }
+
+        p = skipBlanks(p, end, m_Line);
+        m_Begin = static_cast<std::size_t>(p - m_Buffer.data());
+        if (p == end)
+            continue;
+
+        if (*p == '/')
+        {
+            if (p + 1 == end && !m_Eof)
+            {
+                refill();
+                continue;
+            }
+            if (p + 1 < end && (p[1] == '/' || p[1] == '*'))
+            {
+                m_Comment = p[1] == '/' ? CommentState::LINE : CommentState::BLOCK;
+                m_Begin += 2;
+                continue;
+            }
+        }
+
+        Lexeme lexeme{lexToken(p, end)};
+        // the token (or its lookahead) might go on in the next chunk
+        if (!m_Eof && p + lexeme.length + LEXER_LOOKAHEAD > end)
+        {
+            refill();
+            continue;
+        }
+
+        m_Begin += lexeme.length;
+        if (lexeme.type == TokenType::ERROR)
+        {
+            reportError(p, std::string{"Unexpected character: '"} + *p + "'");
+            continue;
+        }
+
+        return {lexeme.type, {p, lexeme.length}, m_Line};
+    }
+}
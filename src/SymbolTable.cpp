@@ -2,44 +2,123 @@
 
 #include <iostream>
 
-void SymbolTable::declareSymbol(const std::string& name, SymbolKind kind, int line)
+namespace
 {
-    Symbol& sym{m_Symbols[name]};
+    // the entry point is used by the pipeline, not by the shader
+    bool isUnused(const Symbol& sym)
+    {
+        return sym.isDeclared && sym.uses == 0 && sym.name != "main";
+    }
+
+    void writeVarint(std::pmr::vector<uint8_t>& out, uint32_t value)
+    {
+        while (value >= 0x80)
+        {
+            out.push_back(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<uint8_t>(value));
+    }
+
+    uint32_t readVarint(const uint8_t*& p)
+    {
+        uint32_t value{0};
+        for (int shift{0};; shift += 7)
+        {
+            uint8_t byte{*p++};
+            value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+            if (byte < 0x80)
+                return value;
+        }
+    }
+
+    const char* kindName(SymbolKind kind)
+    {
+        switch (kind)
+        {
+        case SymbolKind::VARIABLE:
+            return "variable";
+        case SymbolKind::FUNCTION:
+            return "function";
+        case SymbolKind::UNIFORM:
+            return "uniform";
+        case SymbolKind::PARAMETER:
+            return "parameter";
+        }
+        return "symbol";
+    }
+}
+
+void SymbolTable::resize(std::size_t identifierCount)
+{
+    m_Symbols.resize(identifierCount);
+}
+
+void SymbolTable::reset()
+{
+    // the vectors' own storage is in the arena too, they have to go before the arena is reset
+    m_Symbols = std::pmr::vector<Symbol>{&m_Arena};
+    m_Lines = std::pmr::vector<uint8_t>{&m_Arena};
+    m_LastLine = 0;
+    m_Arena.reset();
+}
+
+void SymbolTable::declareSymbol(uint32_t id, std::string_view name, SymbolKind kind, int line)
+{
+    Symbol& sym{m_Symbols[id]};
     sym.name = name;
     sym.kind = kind;
     sym.isDeclared = true;
     sym.declarationLine = line;
 }
 
-void SymbolTable::useSymbol(const std::string& name, int line)
+void SymbolTable::recordLine(uint32_t id, int line)
 {
-    if (m_Symbols.find(name) != m_Symbols.end())
-    {
-        m_Symbols[name].isUsed = true;
-        m_Symbols[name].usageLines.push_back(line);
-    }
-    else
+    // zigzag so a line before the last one is small too
+    int32_t delta{line - m_LastLine};
+    writeVarint(m_Lines, (static_cast<uint32_t>(delta) << 1) ^ static_cast<uint32_t>(delta >> 31));
+    writeVarint(m_Lines, id);
+    m_LastLine = line;
+}
+
+template <typename Function>
+void SymbolTable::forEachUse(Function function) const
+{
+    const uint8_t* p{m_Lines.data()};
+    const uint8_t* end{p + m_Lines.size()};
+    int line{0};
+    while (p < end)
     {
-        Symbol& sym{m_Symbols[name]};
-        sym.name = name;
-        sym.isUsed = true;
-        sym.usageLines.push_back(line);
+        uint32_t zigzag{readVarint(p)};
+        line += static_cast<int32_t>(zigzag >> 1) ^ -static_cast<int32_t>(zigzag & 1);
+        uint32_t id{readVarint(p)};
+        function(id, line);
     }
 }
 
-bool SymbolTable::isSymbolUsed(const std::string& name) const
+bool SymbolTable::isSymbolUsed(uint32_t id) const
 {
-    auto it{m_Symbols.find(name)};
-    return it != m_Symbols.end() && it->second.isUsed;
+    return id < m_Symbols.size() && m_Symbols[id].uses > 0;
 }
 
-std::vector<std::string> SymbolTable::getUnusedSymbols() const
+std::vector<int> SymbolTable::getUsageLines(uint32_t id) const
 {
-    std::vector<std::string> unused;
-    for (const auto& pair : m_Symbols)
+    std::vector<int> lines;
+    forEachUse([&](uint32_t use, int line)
     {
-        if (pair.second.isDeclared && !pair.second.isUsed)
-            unused.push_back(pair.second.name);
+        if (use == id)
+            lines.push_back(line);
+    });
+    return lines;
+}
+
+std::vector<std::string_view> SymbolTable::getUnusedSymbols() const
+{
+    std::vector<std::string_view> unused;
+    for (const Symbol& sym : m_Symbols)
+    {
+        if (isUnused(sym))
+            unused.push_back(sym.name);
     }
     return unused;
 }
@@ -47,9 +126,9 @@ std::vector<std::string> SymbolTable::getUnusedSymbols() const
 int SymbolTable::getUnusedCount() const
 {
     int cnt{0};
-    for (const auto& pair : m_Symbols)
+    for (const Symbol& sym : m_Symbols)
     {
-        if (pair.second.isDeclared && !pair.second.isUsed)
+        if (isUnused(sym))
             ++cnt;
     }
     return cnt;
@@ -57,34 +136,40 @@ int SymbolTable::getUnusedCount() const
 
 void SymbolTable::print() const
 {
-    auto unused{getUnusedSymbols()};
-    if (unused.empty())
-    {
+    int unused{getUnusedCount()};
+    if (unused == 0)
         std::cout << "No unused symbols detected\n";
-        return;
-    }
-    std::cout << "Dead code:\n" << "Found: " << unused.size() << " unused symbols\n";
-    for (const auto& name : unused)
+    else
     {
-        const Symbol& sym{m_Symbols.at(name)};
-        std::cout << "Line " << sym.declarationLine << ": ";
-        switch (sym.kind)
+        std::cout << "Dead code:\n" << "Found: " << unused << " unused symbols\n";
+        for (const Symbol& sym : m_Symbols)
         {
-        case SymbolKind::VARIABLE:
-            std::cout << "variable ";
-            break;
-        case SymbolKind::FUNCTION:
-            std::cout << "function ";
-            break;
-        case SymbolKind::UNIFORM:
-            std::cout << "uniform ";
-            break;
-        case SymbolKind::PARAMETER:
-            std::cout << "parameter ";
-            break;
+            if (isUnused(sym))
+                std::cout << "Line " << sym.declarationLine << ": " << kindName(sym.kind) << " '" << sym.name
+                    << "' is never used\n";
         }
-        std::cout << "'" << name << "' is never used\n";
     }
-}
 
+    if (!m_TrackLines)
+        return;
 
+    // what is used once could as well be written where it is used
+    std::vector<int> onlyUse(m_Symbols.size(), 0);
+    forEachUse([&](uint32_t id, int line)
+    {
+        if (m_Symbols[id].uses == 1)
+            onlyUse[id] = line;
+    });
+    bool header{false};
+    for (std::size_t id{0}; id < m_Symbols.size(); ++id)
+    {
+        const Symbol& sym{m_Symbols[id]};
+        if (!sym.isDeclared || sym.uses != 1)
+            continue;
+        if (!header)
+            std::cout << "Used once:\n";
+        header = true;
+        std::cout << "Line " << sym.declarationLine << ": " << kindName(sym.kind) << " '" << sym.name
+            << "' only on line " << onlyUse[id] << '\n';
+    }
+}
@@ -0,0 +1,267 @@
+#include "TextScan.hpp"
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define TEXTSCAN_X86 1
+#include <immintrin.h>
+#endif
+
+namespace
+{
+inline bool isBlank(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+const char* skipBlanksScalar(const char* p, const char* end, int& lines)
+{
+    while (p < end && isBlank(*p))
+    {
+        if (*p == '\n')
+            lines++;
+        p++;
+    }
+    return p;
+}
+
+const char* findNewlineScalar(const char* p, const char* end)
+{
+    while (p < end && *p != '\n')
+        p++;
+    return p;
+}
+
+const char* findBlockCommentEndScalar(const char* p, const char* end, int& lines)
+{
+    while (p < end && !(*p == '*' && p + 1 < end && p[1] == '/'))
+    {
+        if (*p == '\n')
+            lines++;
+        p++;
+    }
+    return p;
+}
+
+#ifdef TEXTSCAN_X86
+// newlines in the bits of mask below position
+inline int newlinesBefore(unsigned mask, unsigned position)
+{
+    return __builtin_popcount(mask & ((1u << position) - 1u));
+}
+
+const char* skipBlanksSse2(const char* p, const char* end, int& lines)
+{
+    const __m128i space{_mm_set1_epi8(' ')};
+    const __m128i tab{_mm_set1_epi8('\t')};
+    const __m128i cr{_mm_set1_epi8('\r')};
+    const __m128i nl{_mm_set1_epi8('\n')};
+
+    while (end - p >= 16)
+    {
+        __m128i v{_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))};
+        __m128i isNewline{_mm_cmpeq_epi8(v, nl)};
+        __m128i blank{_mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, space), _mm_cmpeq_epi8(v, tab)),
+                                   _mm_or_si128(_mm_cmpeq_epi8(v, cr), isNewline))};
+
+        unsigned blankMask{static_cast<unsigned>(_mm_movemask_epi8(blank))};
+        unsigned newlineMask{static_cast<unsigned>(_mm_movemask_epi8(isNewline))};
+        if (blankMask != 0xFFFFu)
+        {
+            unsigned stop{static_cast<unsigned>(__builtin_ctz(~blankMask))};
+            lines += newlinesBefore(newlineMask, stop);
+            return p + stop;
+        }
+        lines += __builtin_popcount(newlineMask);
+        p += 16;
+    }
+    return skipBlanksScalar(p, end, lines);
+}
+
+const char* findNewlineSse2(const char* p, const char* end)
+{
+    const __m128i nl{_mm_set1_epi8('\n')};
+
+    while (end - p >= 16)
+    {
+        __m128i v{_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))};
+        unsigned mask{static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, nl)))};
+        if (mask)
+            return p + __builtin_ctz(mask);
+        p += 16;
+    }
+    return findNewlineScalar(p, end);
+}
+
+const char* findBlockCommentEndSse2(const char* p, const char* end, int& lines)
+{
+    const __m128i star{_mm_set1_epi8('*')};
+    const __m128i slash{_mm_set1_epi8('/')};
+    const __m128i nl{_mm_set1_epi8('\n')};
+
+    // second load is one byte ahead so a "*/" straddling two blocks is still seen
+    while (end - p >= 17)
+    {
+        __m128i v{_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))};
+        __m128i next{_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 1))};
+
+        unsigned closeMask{static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, star)) &
+            _mm_movemask_epi8(_mm_cmpeq_epi8(next, slash)))};
+        unsigned newlineMask{static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, nl)))};
+        if (closeMask)
+        {
+            unsigned stop{static_cast<unsigned>(__builtin_ctz(closeMask))};
+            lines += newlinesBefore(newlineMask, stop);
+            return p + stop;
+        }
+        lines += __builtin_popcount(newlineMask);
+        p += 16;
+    }
+    return findBlockCommentEndScalar(p, end, lines);
+}
+
+__attribute__((target("avx2"))) const char* skipBlanksAvx2(const char* p, const char* end, int& lines)
+{
+    const __m256i space{_mm256_set1_epi8(' ')};
+    const __m256i tab{_mm256_set1_epi8('\t')};
+    const __m256i cr{_mm256_set1_epi8('\r')};
+    const __m256i nl{_mm256_set1_epi8('\n')};
+
+    while (end - p >= 32)
+    {
+        __m256i v{_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p))};
+        __m256i isNewline{_mm256_cmpeq_epi8(v, nl)};
+        __m256i blank{_mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, space), _mm256_cmpeq_epi8(v, tab)),
+                                      _mm256_or_si256(_mm256_cmpeq_epi8(v, cr), isNewline))};
+
+        unsigned blankMask{static_cast<unsigned>(_mm256_movemask_epi8(blank))};
+        unsigned newlineMask{static_cast<unsigned>(_mm256_movemask_epi8(isNewline))};
+        if (blankMask != 0xFFFFFFFFu)
+        {
+            unsigned stop{static_cast<unsigned>(__builtin_ctz(~blankMask))};
+            lines += newlinesBefore(newlineMask, stop);
+            return p + stop;
+        }
+        lines += __builtin_popcount(newlineMask);
+        p += 32;
+    }
+    return skipBlanksSse2(p, end, lines);
+}
+
+__attribute__((target("avx2"))) const char* findNewlineAvx2(const char* p, const char* end)
+{
+    const __m256i nl{_mm256_set1_epi8('\n')};
+
+    while (end - p >= 32)
+    {
+        __m256i v{_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p))};
+        unsigned mask{static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, nl)))};
+        if (mask)
+            return p + __builtin_ctz(mask);
+        p += 32;
+    }
+    return findNewlineSse2(p, end);
+}
+
+__attribute__((target("avx2"))) const char* findBlockCommentEndAvx2(const char* p, const char* end, int& lines)
+{
+    const __m256i star{_mm256_set1_epi8('*')};
+    const __m256i slash{_mm256_set1_epi8('/')};
+    const __m256i nl{_mm256_set1_epi8('\n')};
+
+    while (end - p >= 33)
+    {
+        __m256i v{_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p))};
+        __m256i next{_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 1))};
+
+        unsigned closeMask{static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, star)) &
+            _mm256_movemask_epi8(_mm256_cmpeq_epi8(next, slash)))};
+        unsigned newlineMask{static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, nl)))};
+        if (closeMask)
+        {
+            unsigned stop{static_cast<unsigned>(__builtin_ctz(closeMask))};
+            lines += newlinesBefore(newlineMask, stop);
+            return p + stop;
+        }
+        lines += __builtin_popcount(newlineMask);
+        p += 32;
+    }
+    return findBlockCommentEndSse2(p, end, lines);
+}
+#endif
+
+struct TextScanFunctions
+{
+    SimdLevel level;
+    const char* (*skipBlanks)(const char*, const char*, int&);
+    const char* (*findNewline)(const char*, const char*);
+    const char* (*findBlockCommentEnd)(const char*, const char*, int&);
+};
+
+TextScanFunctions functionsFor(SimdLevel level)
+{
+#ifdef TEXTSCAN_X86
+    if (level == SimdLevel::AVX2)
+        return {level, skipBlanksAvx2, findNewlineAvx2, findBlockCommentEndAvx2};
+    if (level == SimdLevel::SSE2)
+        return {level, skipBlanksSse2, findNewlineSse2, findBlockCommentEndSse2};
+#endif
+    return {SimdLevel::SCALAR, skipBlanksScalar, findNewlineScalar, findBlockCommentEndScalar};
+}
+
+TextScanFunctions& activeFunctions()
+{
+    static TextScanFunctions functions{functionsFor(detectSimdLevel())};
+    return functions;
+}
+}
+
+SimdLevel detectSimdLevel()
+{
+#ifdef TEXTSCAN_X86
+    if (__builtin_cpu_supports("avx2"))
+        return SimdLevel::AVX2;
+    return SimdLevel::SSE2; // always there on x86-64
+#else
+    return SimdLevel::SCALAR;
+#endif
+}
+
+SimdLevel getSimdLevel()
+{
+    return activeFunctions().level;
+}
+
+void setSimdLevel(SimdLevel level)
+{
+    if (static_cast<int>(level) > static_cast<int>(detectSimdLevel()))
+        level = detectSimdLevel();
+    activeFunctions() = functionsFor(level);
+}
+
+const char* simdLevelName(SimdLevel level)
+{
+    switch (level)
+    {
+    case SimdLevel::AVX2:
+        return "AVX2";
+    case SimdLevel::SSE2:
+        return "SSE2";
+    case SimdLevel::SCALAR:
+        return "scalar";
+    }
+    return "unknown";
+}
+
+const char* skipBlanks(const char* p, const char* end, int& lines)
+{
+    return activeFunctions().skipBlanks(p, end, lines);
+}
+
+const char* findNewline(const char* p, const char* end)
+{
+    return activeFunctions().findNewline(p, end);
+}
+
+const char* findBlockCommentEnd(const char* p, const char* end, int& lines)
+{
+    return activeFunctions().findBlockCommentEnd(p, end, lines);
+}
@@ -0,0 +1,130 @@
+#include "TokenBuffer.hpp"
+
+#include <algorithm>
+
+TokenBuffer::TokenBuffer(std::string_view source)
+    : m_Source{source}
+{
+}
+
+TokenBuffer::TokenBuffer(const std::vector<Token>& tokens)
+    : m_OwnsSource{true}
+{
+    std::size_t total{0};
+    for (const Token& token : tokens)
+        total += token.lexeme.length();
+
+    m_OwnedSource.reserve(total);
+    reserve(tokens.size());
+
+    // the lexeme goes in first, push interns identifiers from the source
+    for (const Token& token : tokens)
+    {
+        uint32_t offset{static_cast<uint32_t>(m_OwnedSource.length())};
+        m_OwnedSource += token.lexeme;
+        push(token.type, offset, static_cast<uint32_t>(token.lexeme.length()), token.line);
+    }
+}
+
+void TokenBuffer::reserve(std::size_t count)
+{
+    m_Types.reserve(count);
+    m_Offsets.reserve(count);
+    m_Lengths.reserve(count);
+    m_Lines.reserve(count);
+    m_Ids.reserve(count);
+}
+
+void TokenBuffer::resize(std::size_t count)
+{
+    m_Types.resize(count);
+    m_Offsets.resize(count);
+    m_Lengths.resize(count);
+    m_Lines.resize(count);
+    m_Ids.resize(count);
+}
+
+void TokenBuffer::append(const TokenBuffer& other, std::size_t begin, std::size_t end)
+{
+    m_Types.insert(m_Types.end(), other.m_Types.begin() + begin, other.m_Types.begin() + end);
+    m_Offsets.insert(m_Offsets.end(), other.m_Offsets.begin() + begin, other.m_Offsets.begin() + end);
+    m_Lengths.insert(m_Lengths.end(), other.m_Lengths.begin() + begin, other.m_Lengths.begin() + end);
+    m_Lines.insert(m_Lines.end(), other.m_Lines.begin() + begin, other.m_Lines.begin() + end);
+    m_Ids.insert(m_Ids.end(), other.m_Ids.begin() + begin, other.m_Ids.begin() + end);
+    if (m_Identifiers.size() == 0)
+        m_Identifiers = other.m_Identifiers;
+}
+
+void TokenBuffer::compact(const std::vector<char>& keep)
+{
+    std::size_t kept{0};
+    for (std::size_t i{0}; i < size(); ++i)
+    {
+        if (!keep[i])
+            continue;
+        m_Types[kept] = m_Types[i];
+        m_Offsets[kept] = m_Offsets[i];
+        m_Lengths[kept] = m_Lengths[i];
+        m_Lines[kept] = m_Lines[i];
+        m_Ids[kept] = m_Ids[i];
+        ++kept;
+    }
+    resize(kept);
+}
+
+std::vector<uint32_t> TokenBuffer::mergeIdentifiers(const TokenBuffer& other)
+{
+    std::vector<uint32_t> idMap(other.identifierCount());
+    std::string_view otherSource{other.source()};
+    for (uint32_t id{0}; id < idMap.size(); ++id)
+    {
+        std::string_view name{other.m_Identifiers.name(otherSource, id)};
+        idMap[id] = m_Identifiers.intern(source(), static_cast<uint32_t>(name.data() - source().data()),
+                                         static_cast<uint32_t>(name.length()));
+    }
+    return idMap;
+}
+
+void TokenBuffer::copyFrom(const TokenBuffer& other, std::size_t at, int lineOffset,
+                           const std::vector<uint32_t>& idMap)
+{
+    std::copy(other.m_Types.begin(), other.m_Types.end(), m_Types.begin() + at);
+    std::copy(other.m_Offsets.begin(), other.m_Offsets.end(), m_Offsets.begin() + at);
+    std::copy(other.m_Lengths.begin(), other.m_Lengths.end(), m_Lengths.begin() + at);
+    for (std::size_t i{0}; i < other.size(); ++i)
+        m_Lines[at + i] = other.m_Lines[i] + lineOffset;
+    for (std::size_t i{0}; i < other.size(); ++i)
+        m_Ids[at + i] = other.m_Ids[i] == IdentifierTable::NO_ID ? IdentifierTable::NO_ID : idMap[other.m_Ids[i]];
+}
+
+void TokenBuffer::clear()
+{
+    m_Types.clear();
+    m_Offsets.clear();
+    m_Lengths.clear();
+    m_Lines.clear();
+    m_Ids.clear();
+    m_Identifiers.clear();
+}
+
+void TokenBuffer::reset(std::string_view source)
+{
+    clear();
+    m_Source = source;
+    m_OwnedSource.clear();
+    m_OwnsSource = false;
+}
+
+Token TokenBuffer::token(std::size_t i) const
+{
+    return Token{m_Types[i], lexeme(i), m_Lines[i]};
+}
+
+std::vector<Token> TokenBuffer::toTokens() const
+{
+    std::vector<Token> tokens;
+    tokens.reserve(size());
+    for (std::size_t i{0}; i < size(); ++i)
+        tokens.push_back(token(i));
+    return tokens;
+}
@@ -0,0 +1,540 @@
+// differential test of the table-driven lexer against a straightforward per-character scanner, over the shaders on
+// the command line and a generated corpus
+// every scanner (Scanner, StreamScanner at several chunk sizes, ParallelScanner) has to give the reference's tokens,
+// and minified output has to scan back to the tokens it was made from
+// minify --stream output of the shaders on the command line also has to bind names as the batch path does, and
+// minify has to scope locals as GLSL does
+//
+// lexer_differential_test [--seed N] [--files N] [shader.glsl...]
+#include "CharClass.hpp"
+#include "IncrementalMinifier.hpp"
+#include "Keywords.hpp"
+#include "Minifier.hpp"
+#include "MinifyResult.hpp"
+#include "ParallelScanner.hpp"
+#include "Scanner.hpp"
+#include "StreamScanner.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+struct ReferenceToken
+{
+    TokenType type;
+    std::size_t offset;
+    std::size_t length;
+    int line;
+};
+
+// the scanner as it was before the lexer tables, one switch over the first character and <cctype> for the rest,
+// with the literal forms added since (0x1F, 7u, 1.5lf, 1., .5, 1e)
+class ReferenceScanner
+{
+private:
+    std::string_view m_Source;
+    std::size_t m_Start{0};
+    std::size_t m_Current{0};
+    int m_Line{1};
+    std::vector<ReferenceToken> m_Tokens;
+
+    inline bool isAtEnd() const { return m_Current >= m_Source.length(); }
+    inline char peek(std::size_t ahead = 0) const
+    {
+        return m_Current + ahead < m_Source.length() ? m_Source[m_Current + ahead] : '\0';
+    }
+    static bool isDigit(char c) { return std::isdigit(static_cast<unsigned char>(c)) != 0; }
+    static bool isHexDigit(char c) { return std::isxdigit(static_cast<unsigned char>(c)) != 0; }
+
+    bool match(char expected)
+    {
+        if (peek() != expected || isAtEnd())
+            return false;
+        ++m_Current;
+        return true;
+    }
+
+    void addToken(TokenType type)
+    {
+        m_Tokens.push_back({type, m_Start, m_Current - m_Start, m_Line});
+    }
+
+    void skipWhitespace()
+    {
+        while (!isAtEnd())
+        {
+            char c{peek()};
+            if (c == ' ' || c == '\r' || c == '\t')
+                ++m_Current;
+            else if (c == '\n')
+            {
+                ++m_Line;
+                ++m_Current;
+            }
+            else if (c == '/' && peek(1) == '/')
+            {
+                while (!isAtEnd() && peek() != '\n')
+                    ++m_Current;
+            }
+            else if (c == '/' && peek(1) == '*')
+            {
+                m_Current += 2;
+                while (!isAtEnd() && !(peek() == '*' && peek(1) == '/'))
+                {
+                    if (peek() == '\n')
+                        ++m_Line;
+                    ++m_Current;
+                }
+                if (!isAtEnd())
+                    m_Current += 2;
+            }
+            else
+                break;
+        }
+    }
+
+    // m_Current is on the first digit, or on a '.' before one
+    void number()
+    {
+        if (peek() == '0' && (peek(1) == 'x' || peek(1) == 'X') && isHexDigit(peek(2)))
+        {
+            m_Current += 2;
+            while (isHexDigit(peek()))
+                ++m_Current;
+            match('u') || match('U');
+            addToken(TokenType::NUMBER);
+            return;
+        }
+
+        while (isDigit(peek()))
+            ++m_Current;
+
+        bool fraction{false};
+        if (match('.'))
+        {
+            fraction = true;
+            while (isDigit(peek()))
+                ++m_Current;
+        }
+
+        // the exponent letter and sign are part of the number even without digits
+        bool exponent{false};
+        bool exponentDigits{false};
+        if (match('e') || match('E'))
+        {
+            exponent = true;
+            match('+') || match('-');
+            exponentDigits = isDigit(peek());
+            while (isDigit(peek()))
+                ++m_Current;
+        }
+
+        // one suffix at most, u only on integers and lf only after a fraction or exponent digits
+        bool suffix{match('f') || match('F')};
+        if (!suffix && !fraction && !exponent)
+            match('u') || match('U');
+        else if (!suffix && ((fraction && !exponent) || exponentDigits) &&
+            ((peek() == 'l' && peek(1) == 'f') || (peek() == 'L' && peek(1) == 'F')))
+            m_Current += 2;
+
+        addToken(TokenType::NUMBER);
+    }
+
+    void identifier()
+    {
+        while (std::isalnum(static_cast<unsigned char>(peek())) || peek() == '_')
+            ++m_Current;
+        addToken(lookupKeyword(m_Source.substr(m_Start, m_Current - m_Start)));
+    }
+
+    void scanToken()
+    {
+        char c{peek()};
+        if (isDigit(c) || (c == '.' && isDigit(peek(1))))
+        {
+            number();
+            return;
+        }
+
+        ++m_Current;
+        switch (c)
+        {
+        case '(': addToken(TokenType::LEFT_PAREN); break;
+        case ')': addToken(TokenType::RIGHT_PAREN); break;
+        case '{': addToken(TokenType::LEFT_BRACE); break;
+        case '}': addToken(TokenType::RIGHT_BRACE); break;
+        case '[': addToken(TokenType::LEFT_BRACKET); break;
+        case ']': addToken(TokenType::RIGHT_BRACKET); break;
+        case ';': addToken(TokenType::SEMICOLON); break;
+        case ',': addToken(TokenType::COMMA); break;
+        case '.': addToken(TokenType::DOT); break;
+        case '?': addToken(TokenType::QUESTION); break;
+        case ':': addToken(TokenType::COLON); break;
+        case '~': addToken(TokenType::TILDE); break;
+        case '^': addToken(TokenType::CARET); break;
+        case '%': addToken(TokenType::PERCENT); break;
+        case '+':
+            addToken(match('+') ? TokenType::PLUS_PLUS : match('=') ? TokenType::PLUS_EQUAL : TokenType::PLUS);
+            break;
+        case '-':
+            addToken(match('-') ? TokenType::MINUS_MINUS : match('=') ? TokenType::MINUS_EQUAL : TokenType::MINUS);
+            break;
+        case '*': addToken(match('=') ? TokenType::STAR_EQUAL : TokenType::STAR); break;
+        case '/': addToken(match('=') ? TokenType::SLASH_EQUAL : TokenType::SLASH); break;
+        case '!': addToken(match('=') ? TokenType::BANG_EQUAL : TokenType::BANG); break;
+        case '=': addToken(match('=') ? TokenType::EQUAL_EQUAL : TokenType::EQUAL); break;
+        case '<':
+            addToken(match('<') ? TokenType::LESS_LESS : match('=') ? TokenType::LESS_EQUAL : TokenType::LESS);
+            break;
+        case '>':
+            addToken(match('>') ? TokenType::GREATER_GREATER
+                         : match('=') ? TokenType::GREATER_EQUAL
+                         : TokenType::GREATER);
+            break;
+        case '&': addToken(match('&') ? TokenType::AMPERSAND_AMPERSAND : TokenType::AMPERSAND); break;
+        case '|': addToken(match('|') ? TokenType::PIPE_PIPE : TokenType::PIPE); break;
+        case '#':
+            while (!isAtEnd() && peek() != '\n')
+                ++m_Current;
+            addToken(TokenType::PREPROCESSOR);
+            break;
+        default:
+            if (std::isalpha(static_cast<unsigned char>(c)) || c == '_')
+                identifier();
+            // anything else is an error, reported and dropped
+            break;
+        }
+    }
+
+public:
+    explicit ReferenceScanner(std::string_view source) : m_Source{source} {}
+
+    std::vector<ReferenceToken> scan()
+    {
+        while (!isAtEnd())
+        {
+            skipWhitespace();
+            if (isAtEnd())
+                break;
+            m_Start = m_Current;
+            scanToken();
+        }
+        m_Tokens.push_back({TokenType::END_OF_FILE, m_Source.length(), 0, m_Line});
+        return std::move(m_Tokens);
+    }
+};
+
+std::string describe(std::string_view lexeme, int line)
+{
+    std::ostringstream text;
+    text << '\'' << lexeme.substr(0, 40) << "' on line " << line;
+    return text.str();
+}
+
+// counts the failed checks, prints the first mismatch of each
+class Checker
+{
+private:
+    int m_Checks{0};
+    int m_Failures{0};
+
+public:
+    void check(bool passed, const std::string& name, const std::string& what, std::size_t at, const std::string& detail)
+    {
+        ++m_Checks;
+        if (passed)
+            return;
+        ++m_Failures;
+        std::cerr << "FAIL " << name << ": " << what << " at token " << at << ", " << detail << '\n';
+    }
+
+    inline int getChecks() const { return m_Checks; }
+    inline int getFailures() const { return m_Failures; }
+};
+
+void compareBuffer(Checker& checker, const std::string& name, const std::string& what, std::string_view source,
+                   const std::vector<ReferenceToken>& expected, const TokenBuffer& tokens)
+{
+    std::size_t count{std::min(expected.size(), tokens.size())};
+    for (std::size_t i{0}; i < count; ++i)
+    {
+        const ReferenceToken& e{expected[i]};
+        bool same{e.type == tokens.type(i) && e.offset == tokens.offset(i) && e.length == tokens.length(i) &&
+            e.line == tokens.line(i)};
+        if (!same)
+        {
+            checker.check(false, name, what, i, "expected " + describe(source.substr(e.offset, e.length), e.line) +
+                          ", got " + describe(tokens.lexeme(i), tokens.line(i)));
+            return;
+        }
+    }
+    checker.check(expected.size() == tokens.size(), name, what, count,
+                  std::to_string(expected.size()) + " tokens expected, got " + std::to_string(tokens.size()));
+}
+
+void compareStream(Checker& checker, const std::string& name, std::string_view source,
+                   const std::vector<ReferenceToken>& expected, std::size_t chunkSize)
+{
+    std::istringstream input{std::string{source}};
+    StreamScanner scanner{input, nullptr, chunkSize};
+    std::string what{"StreamScanner with " + std::to_string(chunkSize) + " byte chunks"};
+
+    for (std::size_t i{0}; i < expected.size(); ++i)
+    {
+        const ReferenceToken& e{expected[i]};
+        StreamToken token{scanner.nextToken()};
+        std::string_view lexeme{source.substr(e.offset, e.length)};
+        if (token.type != e.type || token.lexeme != lexeme || token.line != e.line)
+        {
+            checker.check(false, name, what, i, "expected " + describe(lexeme, e.line) + ", got " +
+                          describe(token.lexeme, token.line));
+            return;
+        }
+    }
+    checker.check(true, name, what, expected.size(), {});
+}
+
+// the output scans to the same tokens, identifiers may be renamed and numbers respelled, # lines are not compared
+void compareOutput(Checker& checker, const std::string& name, const std::string& what, std::string_view source,
+                   const std::vector<ReferenceToken>& expected, const std::string& output)
+{
+    TokenBuffer tokens{Scanner{output}.scan()};
+    std::size_t count{std::min(expected.size(), tokens.size())};
+    for (std::size_t i{0}; i < count; ++i)
+    {
+        const ReferenceToken& e{expected[i]};
+        TokenType type{tokens.type(i)};
+        std::string_view lexeme{source.substr(e.offset, e.length)};
+        bool loose{type == TokenType::IDENTIFIER || type == TokenType::NUMBER || type == TokenType::PREPROCESSOR};
+        if (type != e.type || (!loose && tokens.lexeme(i) != lexeme))
+        {
+            checker.check(false, name, what, i, "expected " + describe(lexeme, e.line) + ", got " +
+                          describe(tokens.lexeme(i), tokens.line(i)) + " of the output");
+            return;
+        }
+    }
+    checker.check(expected.size() == tokens.size(), name, what, count,
+                  std::to_string(expected.size()) + " tokens expected, got " + std::to_string(tokens.size()));
+}
+
+// minify --stream binds names as the batch path does: the identifiers one name of the batch output stands for get
+// one name in the stream output too, so no use is renamed apart from its declaration, and every name of the stream
+// output stands for one source name. the stream output renames by name, not by scope, it may rename more
+void compareBindings(Checker& checker, const std::string& name, std::string_view shader)
+{
+    // every name gets a '_' no short name ends in, so a name given out is never taken for one kept
+    std::string source;
+    {
+        TokenBuffer tokens{Scanner{shader}.scan()};
+        std::size_t copied{0};
+        for (std::size_t i{0}; i < tokens.size(); ++i)
+        {
+            std::string_view lexeme{tokens.lexeme(i)};
+            if (tokens.type(i) != TokenType::IDENTIFIER || (i > 0 && tokens.type(i - 1) == TokenType::DOT) ||
+                lexeme == "main" || Minifier::isBuiltin(lexeme))
+                continue;
+            source.append(shader.substr(copied, tokens.offset(i) + lexeme.length() - copied));
+            source += '_';
+            copied = tokens.offset(i) + lexeme.length();
+        }
+        source.append(shader.substr(copied));
+    }
+
+    TokenBuffer original{Scanner{source}.scan()};
+    MinifyResult result{minifyShader(source)};
+    TokenBuffer batch{Scanner{result.getOutput()}.scan()};
+    std::istringstream input{std::string{source}};
+    StreamScanner scanner{input};
+    std::ostringstream streamed;
+    Minifier::minifyStream(scanner, streamed, true);
+    std::string streamOutput{streamed.str()}; // the lexemes point into it
+    TokenBuffer stream{Scanner{streamOutput}.scan()};
+
+    std::string what{"minify --stream bindings"};
+    if (batch.size() != original.size() || stream.size() != original.size())
+    {
+        checker.check(false, name, what, 0, "the outputs do not scan to the tokens of the source");
+        return;
+    }
+
+    std::unordered_map<std::string, std::string_view> streamOf; // by source name and name in the batch output
+    std::unordered_map<std::string_view, std::string_view> sourceOf; // by name in the stream output
+    for (std::size_t i{0}; i < original.size(); ++i)
+    {
+        // members and swizzles go out as they are
+        if (original.type(i) != TokenType::IDENTIFIER || (i > 0 && original.type(i - 1) == TokenType::DOT))
+            continue;
+        std::string_view lexeme{original.lexeme(i)};
+        std::string binding{lexeme};
+        binding += ' ';
+        binding += batch.lexeme(i);
+
+        auto [bound, first]{streamOf.try_emplace(binding, stream.lexeme(i))};
+        if (!first && bound->second != stream.lexeme(i))
+        {
+            checker.check(false, name, what, i, describe(lexeme, original.line(i)) + " goes out as '" +
+                          std::string{stream.lexeme(i)} + "' of the stream output, before as '" +
+                          std::string{bound->second} + "'");
+            return;
+        }
+
+        auto [it, inserted]{sourceOf.try_emplace(stream.lexeme(i), lexeme)};
+        if (!inserted && it->second != lexeme)
+        {
+            checker.check(false, name, what, i, "'" + std::string{stream.lexeme(i)} + "' of the stream output stands "
+                          "for both '" + std::string{it->second} + "' and " + describe(lexeme, original.line(i)));
+            return;
+        }
+    }
+    checker.check(true, name, what, original.size(), {});
+}
+
+void testSource(Checker& checker, const std::string& name, std::string_view source)
+{
+    std::vector<ReferenceToken> expected{ReferenceScanner{source}.scan()};
+
+    compareBuffer(checker, name, "Scanner", source, expected, Scanner{source}.scan());
+    for (std::size_t chunkSize : {4, 7, 64, 4096})
+        compareStream(checker, name, source, expected, chunkSize);
+    compareBuffer(checker, name, "ParallelScanner", source, expected, ParallelScanner{source, 4}.scan());
+
+    // the output never has comments, so it scans without errors whenever the source did
+    MinifyResult result{minifyShader(source)};
+    compareOutput(checker, name, "minify", source, expected, result.getOutput());
+
+    std::istringstream input{std::string{source}};
+    StreamScanner scanner{input};
+    std::ostringstream streamed;
+    Minifier::minifyStream(scanner, streamed, true);
+    compareOutput(checker, name, "minify --stream", source, expected, streamed.str());
+
+    IncrementalMinifier incremental;
+    compareOutput(checker, name, "minify --watch", source, expected, incremental.update(source));
+}
+
+// token soup with every operator, literal form and comment kind, glued together with and without blanks
+// literals stay valid GLSL, an exponent without digits ("1e" from "1" and "e") would not survive minification
+std::string generateSource(std::mt19937& random, std::size_t fragments)
+{
+    static constexpr std::string_view FRAGMENTS[]{
+        "a", "_b1", "x9", "__z", "e", "E", "main", "gl_FragColor", "vec3", "float", "uint", "mat2x3", "sampler2D",
+        "samplerCube", "uniform", "highp", "const", "struct", "if", "else", "return", "for", "layout", "true",
+        "1", "0", "007", "12.5", "1.", ".5", "3e4", "1.5e-3", "1.e5", "2.0f", "7u", "3U", "0x1F",
+        "0XffU", "0x", "0xg", "1.5lf", "2e3LF", "2.0Lf", "1lf", "0.5u",
+        "(", ")", "{", "}", "[", "]", ";", ",", ".", "..", "+", "++", "+=", "-", "--", "-=", "*", "*=", "/", "/=", "%",
+        "!", "!=", "=", "==", "<", "<<", "<=", ">", ">>", ">=", "&", "&&", "|", "||", "^", "~", "?", ":",
+        "#define X 1\n", "#version 330\r\n", "// line comment\n", "/* block\ncomment */", "/**/", "/*/ */",
+        " ", " ", " ", "\n", "\t", "\r\n", "@", "$", "\\", "\x80"
+    };
+    std::uniform_int_distribution<std::size_t> pick{0, std::size(FRAGMENTS) - 1};
+
+    std::string source;
+    for (std::size_t i{0}; i < fragments; ++i)
+    {
+        std::string_view fragment{FRAGMENTS[pick(random)]};
+        if (!source.empty() && (isDigitChar(source.back()) || source.back() == '.') &&
+            (fragment[0] == 'e' || fragment[0] == 'E'))
+            source += ' ';
+        source += fragment;
+    }
+    return source;
+}
+
+// declarations next to uses of the same name after a type, which minify --stream once took for declarations
+constexpr std::string_view BINDING_SHADERS[]{
+    "void main(){float s=0.0,t=1.0;gl_FragColor=vec4(t);gl_FragColor.x+=t+s;}",
+    "struct Light{vec3 col;float k;};uniform Light u;\n"
+    "void main(){Light lt=u;float w[2];w[0]=lt.k;gl_FragColor=vec4(vec3(lt.col)*w[0],float(w[0]));}",
+    "float f(float x,vec2 y){return x*y.x;}void main(){vec2 p=vec2(1.0);gl_FragColor=vec4(f(p.x,vec2(p)));}"
+};
+
+// a local is visible from the end of its declarator, its initializer still reads the name around it
+struct ScopeCase
+{
+    std::string_view source;
+    std::string_view expected;
+};
+
+constexpr ScopeCase SCOPE_SHADERS[]{
+    {"const float scale=3.;float f(float x){return x*scale;}\n"
+     "void main(){float y=f(1.0);float scale=scale*2.0;gl_FragColor=vec4(y*scale);}",
+     "const float a=3.;float b(float c){return c*a;}void main(){float c=b(1.);float d=a*2.;gl_FragColor=vec4(c*d);}"},
+    {"float k=1.;void main(){float k=k+1.,j=k;for(int k=int(k);k<2;++k)j+=float(k);gl_FragColor=vec4(j);}",
+     "float a=1.;void main(){float c=a+1.,j=c;for(int b=int(c);b<2;++b)j+=float(b);gl_FragColor=vec4(j);}"}
+};
+
+void compareScopes(Checker& checker)
+{
+    for (std::size_t i{0}; i < std::size(SCOPE_SHADERS); ++i)
+    {
+        std::string output{minifyShader(SCOPE_SHADERS[i].source).getOutput()};
+        checker.check(output == SCOPE_SHADERS[i].expected, "scope shader " + std::to_string(i), "minify", 0,
+                      "expected " + std::string{SCOPE_SHADERS[i].expected} + ", got " + output);
+    }
+}
+
+bool readFile(const std::string& path, std::string& contents)
+{
+    std::ifstream file{path, std::ios::binary};
+    if (!file.is_open())
+        return false;
+    std::ostringstream text;
+    text << file.rdbuf();
+    contents = text.str();
+    return true;
+}
+}
+
+int main(int argc, char* argv[])
+{
+    uint32_t seed{7};
+    int files{20};
+    std::vector<std::string> paths;
+    for (int i{1}; i < argc; ++i)
+    {
+        std::string arg{argv[i]};
+        if (arg == "--seed" && i + 1 < argc)
+            seed = static_cast<uint32_t>(std::stoul(argv[++i]));
+        else if (arg == "--files" && i + 1 < argc)
+            files = std::stoi(argv[++i]);
+        else
+            paths.push_back(arg);
+    }
+
+    Checker checker;
+    for (const std::string& path : paths)
+    {
+        std::string source;
+        if (!readFile(path, source))
+        {
+            std::cerr << "Error: Could not open file " << path << '\n';
+            return 1;
+        }
+        testSource(checker, path, source);
+        compareBindings(checker, path, source);
+    }
+    for (std::size_t i{0}; i < std::size(BINDING_SHADERS); ++i)
+        compareBindings(checker, "binding shader " + std::to_string(i), BINDING_SHADERS[i]);
+    compareScopes(checker);
+
+    // the last file is big enough for ParallelScanner to split it
+    std::mt19937 random{seed};
+    for (int i{0}; i < files; ++i)
+    {
+        std::size_t fragments{i + 1 == files ? 4 * ParallelScanner::MIN_CHUNK_SIZE / 3 : 20000};
+        testSource(checker, "generated " + std::to_string(i) + " (seed " + std::to_string(seed) + ")",
+                   generateSource(random, fragments));
+    }
+
+    std::cout << checker.getChecks() - checker.getFailures() << " of " << checker.getChecks() << " checks passed\n";
+    return checker.getFailures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,32 @@
+# runs glsl_minifier variants on tests/variants with and without --remove-dead-code and checks that every output
+# still defines what its #define lines name: the macro's function keeps its name and is not dropped
+#
+# cmake -DMINIFIER=<glsl_minifier> -DSOURCE_DIR=<tests/variants> -DOUTPUT_DIR=<dir> -P VariantsTest.cmake
+
+function(check_variant file define function)
+    file(READ ${file} text)
+    if (NOT text MATCHES "#define SHADE ${define}\n")
+        message(FATAL_ERROR "${file}: no '#define SHADE ${define}' line\n${text}")
+    endif ()
+    if (NOT text MATCHES "float ${function}\\(float [A-Za-z_]+\\)")
+        message(FATAL_ERROR "${file}: ${function} is renamed or dropped\n${text}")
+    endif ()
+    if (text MATCHES "float (shadeA|shadeB)[=;]")
+        message(FATAL_ERROR "${file}: a local took the name of a function a macro calls\n${text}")
+    endif ()
+endfunction()
+
+foreach (flags "" "--remove-dead-code")
+    file(REMOVE_RECURSE ${OUTPUT_DIR})
+    execute_process(COMMAND ${MINIFIER} variants ${SOURCE_DIR}/shade.glsl ${SOURCE_DIR}/defines.txt ${OUTPUT_DIR}
+                    ${flags}
+                    RESULT_VARIABLE result OUTPUT_VARIABLE output ERROR_VARIABLE output)
+    if (NOT result EQUAL 0)
+        message(FATAL_ERROR "variants ${flags} failed\n${output}")
+    endif ()
+
+    check_variant(${OUTPUT_DIR}/variant_0.glsl shadeA shadeA)
+    check_variant(${OUTPUT_DIR}/variant_1.glsl shadeB shadeB)
+    check_variant(${OUTPUT_DIR}/variant_2.glsl shadeA shadeA)
+    message(STATUS "variants ${flags}: passed")
+endforeach ()
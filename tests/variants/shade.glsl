@@ -0,0 +1,16 @@
+#version 330
+out vec4 color;
+
+// only reached through the SHADE macro a variant defines
+float shadeA(float x) { return x * 2.0; }
+float shadeB(float x) { return x * 3.0; }
+
+void main()
+{
+    float v = 0.5;
+#ifdef USE_FN
+    v = SHADE(v);
+#endif
+    float level = v * float(QUALITY);
+    color = vec4(level);
+}